@@ -0,0 +1,39 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Common.h"
+#include <functional>
+
+NAMESPACES( ENGINE_NAMESPACE, Core )
+
+/*
+ * Worker threads shared by the engine, one less than the hardware threads since the calling thread works as well.
+ * Tasks must not call run themselves, a worker waiting for other tasks could wait for itself.
+ */
+class TaskPool
+{
+public:
+    // Runs task( 0 ) to task( taskCount - 1 ), task 0 on the calling thread. Returns once every task is done,
+    // the first exception thrown by a task is rethrown on the calling thread
+    static void run( const uint32_t &taskCount, const std::function< void( const uint32_t & ) > &task );
+    static uint32_t getWorkerCount( );
+};
+
+END_NAMESPACES
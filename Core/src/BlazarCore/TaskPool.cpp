@@ -0,0 +1,84 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarCore/TaskPool.h>
+
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+#include <future>
+#include <thread>
+#include <vector>
+
+NAMESPACES( ENGINE_NAMESPACE, Core )
+
+static boost::asio::thread_pool &workerPool( )
+{
+    static boost::asio::thread_pool pool( TaskPool::getWorkerCount( ) );
+    return pool;
+}
+
+void TaskPool::run( const uint32_t &taskCount, const std::function< void( const uint32_t & ) > &task )
+{
+    FUNCTION_BREAK( taskCount == 0 )
+
+    std::vector< std::future< void > > pending;
+
+    for ( uint32_t i = 1; i < taskCount; ++i )
+    {
+        auto packagedTask = std::make_shared< std::packaged_task< void( ) > >( [ i, &task ]( ) { task( i ); } );
+        pending.push_back( packagedTask->get_future( ) );
+        boost::asio::post( workerPool( ), [ packagedTask ]( ) { ( *packagedTask )( ); } );
+    }
+
+    std::exception_ptr exception;
+
+    try
+    {
+        task( 0 );
+    }
+    catch ( ... )
+    {
+        exception = std::current_exception( );
+    }
+
+    // Every task is waited for even after a failure, they reference state of the caller
+    for ( auto &future: pending )
+    {
+        try
+        {
+            future.get( );
+        }
+        catch ( ... )
+        {
+            exception = exception ? exception : std::current_exception( );
+        }
+    }
+
+    if ( exception )
+    {
+        std::rethrow_exception( exception );
+    }
+}
+
+uint32_t TaskPool::getWorkerCount( )
+{
+    const uint32_t hardwareThreads = std::thread::hardware_concurrency( );
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+END_NAMESPACES
@@ -105,12 +105,6 @@ struct ViewProjection
     glm::mat4 projection;
 };
 
-struct InstanceData
-{
-    glm::mat4 instances[ 100 ];
-    uint32_t instanceCount;
-};
-
 struct Resolution
 {
     uint32_t width;
@@ -126,6 +120,7 @@ struct BoneTransformations
 struct WorldContext
 {
     glm::vec4 cameraPosition;
+    glm::mat4 inverseViewProjection; // Reconstructs world positions from the depth buffer
 };
 
 class DataAttachmentFormatter
@@ -139,7 +134,8 @@ public:
     static WorldContext formatWorldContext( ECS::ComponentTable* components );
     static glm::mat4 formatModelMatrix( ECS::CTransform * transform, ECS::IGameEntity * refEntity );
     static glm::mat4 formatNormalMatrix( ECS::CTransform * transform, ECS::IGameEntity * refEntity );
-    static InstanceData formatInstances( ECS::CInstances * instances, ECS::IGameEntity* entity );
+    static std::vector< glm::mat4 > formatInstances( ECS::CInstances * instances, ECS::IGameEntity* entity );
+    static std::vector< glm::mat4 > formatInstanceBatch( const std::vector< ECS::IGameEntity * >& entities );
     static BoneTransformations formatBoneTransformations( ECS::IGameEntity * entity );
     static Resolution formatResolution( const uint32_t& width, const uint32_t& height );
     static std::vector< ECS::Material::TextureInfo > getSkyBoxTextures( ECS::ComponentTable* components );
@@ -87,6 +87,7 @@ struct PipelineRequest
     std::unordered_map< ShaderType, std::string > shaderPaths;
 
     std::shared_ptr< IRenderPass > parentPass;
+    uint32_t subpass = 0; // Index of the subpass of parentPass the pipeline is used in
     BlendMode blendMode = BlendMode::None;
 };
 
@@ -102,6 +103,8 @@ class IPipelineProvider
 {
 public:
     virtual IPipeline * createPipeline( const PipelineRequest& request ) = 0;
+    // Same as createPipeline for every request, in request order. Shader and pipeline compilation of the batch may run on worker threads
+    virtual std::vector< IPipeline * > createPipelines( const std::vector< PipelineRequest >& requests ) = 0;
     virtual ~IPipelineProvider( ) = default;
 };
 
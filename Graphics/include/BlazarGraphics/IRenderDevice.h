@@ -30,6 +30,8 @@ NAMESPACES( ENGINE_NAMESPACE, Graphics )
 struct DeviceCapabilities
 {
     bool dedicatedTransferQueue;
+    bool bindlessTextures;
+    bool asyncCompute;
 };
 
 struct DeviceProperties
@@ -45,6 +45,19 @@ struct OutputImageFlags
     bool msaaSampled: 1;
     bool presentedImage: 1;
     bool shaderRead : 1;
+    // Attaches the image of the earlier pass writing an output of the same name and format and loads its content, e.g. a stencil mask
+    bool continuesOutput : 1;
+};
+
+// Filled by the render graph from the passes consuming the output, decides the load and store ops of the attachment
+struct OutputImageAccess
+{
+    bool overwritten = false; // Every pixel is written by the pass, the previous content is neither loaded nor cleared
+    bool readAfterPass = true; // Otherwise the content is discarded at the end of the pass and the attachment can be lazily allocated
+    bool inputAttachment = false; // Read at the same pixel by a later subpass of the same render pass
+    bool attachedAfterPass = false; // A later pass continues the output, it is left in the attachment layout
+    bool storageImage = false; // Written by an async compute pass through image stores, it is never attached
+    bool sharedAcrossQueues = false; // Written and read on different queues, used by both without ownership transfers
 };
 
 struct OutputImage
@@ -52,6 +65,7 @@ struct OutputImage
     ResourceImageFormat imageFormat;
     ResourceAttachmentType attachmentType = ResourceAttachmentType::Color;
     OutputImageFlags flags;
+    OutputImageAccess access;
 
     std::string outputResourceName;
     uint32_t width = 0; // 0 means full size
@@ -84,17 +98,34 @@ struct RenderArea
     uint32_t height = 0;
 };
 
+enum class PassQueue
+{
+    Graphics,
+    // Only for passes made of compute pipelines, runs on the graphics queue if the device has no async compute queue
+    AsyncCompute
+};
+
 enum class DependencySet
 {
     DefaultColor,
     ShadowMap
 };
 
+// A subpass following the first one, which is made of RenderPassRequest::outputImages
+struct SubpassRequest
+{
+    std::vector< OutputImage > outputImages;
+    // Outputs of the earlier subpasses, index i is read through input_attachment_index i
+    std::vector< std::string > inputAttachments;
+};
+
 struct RenderPassRequest
 {
     DependencySet dependencySet = DependencySet::DefaultColor;
+    PassQueue queue = PassQueue::Graphics;
 
     std::vector< OutputImage > outputImages;
+    std::vector< SubpassRequest > subpasses;
     bool isFinalDrawPass = false;
 
     RenderArea renderArea;
@@ -117,8 +148,14 @@ public:
 
     virtual RenderArea getRenderArea( ) const = 0;
 
-    virtual void draw( const uint32_t& instanceCount ) = 0;
-    // Returns if the submission was successful or not
+    // firstInstance is where the draw starts in the bound instance data, shaders read it as gl_BaseInstance
+    virtual void draw( const uint32_t& instanceCount, const uint32_t& firstInstance = 0 ) = 0;
+    // Only for async compute passes, runs the bound compute pipeline once
+    virtual void dispatch( const uint32_t& groupCountX, const uint32_t& groupCountY, const uint32_t& groupCountZ ) = 0;
+    // Draws after this call belong to the next subpass of the request
+    virtual void nextSubpass( ) = 0;
+    // Returns if the submission was successful or not. Without a notifyFence the submission may be deferred and batched
+    // with the next fenced one, ordering between passes is then left to the GPU
     virtual bool submit( std::vector< std::shared_ptr< IResourceLock > > waitOnLock, IResourceLock * notifyFence ) = 0;
     virtual std::string getProperty( const std::string &propertyName ) = 0;
     virtual void cleanup( ) = 0;
@@ -133,7 +170,11 @@ struct RenderTargetRequest
 
     RenderArea renderArea;
 
-    std::vector< OutputImage > outputImages; // will result in the size of output images, resources will be created with the names in order
+    std::vector< OutputImage > outputImages; // will result in the size of output images, resources will be created with the names in order. Outputs of every subpass, in subpass order
+    // Per output image, outputs of the same frame and group share memory. -1 or a missing entry gets a dedicated allocation
+    std::vector< int32_t > aliasGroups;
+    // Render targets of the same frame owning the images of continued outputs, by output name
+    std::unordered_map< std::string, std::shared_ptr< IRenderTarget > > continuedOutputs;
 };
 
 class IRenderPassProvider
@@ -141,6 +182,8 @@ class IRenderPassProvider
 public:
     virtual std::shared_ptr< IRenderPass > createRenderPass( const RenderPassRequest &request ) = 0;
     virtual std::shared_ptr< IRenderTarget > createRenderTarget( const RenderTargetRequest &request ) = 0;
+    // Accounts for the aliased outputs of a render target, every request should be reserved before the first is created
+    virtual void reserveTransientMemory( const RenderTargetRequest &request ) = 0;
     virtual ~IRenderPassProvider( ) = default;
 };
 
@@ -41,7 +41,8 @@ enum class ResourceType
     DepthImage,
     Sampler2D,
     Sampler3D,
-    Uniform
+    Uniform,
+    StorageBuffer
 };
 
 enum class ResourceLoadStrategy
@@ -71,6 +72,7 @@ enum class ResourceImageFormat
     D32Sfloat,
     R32G32B32A32Sfloat,
     R16G16B16A16Sfloat,
+    R16G16Sfloat,
     R8G8B8A8Unorm,
     R8G8B8Unorm,
     R8G8Unorm,
@@ -87,6 +89,8 @@ public:
     explicit inline IResourceLock( const ResourceLockType &lockType ) : lockType( lockType )
     { }
 
+    [[nodiscard]] inline const ResourceLockType &getLockType( ) const { return lockType; }
+
     virtual void wait( ) = 0;
     virtual void reset( ) = 0;
     virtual void notify( ) = 0;
@@ -160,11 +164,13 @@ struct IDataAttachment
 struct VertexData : IDataAttachment
 {
     uint32_t vertexCount;
+    uint32_t firstVertex = 0;
 };
 
 struct IndexData : IDataAttachment
 {
     uint32_t indexCount;
+    uint32_t firstIndex = 0;
 };
 
 struct SamplerDataAttachment : IDataAttachment
@@ -196,10 +202,14 @@ struct ShaderResource
     std::unique_ptr< IDataAttachment > dataAttachment;
     std::function< void( ) > allocate;
     std::function< void( ) > update;
+    // Writes into part of an allocated buffer, buffers that are not host visible receive the range through a staging copy
+    std::function< void( const uint64_t &offset, const void *data, const uint64_t &size ) > write;
     std::function< void( const ResourceUsage &usage ) > prepareForUsage;
     std::function< void( ) > deallocate;
 
     void *apiSpecificBuffer;
+    // Where this resource starts in apiSpecificBuffer, non zero for resources sub-allocated from a shared buffer
+    uint32_t bufferOffset = 0;
 };
 
 class IResourceProvider
@@ -207,6 +217,8 @@ class IResourceProvider
 public:
     virtual std::shared_ptr< ShaderResource > createResource( const ShaderResourceRequest &request ) = 0;
     virtual std::unique_ptr< IResourceLock > createLock( const ResourceLockType &lockType ) = 0;
+    // Runs release once no work submitted so far can still read the memory it gives back
+    virtual void retire( std::function< void( ) > release ) = 0;
     virtual ~IResourceProvider( ) = default;
 };
 
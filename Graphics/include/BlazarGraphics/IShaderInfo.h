@@ -10,7 +10,8 @@ enum class ShaderType
     Fragment,
     TessellationEval,
     TessellationControl,
-    Geometry
+    Geometry,
+    Compute // Only in pipelines of async compute passes, without any other stage
 };
 
 struct Shader
@@ -23,6 +24,8 @@ class IShaderInfo
 {
 public:
     virtual std::vector< std::string > getMergedInputs( ) = 0;
+    // Outputs of an earlier subpass read at the same pixel, ordered by their input_attachment_index
+    virtual std::vector< std::string > getInputAttachments( ) = 0;
     virtual ~IShaderInfo( ) = default;
 };
 
@@ -30,9 +30,11 @@ class CommonPasses
 private:
     CommonPasses( ) = default;
 public:
-    static std::unique_ptr< Pass > createGBufferPass( );
+    // Bindless textures require DeviceCapabilities::bindlessTextures
+    // A compact G-buffer drops the position attachment and packs normals, the lighting pass has to be created with the same layout
+    static std::unique_ptr< Pass > createGBufferPass( const bool &bindlessTextures = false, const bool &compact = false );
     static std::unique_ptr< Pass > createShadowMapPass( );
-    static std::unique_ptr< Pass > createLightingPass( );
+    static std::unique_ptr< Pass > createLightingPass( const bool &compactGBuffer = false );
     static std::unique_ptr< Pass > createSkyBoxPass( );
     static std::unique_ptr< Pass > createPresentPass( );
 
@@ -40,6 +42,9 @@ public:
     static std::unique_ptr< Pass > createSMAAEdgePass( );
     static std::unique_ptr< Pass > createSMAABlendWeightPass( );
     static std::unique_ptr< Pass > createSMAANeighborPass( );
+
+    // Single pass alternative to the SMAA passes, writes the same aliasedImage without the SMAA lookup textures
+    static std::unique_ptr< Pass > createFXAAPass( );
 };
 
 END_NAMESPACES
@@ -0,0 +1,122 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <BlazarCore/Common.h>
+#include "../IRenderDevice.h"
+#include "../AssetManager.h"
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+/*
+ * First fit allocator over a linear range, free blocks are merged with their neighbours when released.
+ * The range grows when no free block fits a request, the caller is expected to resize its storage to getCapacity( ).
+ */
+class OffsetAllocator
+{
+private:
+    uint64_t capacity = 0;
+    std::map< uint64_t, uint64_t > freeBlocks; // offset -> size
+public:
+    uint64_t allocate( const uint64_t& size, const uint64_t& alignment );
+    void free( const uint64_t& offset, const uint64_t& size );
+
+    [[nodiscard]] inline uint64_t getCapacity( ) const { return capacity; }
+private:
+    void grow( const uint64_t& size, const uint64_t& alignment );
+};
+
+struct SubGeometryAllocation
+{
+    uint64_t vertexOffset = 0;
+    uint64_t vertexSize = 0;
+    uint64_t indexOffset = 0;
+    uint64_t indexSize = 0;
+
+    // Views into the shared vertex and index buffers, indices is null for non indexed geometry
+    std::shared_ptr< ShaderResource > vertices;
+    std::shared_ptr< ShaderResource > indices;
+};
+
+struct GeometryAllocation
+{
+    uint32_t refCount = 0;
+    std::vector< SubGeometryAllocation > subGeometries;
+};
+
+/*
+ * Keeps the vertices and indices of every geometry in two shared buffers.
+ * Geometries are deduplicated by their index in the AssetManager, draws address them through firstVertex and firstIndex.
+ */
+class GeometryBuffer
+{
+private:
+    struct BufferPool
+    {
+        ResourceType type;
+        std::string name;
+        OffsetAllocator allocator;
+        std::vector< uint8_t > content;
+        std::shared_ptr< ShaderResource > resource;
+        std::map< uint64_t, uint64_t > dirtyRanges; // offset -> end of content written since the last upload, touching ranges are merged
+    };
+
+    struct FreedRange
+    {
+        BufferPool * pool;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // Filled by the resource provider once the frames that may still draw a released range completed
+    struct RetiredRanges
+    {
+        std::mutex lock;
+        std::vector< FreedRange > ranges;
+    };
+
+    IRenderDevice * renderDevice;
+
+    std::shared_ptr< RetiredRanges > retiredRanges = std::make_shared< RetiredRanges >( );
+    BufferPool vertexPool;
+    BufferPool indexPool;
+    std::unordered_map< int, GeometryAllocation > allocations;
+public:
+    explicit GeometryBuffer( IRenderDevice * renderDevice );
+
+    const GeometryAllocation& acquire( const int& geometryIdx, const MeshGeometry& geometry );
+    void release( const int& geometryIdx );
+
+    // Uploads geometry acquired since the last call, should be called before recording draws
+    void flush( );
+
+    ~GeometryBuffer( );
+private:
+    static uint64_t write( BufferPool& pool, const void * data, const uint64_t& size, const uint64_t& alignment );
+    static void markDirty( BufferPool& pool, const uint64_t& offset, const uint64_t& size );
+    void reclaimRetiredRanges( );
+    void upload( BufferPool& pool );
+    void updateViews( );
+};
+
+END_NAMESPACES
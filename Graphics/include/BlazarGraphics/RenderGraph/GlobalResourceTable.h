@@ -24,11 +24,16 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "../IRenderDevice.h"
 #include "../AssetManager.h"
 #include "../DataAttachmentFormatter.h"
+#include "GeometryBuffer.h"
 #include "Pass.h"
 #include "ShaderUniformBinder.h"
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
+#define UNIFORM_RING_ALIGNMENT 256 // Largest minUniformBufferOffsetAlignment allowed by the spec
+#define UNIFORM_RING_CHUNK_SIZE 65536
+#define INSTANCE_POOL_ALIGNMENT sizeof( glm::mat4 ) // Ranges are addressed by matrix index through firstInstance
+
 struct ShaderResourceWrapper
 {
     bool isAllocated = false;
@@ -38,16 +43,73 @@ struct ShaderResourceWrapper
 struct GeometryData
 {
     std::vector< bool > loadOnceResourcesAdded = { };
-    std::vector< ShaderResourceWrapper > resources;
+    std::vector< ShaderResourceWrapper > resources; // Vertex and index views, owned by the GeometryBuffer
     std::vector< ShaderResourceWrapper > boundResources;
-    SubMeshGeometry subMeshGeometry;
+};
+
+// A wrapper's range in the frame's InstancePool, view points into the pool buffer
+struct InstanceBuffer
+{
+    uint64_t offset = 0;
+    uint64_t capacity = 0;
+    uint64_t version = 0;
+    uint32_t poolGeneration = 0;
+    std::shared_ptr< ShaderResource > view;
+};
+
+/*
+ * Per frame storage buffer the instance matrices of every drawn wrapper are sub-allocated from, draws bind it whole and pass their first matrix as firstInstance.
+ * The buffer is replaced when the allocator grows, ranges written into the previous one are written again the next time they are drawn.
+ */
+struct InstancePool
+{
+    OffsetAllocator allocator;
+    uint64_t capacity = 0;
+    uint32_t generation = 0;
+    std::shared_ptr< ShaderResource > resource;
+};
+
+// The transform fields an instance matrix is built from, kept to notice moved instances without rebuilding their matrices
+struct InstanceTransform
+{
+    glm::vec3 position;
+    glm::vec3 scale;
+    ECS::Rotation rotation;
+};
+
+struct UniformRingChunk
+{
+    uint64_t capacity = 0;
+    std::shared_ptr< ShaderResource > resource;
+};
+
+/*
+ * Per frame linear allocator for per entity uniforms, draws bind the chunk once and only pass their offset.
+ * A new chunk is added when the active one is full, chunks are kept so their descriptors stay valid.
+ */
+struct UniformRing
+{
+    std::vector< UniformRingChunk > chunks;
+    uint32_t activeChunk = 0;
+    uint64_t head = 0;
 };
 
 struct EntityWrapper
 {
-    MeshGeometry geometryRef;
+    int geometryIdx = -1;
     ECS::IGameEntity * entity;
     std::vector< GeometryData > subGeometries;
+
+    // Entities sharing this geometry and material, drawn as extra instances of this entity
+    std::vector< ECS::IGameEntity * > batchedEntities;
+    bool drawnAsInstance = false;
+
+    // Set when the batch or one of its transforms changed, instanceData is rebuilt and the version bumped on the next draw
+    bool instanceDataDirty = true;
+    uint64_t instanceDataVersion = 0;
+    std::vector< InstanceTransform > instanceTransforms;
+    std::vector< glm::mat4 > instanceData;
+    std::vector< InstanceBuffer > instanceBuffers; // One per frame, written when its version is behind
 };
 
 class GlobalResourceTable
@@ -57,11 +119,14 @@ private:
     IRenderDevice *renderDevice;
 
     std::unique_ptr< ShaderUniformBinder > resourceBinder;
+    std::unique_ptr< GeometryBuffer > geometryBuffer;
     std::unique_ptr< ECS::IGameEntity > dummy;
 
     ECS::ComponentTable * currentComponentTable;
     std::vector< std::vector< ShaderResourceWrapper > > frameResources;
     std::vector< std::vector< bool > > frameUpdatedResources;
+    std::vector< UniformRing > uniformRings;
+    std::vector< InstancePool > instancePools;
 
     std::vector< EntityWrapper > geometryList;
     std::vector< EntityWrapper > quadGeometryList;
@@ -69,6 +134,10 @@ private:
     std::vector< EntityWrapper > cubeGeometryList;
 
     std::vector< std::vector< uint32_t > > entityGeometryMap;
+    std::unordered_map< size_t, std::vector< uint32_t > > instanceBatchMap;
+    bool instanceBatchesDirty = true; // Batches are only regrouped when entities are added or removed
+
+    int instanceDataBinderIdx = -1;
 
     std::vector< bool > bindersAssigned;
     std::vector< int > perFrameResources;
@@ -85,6 +154,8 @@ public:
     void resetFrame( const int& frameIdx );
 
     std::shared_ptr< ShaderResource >& getResource( const int& resourceIdx, const uint32_t &frameIndex );
+    std::shared_ptr< ShaderResource >& getResource( EntityWrapper& wrapper, const int& resourceIdx, const uint32_t &frameIndex );
+    uint32_t getFirstInstance( const EntityWrapper& wrapper, const uint32_t &frameIndex ) const;
     std::unique_ptr< SamplerDataAttachment > getSamplerDataAttachment( const ECS::Material::TextureInfo& texture );
 
     std::vector< EntityWrapper >& getGeometryList( const InputGeometry& inputGeometry );
@@ -93,7 +164,7 @@ public:
 
     void allocateAllPerGeometryResources( const int& frameIndex, const MeshGeometry &parent, const SubMeshGeometry &subMeshGeometry );
     void allocateAllPerEntityResources( const int& frameIndex, ECS::IGameEntity* entity );
-    void allocatePerEntityResources( const int& frameIndex, ECS::IGameEntity* entity, std::vector< int > resources );
+    void allocatePerEntityResources( const int& frameIndex, EntityWrapper& wrapper, const std::vector< int >& resources );
     void allocateAllPerFrameResources( const int& frameIndex );
 
     bool isBinderAssigned( const int& binderIdx );
@@ -104,6 +175,8 @@ public:
     ~GlobalResourceTable( );
 private:
     void allocateResource( const int &resourceIdx, const std::string& uniformName, const uint32_t &frameIndex, const IShaderUniform * content );
+    void allocateRingResource( const int &resourceIdx, const std::string& uniformName, const uint32_t &frameIndex, const IShaderUniform * content );
+    UniformRingChunk& getRingChunk( const uint32_t &frameIndex, const uint64_t &size );
 
     std::shared_ptr< ShaderResource > createResource( const ResourceType &type = ResourceType::Uniform,
                                                       const ResourceLoadStrategy &loadStrategy = ResourceLoadStrategy::LoadPerFrame,
@@ -117,9 +190,20 @@ private:
     void attachSamplerAttachment( const IShaderUniform * content, const std::shared_ptr<ShaderResource>& resource );
     void createGeometry( ECS::IGameEntity* entity );
     void createGeometryList( const std::vector< ECS::IGameEntity * > &entities );
-    GeometryData createGeometryData( ECS::IGameEntity* entity, SubMeshGeometry &subMeshGeometry );
+    GeometryData createGeometryData( ECS::IGameEntity* entity, const SubGeometryAllocation &allocation );
+
+    void buildInstanceBatches( );
+    void groupInstanceBatches( );
+    void allocateInstanceData( const int& frameIndex, EntityWrapper& wrapper );
+    void reserveInstanceBuffer( const int& frameIndex, InstanceBuffer& instanceBuffer, const uint64_t& size );
+    static bool refreshInstanceTransforms( EntityWrapper& wrapper );
+    static bool isSameTransform( const InstanceTransform& lhs, const ECS::CTransform& rhs );
+    static bool canBeInstanced( ECS::IGameEntity * entity );
+    static size_t getInstanceBatchKey( ECS::IGameEntity * entity );
+    static bool isInstanceCompatible( ECS::IGameEntity * lhs, ECS::IGameEntity * rhs );
 
     static void cleanGeometryData( GeometryData &geometryData );
+    void cleanInstanceBuffers( EntityWrapper &wrapper );
     static void freeResource( std::shared_ptr< ShaderResource >& resource );
 };
 
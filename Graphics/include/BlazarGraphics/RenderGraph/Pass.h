@@ -42,6 +42,11 @@ struct Pass
     std::vector< PipelineRequest > pipelineRequests;
     RenderPassRequest renderPassRequest;
     std::vector< OutputImage > outputs;
+    // Pixels are left unwritten through discard or stencil testing, color outputs are then cleared even if the geometry covers the target
+    bool discardsFragments = false;
+    // Async compute passes dispatch each pipeline once over the render area, in workgroups matching the local size of the shaders
+    uint32_t workGroupWidth = 8;
+    uint32_t workGroupHeight = 8;
 
     // If more than one pipelines are returned the same object is rendered multiple times with different pipelines
     std::function< std::vector< int >( ECS::IGameEntity * entity ) > selectPipeline;
@@ -28,12 +28,25 @@ NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
 struct PassWrapper
 {
-    std::vector< std::string > dependencies;
-    std::vector< std::unique_ptr< IResourceLock > > executeLocks;
+    std::vector< uint32_t > dependencies; // Indices of the passes producing the inputs of this pass
+
+    // Set when a pass on the other queue depends on this one, the lock of a frame is notified by this pass' submission
+    bool signalsOtherQueue = false;
+    std::vector< std::shared_ptr< IResourceLock > > queueLocks;
 
     std::vector< IPipeline * > pipelines;
     std::shared_ptr< IRenderPass > renderPass;
     std::vector< std::shared_ptr< IRenderTarget > > renderTargets;
+    // Per output, outputs of the same group are never alive at the same time within a frame. -1 for a dedicated allocation
+    std::vector< int32_t > aliasGroups;
+
+    // Passes reading outputs as input attachments are recorded as later subpasses of the producer's render pass
+    std::vector< uint32_t > mergedPasses; // In subpass order
+    int32_t mergedInto = -1; // The pass whose render pass records this one, -1 if it has its own render pass
+    uint32_t subpass = 0;
+    std::vector< std::string > inputAttachments; // Of every pipeline, index is the input_attachment_index
+
+    std::unordered_map< std::string, uint32_t > continuedOutputOwners; // Continued output -> pass whose render target owns the image
 
     std::vector< std::string > pipelineInputsFlat;
     std::vector< std::vector< std::string > > pipelineInputs;
@@ -61,7 +74,12 @@ private:
     std::unordered_map< std::string, uint32_t > passMap;
     std::unordered_map< std::string, std::string > pipelineInputOutputDependencies;
 
+    // Pass indices in execution order, built once by buildGraph. Passes not contributing to a presented image are culled
+    std::vector< uint32_t > executionPlan;
+
     std::vector< std::unique_ptr< std::mutex > > frameLocks;
+    // Signaled by the last pass of the plan, the CPU only waits for these before reusing a frame
+    std::vector< std::unique_ptr< IResourceLock > > frameFences;
     std::vector< std::vector< int > > entitiesUpdatedThisFrame;
 
     bool redrawFrame = false;
@@ -81,13 +99,27 @@ public:
 
     const ShaderUniformBinder* getResourceBinder( ) const {  return globalResourceTable->getResourceBinder( ); }
     ~RenderGraph( );
+    [[nodiscard]] inline const std::vector< uint32_t > &getExecutionPlan( ) const { return executionPlan; }
 private:
+    [[nodiscard]] std::vector< bool > findLivePasses( ) const;
+    void mergeSubpasses( const std::vector< bool > &livePasses );
+    [[nodiscard]] static bool canMergeInto( const PassWrapper &pass, const PassWrapper &producer );
+    void sortPasses( const std::vector< bool > &livePasses );
+    void inferOutputAccess( );
+    void assignAliasGroups( );
+    [[nodiscard]] static bool canAliasOutputs( const PassWrapper &pass );
+    [[nodiscard]] RenderTargetRequest createRenderTargetRequest( const PassWrapper &pass, const uint32_t &frameIndex ) const;
+
+    [[nodiscard]] static bool runsOnSameQueue( const PassWrapper &pass, const PassWrapper &other );
+
     void preparePass( PassWrapper &pass );
+    void createPipelines( );
     void executePass( const PassWrapper &pass );
     void bindDependentInputs( const PassWrapper &pass, std::shared_ptr< IRenderPass > &renderPass, int pipelineIndex );
 
     void prepareInputs( PassWrapper &pass ) const;
-    void drawEntity( const PassWrapper& pass, const std::shared_ptr<IRenderPass>& renderPass, const EntityWrapper& wrapper ) const;
+    void drawEntity( const PassWrapper& pass, const std::shared_ptr<IRenderPass>& renderPass, EntityWrapper& wrapper ) const;
+    void dispatchPipelines( const PassWrapper& pass, const std::shared_ptr<IRenderPass>& renderPass ) const;
 };
 
 END_NAMESPACES
@@ -139,8 +139,6 @@ public:
     {
         return loadOnceBinders;
     }
-private:
-    int registerBinder( std::string uniformName, AllocatorFunction allocator );
 
     template< class T >
     static std::unique_ptr< IShaderUniform > getAttachment( const T& data )
@@ -152,6 +150,18 @@ private:
         return std::unique_ptr< StructShaderUniform >( result );
     }
 
+    template< class T >
+    static std::unique_ptr< IShaderUniform > getAttachment( const std::vector< T >& data )
+    {
+        StructShaderUniform * result = new StructShaderUniform { };
+        result->size = sizeof( T ) * data.size( );
+        result->data = static_cast< char* >( malloc( result->size ) );
+        memcpy( result->data, data.data( ), result->size );
+        return std::unique_ptr< StructShaderUniform >( result );
+    }
+private:
+    int registerBinder( std::string uniformName, AllocatorFunction allocator );
+
     static std::unique_ptr< IShaderUniform > createSamplerShaderUniform( const std::vector< ECS::Material::TextureInfo >& textures, const ResourceType& type = ResourceType::Sampler2D )
     {
         std::unique_ptr< SamplerShaderUniform > shaderUniform = std::make_unique< SamplerShaderUniform >( );
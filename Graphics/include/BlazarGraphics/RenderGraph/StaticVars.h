@@ -44,7 +44,8 @@ public:
         EnvironmentLights,
         Material,
         ModelMatrix,
-        NormalModelMatrix
+        NormalModelMatrix,
+        InstanceData
     };
 
     static std::string getInputName( const ShaderInput &inputName )
@@ -65,6 +66,8 @@ public:
                 return "ModelMatrix";
             case ShaderInput::NormalModelMatrix:
                 return "NormalModelMatrix";
+            case ShaderInput::InstanceData:
+                return "InstanceData";
         }
 
         return "";
@@ -0,0 +1,70 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "VulkanContext.h"
+#include "VulkanUtilities.h"
+#include "QueueTimeline.h"
+
+#define BINDLESS_TEXTURE_CAPACITY 4096
+#define BINDLESS_TEXTURES_NAME "BindlessTextures"
+#define BINDLESS_TEXTURE_INDICES_NAME "TextureIndices"
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+/*
+ * Single partially bound, update after bind array of every sampled texture, shared by all pipelines.
+ * Shaders declare it as BINDLESS_TEXTURES_NAME and receive the array element of each texture through push constants.
+ */
+class BindlessTextureTable
+{
+private:
+    struct TextureSlot
+    {
+        uint32_t index;
+        vk::ImageView imageView;
+        vk::Sampler sampler;
+    };
+
+    VulkanContext * context;
+
+    vk::DescriptorSetLayout layout;
+    vk::DescriptorPool pool;
+    vk::DescriptorSet set;
+
+    std::unordered_map< uint64_t, TextureSlot > slots; // Texture uid - Slot
+    std::vector< uint32_t > freeIndices;
+    uint32_t nextIndex = 0;
+public:
+    explicit BindlessTextureTable( VulkanContext * context );
+
+    // Returns the array element of the texture, the descriptor is only written for new or recreated textures
+    uint32_t getIndex( const VulkanTextureWrapper & texture );
+    // The element is handed out again once the submission carrying the commands recorded so far completed
+    void release( const uint64_t & uid );
+
+    [[nodiscard]] inline const vk::DescriptorSetLayout & getLayout( ) const { return layout; }
+    [[nodiscard]] inline const vk::DescriptorSet & getSet( ) const { return set; }
+
+    ~BindlessTextureTable( );
+private:
+    void write( const TextureSlot & slot );
+};
+
+END_NAMESPACES
@@ -0,0 +1,76 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../GraphicsCommonIncludes.h"
+#include <BlazarCore/Common.h>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+struct CommandRecordingStats
+{
+    uint64_t emitted = 0;
+    uint64_t elided = 0;
+};
+
+/*
+ * Remembers the state bound to a command buffer while recording and only emits commands that change it.
+ * Viewport, scissor and depth bias are expected to be dynamic states of every pipeline.
+ */
+class CommandStateTracker
+{
+private:
+    vk::CommandBuffer commandBuffer { };
+    CommandRecordingStats stats { };
+
+    vk::Pipeline pipeline { };
+    vk::PipelineLayout pipelineLayout { };
+
+    bool hasViewport = false;
+    vk::Viewport viewport { };
+    bool hasScissor = false;
+    vk::Rect2D scissor { };
+    bool hasDepthBias = false;
+    float depthBiasConstant { };
+    float depthBiasSlope { };
+
+    vk::Buffer vertexBuffer { };
+    vk::Buffer indexBuffer { };
+
+    std::vector< vk::DescriptorSet > descriptorSets;
+    std::vector< std::vector< uint32_t > > dynamicOffsets;
+    std::unordered_map< uint64_t, std::vector< char > > pushConstantRanges; // Stage and offset - Last pushed bytes
+public:
+    // Forgets everything bound so far, state does not carry over between command buffers
+    void begin( const vk::CommandBuffer &commandBuffer );
+
+    void bindPipeline( const vk::PipelineBindPoint &bindPoint, const vk::Pipeline &pipeline, const vk::PipelineLayout &layout );
+    void setViewport( const vk::Viewport &viewport );
+    void setScissor( const vk::Rect2D &scissor );
+    void setDepthBias( const float &constant, const float &slope );
+    void bindVertexBuffer( const vk::Buffer &buffer );
+    void bindIndexBuffer( const vk::Buffer &buffer );
+    void bindDescriptorSet( const vk::PipelineBindPoint &bindPoint, const uint32_t &set, const vk::DescriptorSet &descriptorSet, const std::vector< uint32_t > &offsets );
+    void pushConstants( const vk::ShaderStageFlags &stage, const uint32_t &offset, const uint32_t &size, const char *data );
+
+    [[nodiscard]] inline const vk::CommandBuffer &getCommandBuffer( ) const { return commandBuffer; }
+    [[nodiscard]] inline const CommandRecordingStats &getStats( ) const { return stats; }
+};
+
+END_NAMESPACES
@@ -22,29 +22,19 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "GLSLShaderSet.h"
 #include "VulkanResourceProvider.h"
 #include "VulkanSamplerAllocator.h"
+#include "BindlessTextureTable.h"
 #include <BlazarGraphics/GraphicsException.h>
 #include <boost/format.hpp>
 #include <BlazarCore/Logger.h>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
-struct TextureDescription
-{
-    vk::ImageView imageView;
-};
-
-struct BindingUpdateInfo
-{
-    uint32_t index { };
-    vk::DescriptorSet parent { };
-    uint32_t arrayElement { };
-};
-
 struct UniformLocation
 {
     bool found = false;
     uint32_t set { };
     uint32_t binding { };
+    uint32_t index { }; // Position of the binding in DescriptorSetState::bindings
 };
 
 struct DescriptorOrderInfo
@@ -58,6 +48,7 @@ struct DescriptorOrderInfo
 struct PushConstantParent
 {
     char *data { };
+    uint32_t offset { };
     uint32_t totalSize { };
     vk::ShaderStageFlags stage { };
 };
@@ -70,93 +61,130 @@ struct PushConstantBinding
 
 struct DescriptorPool
 {
-    uint32_t freeDescriptors;
+    uint32_t freeSets;
+    std::unordered_map< vk::DescriptorType, uint32_t > freeDescriptors; // Type - Descriptors left
+    bool fragmented = false; // Set once an allocation failed although the counts fit, the pool is not allocated from anymore
     vk::DescriptorPool pool;
 };
 
+struct BoundResource
+{
+    uint64_t uid { }; // Uid of the bound buffer or texture, 0 while nothing is bound
+    uint32_t arrayElement { };
+    vk::DescriptorBufferInfo bufferInfo { };
+    vk::DescriptorImageInfo imageInfo { };
+
+    inline bool operator==( const BoundResource &other ) const
+    {
+        return uid == other.uid && arrayElement == other.arrayElement && bufferInfo == other.bufferInfo && imageInfo == other.imageInfo;
+    }
+};
+
+struct SetBindingState
+{
+    std::string name;
+    vk::DescriptorType type;
+    uint32_t binding { };
+    vk::DeviceSize size { };
+
+    BoundResource resource;
+};
+
+// A written set together with everything it was written with, sets are only shared once all of it matches
+struct CachedSet
+{
+    vk::DescriptorSetLayout layout { };
+    std::vector< BoundResource > resources;
+    vk::DescriptorSet set { };
+    uint32_t pool { }; // Index in descriptorPools
+};
+
+struct DescriptorSetState
+{
+    vk::DescriptorSetLayout layout { };
+    std::vector< SetBindingState > bindings;
+    std::unordered_map< vk::DescriptorType, uint32_t > descriptorCounts; // Descriptors a set of this layout takes from its pool
+
+    vk::DescriptorSet current { };
+    bool dirty = true;
+};
+
+/*
+ * Shaders are expected to group their resources by update frequency:
+ * set 0 per frame, set 1 per pass, set 2 per material and set 3 per draw.
+ * A set holds any number of bindings and is only resolved again once one of them changes.
+ */
 class DescriptorManager
 {
 private:
-    static const uint32_t texturePreallocateCount;
     static const uint32_t descriptorPoolSize;
 
     VulkanContext *context;
     std::shared_ptr< GLSLShaderSet > shaderSet;
 
     std::unordered_map< std::string, UniformLocation > uniformLocations;
-
-    std::vector< std::vector< vk::DescriptorSet > > textureSets;
-    std::vector< std::vector< vk::DescriptorSet > > uniformSets;
-
-    std::vector< uint32_t > nextFreeTexture;
-    std::vector< uint32_t > nextFreeUniform;
+    std::vector< DescriptorSetState > setStates;
     std::vector< DescriptorOrderInfo > orders;
 
-    std::unordered_map< std::string, std::vector< std::vector< vk::DescriptorSet > > > uniformSetMaps; // UniformName - ObjectIndex - FrameIndex
-    std::unordered_map< std::string, std::vector< std::vector< vk::DescriptorSet > > > textureSetMaps; // UniformName - ObjectIndex - FrameIndex
+    // Sets are only written when created, a set is reused by every draw and frame binding the same resources
+    std::unordered_multimap< size_t, CachedSet > cachedSets; // Hash of layout and bound resources - Set
+    std::unordered_map< std::string, uint32_t > dynamicOffsets;
     std::unordered_map< vk::ShaderStageFlagBits, std::vector< PushConstantParent > > pushConstantParents;
     std::unordered_map< std::string, std::vector< PushConstantBinding > > pushConstants;
     std::vector< std::unordered_map< std::string, bool > > frameUpdatedTextures;
 
+    // Set of the shared bindless array if the shader declares it, textures are then bound by pushing their index
+    int bindlessSet = -1;
+    std::vector< std::string > bindlessTextureNames;
+
     std::vector< vk::ShaderStageFlagBits > stagesWithPushConstants;
-    std::vector< vk::DescriptorSetLayout > uniformLayouts;
-    std::vector< vk::DescriptorSetLayout > textureLayouts;
     std::vector< vk::DescriptorSetLayout > layouts;
-
-    std::vector< DescriptorPool > uniformDescriptorPool;
-    std::vector< DescriptorPool > samplerDescriptorPool;
+    std::vector< DescriptorPool > descriptorPools;
 
     std::unique_ptr< VulkanCommandExecutor > commandExecutor;
     std::unique_ptr< SamplerDataAttachment > nullAttachment;
     VulkanTextureWrapper emptyImage;
-
-    uint32_t objectCounter;
 public:
     explicit DescriptorManager( VulkanContext *context, std::shared_ptr< GLSLShaderSet > shaderSet );
 
     void updatePushConstant( const uint32_t &frameIndex, const std::string &uniformName, void *data );
-    void updateUniform( const uint32_t &frameIndex, const std::string &uniformName, const std::pair< vk::Buffer, vma::Allocation > &buffer,
-                        const uint32_t &objectIndex, const int &arrayIndex = -1 );
+    void updateUniform( const uint32_t &frameIndex, const std::string &uniformName, const VulkanBufferWrapper &buffer, const int &arrayIndex = -1 );
 
-    void updateTexture( const uint32_t &frameIndex, const std::string &uniformName, const VulkanTextureWrapper &buffer, const uint32_t &objectIndex );
+    void setDynamicOffset( const std::string &uniformName, const uint32_t &offset );
 
-    vk::DescriptorSet &getUniformDescriptorSet( const uint32_t &frameIndex, const std::string &uniformName, const uint32_t &objectIndex, const uint32_t &arrayIndex = -1 );
-    vk::DescriptorSet &getTextureDescriptorSet( const uint32_t &frameIndex, const std::string &uniformName, const uint32_t &objectIndex, const uint32_t &arrayIndex = 0 );
+    void updateTexture( const uint32_t &frameIndex, const std::string &uniformName, const VulkanTextureWrapper &buffer );
 
-    std::vector< vk::DescriptorSet > getOrderedSets( const uint32_t &frame, const uint32_t &objectIndex );
+    // One set per set index, sets whose bindings did not change since the last call are returned as is
+    std::vector< vk::DescriptorSet > getOrderedSets( const uint32_t &frame );
+    std::vector< uint32_t > getDynamicOffsets( const uint32_t &set );
     std::vector< PushConstantParent > getPushConstantBindings( const uint32_t &frame );
 
     const std::vector< vk::DescriptorSetLayout > &getLayouts( );
 
-    inline void incrementObjectCounter( ) noexcept
-    { objectCounter++; }
-
-    inline void resetObjectCounter( ) noexcept
+    inline void resetUpdatedTextures( ) noexcept
     {
-        objectCounter = 0;
         auto frameSize = frameUpdatedTextures.size( );
         frameUpdatedTextures.clear( );
         frameUpdatedTextures.resize( frameSize );
     }
 
-    inline uint32_t getObjectCount( ) const noexcept
-    { return objectCounter; }
-
     ~DescriptorManager( );
 private:
 
     void createDescriptorPool( );
 
-    void ensureTextureHasDescriptor( const uint32_t &frameIndex, const std::string &texturePath, const uint32_t &objectIndex );
-    void ensureUniformHasDescriptor( const uint32_t &frameIndex, const std::string &uniformName, const uint32_t &objectIndex, const int &arrayIndex );
-
-    static std::string getUniformKey( const std::string &uniformName, const int &arrayIndex = -1 );
-    vk::WriteDescriptorSet getCommonWriteDescriptorSet( const UniformLocation &uniformLocation, const BindingUpdateInfo &updateInfo );
+    SetBindingState *findBinding( const std::string &uniformName, uint32_t &set );
+    void bindResource( SetBindingState &binding, const uint32_t &set, const BoundResource &resource );
+    vk::DescriptorSet resolveSet( const DescriptorSetState &setState );
 
-    void addUniformDescriptorSet( const std::string &uniformName, UniformLocation &location, vk::DescriptorSetLayout &layout, const uint32_t &objectIndex );
-    void addTextureDescriptorSet( const std::string &uniformName, UniformLocation &location, vk::DescriptorSetLayout &layout, const uint32_t &objectIndex );
+    // Returns true if the set was found in the cache, otherwise a new set is allocated and has to be written
+    bool findOrAllocateSet( const DescriptorSetState &setState, vk::DescriptorSet &result );
+    vk::DescriptorSet allocateSet( const DescriptorSetState &setState, uint32_t &poolIndex );
+    // Frees the cached sets the destroyed resource was written to, they can not be bound anymore
+    void evictResource( const uint64_t &uid );
 
-    DescriptorPool &findFreeDescriptorPool( const bool &findUniformPool, const uint32_t &requiredAllocations );
+    uint32_t findFreeDescriptorPool( const DescriptorSetState &setState );
+    static bool fitsInPool( const DescriptorPool &pool, const DescriptorSetState &setState );
     void createNullResources( );
 };
 
@@ -20,9 +20,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <BlazarCore/Common.h>
 #include "../GraphicsCommonIncludes.h"
-#include "SpirvHelper.h"
+#include "SpirvCache.h"
+#include "ShaderReflection.h"
 #include "BlazarCore/Utilities.h"
-#include "spirv_glsl.hpp"
 #include <BlazarGraphics/IShaderInfo.h>
 
 /*
@@ -52,15 +52,12 @@ struct GLSLShaderInfo
 {
     vk::ShaderStageFlagBits type;
     std::vector< uint32_t > data;
+    ShaderReflection reflection;
 public:
     GLSLShaderInfo( ShaderType type, const std::string& path ) : GLSLShaderInfo( genericTypeToVkType( type ), path ){ }
 
-    GLSLShaderInfo( vk::ShaderStageFlagBits type, const std::string& path )
-    {
-        this->type = type;
-        auto glslContents = Core::Utilities::readFile( path ) ;
-        data = SpirvHelper::GLSLtoSPV( type, glslContents.c_str( ) );
-    }
+    // Loads the reflection written next to shaders compiled at build time, other shaders are reflected with spirv-cross
+    GLSLShaderInfo( vk::ShaderStageFlagBits type, const std::string& path );
 
     static vk::ShaderStageFlagBits genericTypeToVkType( ShaderType type )
     {
@@ -83,22 +80,19 @@ public:
             case ShaderType::TessellationEval:
                 shaderType = vk::ShaderStageFlagBits::eTessellationEvaluation;
                 break;
+            case ShaderType::Compute:
+                shaderType = vk::ShaderStageFlagBits::eCompute;
+                break;
         }
 
         return shaderType;
     }
 };
 
-struct StructChild
-{
-    std::string name;
-    uint32_t offset;
-    uint32_t size;
-};
-
 struct PushConstantDetail
 {
     vk::ShaderStageFlagBits stage;
+    uint32_t offset; // Offset of the first member, the range spans offset to size
     uint32_t size;
     std::string name;
     std::vector< StructChild > children;
@@ -107,38 +101,13 @@ struct PushConstantDetail
 class GLSLShaderSet : public IShaderInfo
 {
 private:
-    struct SpvDecoration
-    {
-        spirv_cross::SPIRType type;
-        uint32_t set;
-        uint32_t location;
-        uint32_t binding;
-        uint32_t arraySize;
-        uint32_t size;
-        std::string name;
-        std::vector< StructChild > children;
-    };
-
-    struct GLSLType
-    {
-        vk::Format format;
-        uint32_t size;
-    };
-
-    struct DescriptorBindingCreateInfo
-    {
-        uint32_t binding { };
-        spirv_cross::Resource resource;
-        vk::DescriptorType type;
-        vk::ShaderStageFlagBits stage;
-    };
-
     std::vector< vk::VertexInputBindingDescription > inputBindingDescriptions;
     std::vector< vk::VertexInputAttributeDescription > vertexAttributeDescriptions;
     std::unordered_map< uint32_t, DescriptorSet > descriptorSetMap;
     std::vector< DescriptorSet > descriptorSets;
     std::vector< vk::PushConstantRange > pushConstants;
     std::vector< PushConstantDetail > pushConstantDetails;
+    std::vector< std::string > inputAttachments;
 
     bool interleavedMode;
 public:
@@ -196,15 +165,18 @@ public:
 
         return std::move( result );
     }
+
+    inline std::vector< std::string > getInputAttachments( ) override
+    {
+        return inputAttachments;
+    }
 private:
     void onEachShader( const GLSLShaderInfo &shaderInfo );
     void ensureSetExists( uint32_t set );
-    void createVertexInput( const uint32_t &offset, const GLSLType &type, const uint32_t &location );
+    void createVertexInput( const uint32_t &offset, const ReflectedVertexInput &input );
 
-    void createDescriptorSetBinding( const spirv_cross::Compiler &compiler, const DescriptorBindingCreateInfo &bindingCreateInfo );
-    static GLSLType spvToGLSLType( const spirv_cross::SPIRType &type );
-    SpvDecoration getDecoration( const spirv_cross::Compiler &compiler, const spirv_cross::Resource &resource );
-    void updateDecoration( const DescriptorBindingCreateInfo &bindingCreateInfo, const SpvDecoration &decoration, const DescriptorSet &descriptorSet );
+    void createDescriptorSetBinding( const ReflectedBinding &reflectedBinding, const vk::ShaderStageFlagBits &stage );
+    void updateDecoration( const ReflectedBinding &reflectedBinding, const vk::ShaderStageFlagBits &stage );
 };
 
 
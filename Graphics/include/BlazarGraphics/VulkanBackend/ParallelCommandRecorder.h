@@ -0,0 +1,96 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "VulkanContext.h"
+#include "CommandStateTracker.h"
+
+// Passes with fewer draws are recorded inline, dispatching to other threads would cost more than it saves
+#define PARALLEL_RECORDING_MIN_DRAWS 64
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+struct RecordedPushConstant
+{
+    vk::ShaderStageFlags stage;
+    uint32_t offset;
+    std::vector< char > data;
+};
+
+// Everything a draw binds, resolved on the calling thread so it can be recorded on any thread
+struct RecordedDraw
+{
+    vk::PipelineBindPoint bindPoint;
+    vk::Pipeline pipeline;
+    vk::PipelineLayout layout;
+    vk::Buffer vertexBuffer;
+    vk::Buffer indexBuffer; // Null for non indexed draws
+
+    std::vector< vk::DescriptorSet > descriptorSets;
+    std::vector< std::vector< uint32_t > > dynamicOffsets;
+    std::vector< RecordedPushConstant > pushConstants;
+
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstInstance;
+    uint32_t firstElement;
+    int32_t vertexOffset;
+
+    std::array< uint32_t, 3 > groupCount; // Only for dispatches of compute pipelines
+};
+
+// Dynamic state shared by every draw of a pass
+struct PassRecordingState
+{
+    vk::Viewport viewport;
+    vk::Rect2D scissor;
+    bool setDepthBias;
+    float depthBiasConstant;
+    float depthBiasSlope;
+};
+
+/*
+ * Splits the draws of a pass into contiguous chunks, records each chunk into a secondary command buffer on a worker
+ * thread and executes them in order from the primary command buffer.
+ * Every chunk has its own command pool, a pool is never used by two threads at the same time.
+ */
+class ParallelCommandRecorder
+{
+private:
+    VulkanContext * context;
+    uint32_t chunkCount;
+
+    std::vector< vk::CommandPool > commandPools; // Chunk - Pool
+    std::vector< std::vector< vk::CommandBuffer > > secondaryBuffers; // Frame - Chunk - Buffer
+    std::vector< CommandStateTracker > trackers;
+public:
+    ParallelCommandRecorder( VulkanContext * context, const uint32_t &frameCount );
+
+    // The subpass of the draws has to be begun with vk::SubpassContents::eSecondaryCommandBuffers, once per frame
+    void record( const uint32_t &frameIndex, const vk::CommandBuffer &primary, const vk::CommandBufferInheritanceInfo &inheritanceInfo,
+                 const PassRecordingState &state, const RecordedDraw *draws, const uint32_t &drawCount, CommandRecordingStats &stats );
+
+    static void recordDraw( CommandStateTracker &tracker, const PassRecordingState &state, const RecordedDraw &draw );
+    // Compute pipelines have no dynamic state or geometry, only their sets and push constants are bound
+    static void recordDispatch( CommandStateTracker &tracker, const RecordedDraw &dispatch );
+
+    ~ParallelCommandRecorder( );
+};
+
+END_NAMESPACES
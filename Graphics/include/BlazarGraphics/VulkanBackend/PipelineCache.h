@@ -0,0 +1,50 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "VulkanContext.h"
+
+#define PIPELINE_CACHE_PATH PATH( "/Shaders/SPIRV/pipeline_cache.bin" )
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+/*
+ * Driver side cache of compiled pipelines, every pipeline of the device is created through it.
+ * The content is loaded from disk on creation and written back on destruction, data of another device or driver is ignored.
+ */
+class PipelineCache
+{
+private:
+    VulkanContext * context;
+    std::string path;
+
+    vk::PipelineCache cache;
+public:
+    PipelineCache( VulkanContext * context, std::string path );
+
+    [[nodiscard]] inline const vk::PipelineCache & get( ) const { return cache; }
+
+    ~PipelineCache( );
+private:
+    [[nodiscard]] std::string loadInitialData( ) const;
+    [[nodiscard]] bool isCompatible( const std::string &data ) const;
+    void save( ) const;
+};
+
+END_NAMESPACES
@@ -0,0 +1,86 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "VulkanContext.h"
+
+#include <deque>
+#include <functional>
+#include <map>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+/*
+ * A monotonically increasing counter per queue, every submission signals the next value once its commands completed.
+ * Backed by a timeline semaphore when the device supports VK_KHR_timeline_semaphore, otherwise by a fence per value.
+ * Resources still referenced by submitted commands can be retired at a value instead of waiting for the queue.
+ */
+class QueueTimeline
+{
+private:
+    VulkanContext * context;
+    QueueType queueType;
+    bool useTimelineSemaphore;
+
+    vk::Semaphore semaphore { };
+    uint64_t submittedValue = 0;
+    uint64_t completedValue = 0;
+
+    // Fallback without timeline semaphores, fences of submitted values in submission order
+    std::deque< std::pair< uint64_t, vk::Fence > > pendingFences;
+    std::vector< vk::Fence > freeFences;
+
+    std::multimap< uint64_t, std::function< void( ) > > retirements;
+    // Released while commands were recorded, resolved by the submission carrying them
+    std::vector< std::function< void( ) > > pendingRetirements;
+
+    struct CrossQueueWait
+    {
+        vk::Semaphore semaphore;
+        uint64_t value;
+        vk::PipelineStageFlags stage;
+    };
+
+    // Waits on other timelines, consumed by the next submission
+    std::vector< CrossQueueWait > pendingWaits;
+public:
+    QueueTimeline( VulkanContext * context, const QueueType &queueType, const bool &useTimelineSemaphore );
+
+    // Submits the batches to the queue, the returned value is reached once all of them completed
+    uint64_t submit( const std::vector< vk::SubmitInfo > &submitInfos );
+    void wait( const uint64_t &value );
+    uint64_t getCompletedValue( );
+    [[nodiscard]] inline uint64_t getSubmittedValue( ) const { return submittedValue; }
+
+    // The last batch of the next submission waits at stage until other reached value, both timelines need timeline semaphores
+    void waitFor( QueueTimeline * other, const uint64_t &value, const vk::PipelineStageFlags &stage );
+
+    // Runs release once the queue reached value, release may run immediately if it already did
+    void retireAt( const uint64_t &value, std::function< void( ) > release );
+    // Retires once the submission carrying the commands recorded so far completed, see retirePendingAt
+    void retireAfterPending( std::function< void( ) > release );
+    // Called with the value of a submission that flushed every recorded command buffer, other submissions may come before it
+    void retirePendingAt( const uint64_t &value );
+    // Runs the releases of every value the queue reached, submit and wait collect as well
+    void collect( );
+
+    ~QueueTimeline( );
+};
+
+END_NAMESPACES
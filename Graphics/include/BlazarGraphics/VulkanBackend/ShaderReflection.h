@@ -0,0 +1,84 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <BlazarCore/Common.h>
+
+#define SHADER_REFLECTION_EXTENSION ".refl"
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+struct StructChild
+{
+    std::string name;
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct ReflectedVertexInput
+{
+    uint32_t location { };
+    vk::Format format { };
+    uint32_t size { };
+};
+
+struct ReflectedBinding
+{
+    uint32_t set { };
+    uint32_t binding { };
+    vk::DescriptorType type { };
+    uint32_t descriptorCount { };
+    vk::DeviceSize size { };
+    int inputAttachmentIndex = -1; // Only set for subpass inputs
+    std::string name;
+};
+
+struct ReflectedPushConstant
+{
+    uint32_t size { };
+    std::string name;
+    std::vector< StructChild > children;
+};
+
+/*
+ * Resources a single shader stage declares, GLSLShaderSet merges the reflection of every stage of a pipeline.
+ * Shaders compiled at build time ship it next to their SPIR-V, it is only reflected with spirv-cross at runtime
+ * for shaders without one.
+ */
+struct ShaderReflection
+{
+    vk::ShaderStageFlagBits stage { };
+    size_t spirvHash { }; // Hash of the SPIR-V the reflection was made from, older files are ignored
+
+    std::vector< ReflectedVertexInput > vertexInputs; // Sorted by location
+    std::vector< ReflectedBinding > bindings; // Samplers, subpass inputs, uniform buffers then storage buffers
+    std::vector< ReflectedPushConstant > pushConstants;
+
+    // Defined by SpirvReflection.cpp, which is only built with spirv-cross
+    static ShaderReflection reflect( const vk::ShaderStageFlagBits &stage, const std::vector< uint32_t > &spirv );
+
+    static size_t hashSpirv( const std::vector< uint32_t > &spirv );
+    static std::string getReflectionFile( const std::string &shaderPath );
+
+    std::string serialize( ) const;
+    // Returns false if data is not a reflection of the given SPIR-V
+    static bool deserialize( const std::string &data, const std::vector< uint32_t > &spirv, ShaderReflection &result );
+};
+
+END_NAMESPACES
@@ -0,0 +1,57 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <BlazarCore/Common.h>
+#include "../GraphicsCommonIncludes.h"
+
+#include <mutex>
+#include <unordered_set>
+
+#define SPIRV_CACHE_PATH PATH( "/Shaders/SPIRV/Cache/" )
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+/*
+ * Compiled SPIR-V of every GLSL shader, kept in memory for the run and on disk across runs.
+ * Entries are identified by the source, the content of its includes, the stage and the compiler version,
+ * editing any of them compiles the shader again. Files on disk are named by a hash of the identity and start with
+ * the identity itself, a file is only used if it matches in full. Shaders already compiled at build time skip the cache.
+ * Without BLAZAR_COMPILE_SHADERS no SPIRV/<stage>/<name>.spv exists, requests for one compile <stage>/<name>.glsl instead.
+ */
+class SpirvCache
+{
+private:
+    static std::mutex cacheLock;
+    static std::unordered_map< std::string, std::vector< uint32_t > > memoryCache; // Identity - SPIR-V
+public:
+    // Returns the SPIR-V of the shader at path, empty if it fails to compile. The file may hold GLSL or SPIR-V
+    static std::vector< uint32_t > compile( vk::ShaderStageFlagBits stage, const std::string &path );
+private:
+    static std::string resolveSource( const std::string &path );
+    static bool toSpirv( const std::string &data, std::vector< uint32_t > &spirv );
+    static std::string createIdentity( vk::ShaderStageFlagBits stage, const std::string &path, const std::string &source );
+    static void appendIncludes( std::string &identity, const std::string &directory, const std::string &source, std::unordered_set< std::string > &visited );
+
+    static bool loadFromDisk( const std::string &identity, std::vector< uint32_t > &spirv );
+    static void saveToDisk( const std::string &identity, const std::vector< uint32_t > &spirv );
+    static std::string getCacheFile( const std::string &identity );
+};
+
+END_NAMESPACES
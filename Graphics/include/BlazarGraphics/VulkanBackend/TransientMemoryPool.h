@@ -0,0 +1,62 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "VulkanContext.h"
+
+#include <map>
+#include <unordered_map>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+/*
+ * Memory shared by render target attachments whose lifetimes within a frame do not overlap.
+ * The render graph assigns such attachments an alias group, images of the same frame and group are bound to one allocation.
+ */
+class TransientMemoryPool
+{
+private:
+    struct Block
+    {
+        // Size and alignment are the maximum of the reserved images, memoryTypeBits their intersection
+        vk::MemoryRequirements requirements { };
+        vma::Allocation allocation { };
+        uint32_t boundImages = 0;
+    };
+
+    VulkanContext * context;
+
+    // Frame index, alias group -> block new images are bound to
+    std::map< std::pair< uint32_t, int32_t >, std::shared_ptr< Block > > blocks;
+    std::unordered_map< VkImage, std::shared_ptr< Block > > boundBlocks;
+public:
+    explicit TransientMemoryPool( VulkanContext * context );
+
+    // Should be called for every image of a group before the first one is created, so the allocation fits the largest
+    void reserve( const uint32_t &frameIndex, const int32_t &aliasGroup, const vk::ImageCreateInfo &imageCreateInfo );
+
+    vk::Image createImage( const uint32_t &frameIndex, const int32_t &aliasGroup, const vk::ImageCreateInfo &imageCreateInfo );
+    void destroyImage( const vk::Image &image );
+
+    ~TransientMemoryPool( );
+private:
+    [[nodiscard]] bool fits( const Block &block, const vk::MemoryRequirements &requirements ) const;
+};
+
+END_NAMESPACES
@@ -20,6 +20,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "VulkanContext.h"
 #include "CommandExecutorArguments.h"
+#include "QueueTimeline.h"
+
+#include <functional>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
@@ -28,6 +31,15 @@ class CommandList;
 class VulkanDevice;
 class VulkanContext;
 
+// Identifies a submitted CommandList, it is the value of the graphics QueueTimeline the submission signals
+typedef uint64_t ExecutionTicket;
+
+/*
+ * Submissions go through the graphics QueueTimeline instead of idling the queue. Once the timeline reaches the
+ * ticket of a submission its command buffers are recycled and its completion callback is run, the timeline is
+ * collected on every submission, wait, completed ticket check and at the end of every frame.
+ * An executor is expected to be used by a single thread.
+ */
 class VulkanCommandExecutor
 {
 private:
@@ -37,12 +49,21 @@ private:
     vk::CommandPool commandPool { };
     VulkanContext * context;
 
+    std::vector< vk::CommandBuffer > freeBuffers;
+    ExecutionTicket lastTicket = 0;
 public:
     explicit VulkanCommandExecutor( VulkanContext * context );
 
     std::shared_ptr< BeginCommandExecution > startCommandExecution( );
 
+    [[nodiscard]] bool isComplete( const ExecutionTicket &ticket );
+    void wait( const ExecutionTicket &ticket );
+
     ~VulkanCommandExecutor( );
+private:
+    std::vector< vk::CommandBuffer > acquireBuffers( const uint16_t &count );
+    void releaseBuffers( const std::vector< vk::CommandBuffer > &buffers );
+    ExecutionTicket submit( std::vector< vk::CommandBuffer > buffers, std::function< void( ) > onComplete );
 };
 
 class BeginCommandExecution
@@ -73,13 +94,14 @@ private:
     bool conditionActive = false;
     bool conditionValue = false;
     bool isElse = false;
+    bool submitted = false;
 private:
     friend class BeginCommandExecution;
 
     CommandList( VulkanCommandExecutor *executor, std::vector< vk::CommandBuffer > buffers, vk::CommandBufferUsageFlags usage );
 public:
     CommandList *beginCommand( );
-    CommandList *copyBuffer( const vk::DeviceSize &size, vk::Buffer &src, vk::Buffer &dst );
+    CommandList *copyBuffer( const vk::DeviceSize &size, vk::Buffer &src, vk::Buffer &dst, const vk::DeviceSize &dstOffset = 0 );
     CommandList *beginRenderPass( const vk::Framebuffer frameBuffers[], const vk::ClearColorValue &clearValue );
     CommandList *endRenderPass( );
     CommandList *pushConstant( const vk::PipelineLayout &layout, const vk::ShaderStageFlags &shaderStages, const uint32_t &size, const void *data );
@@ -100,7 +122,8 @@ public:
     CommandList *otherwise( );
     CommandList *endFilter( );
 
-    vk::Result execute( );
+    // onComplete runs once the GPU finished the commands, use it to release resources the commands read from
+    ExecutionTicket execute( std::function< void( ) > onComplete = nullptr );
     const std::vector< vk::CommandBuffer > &getBuffers( );
     ~CommandList( );
 
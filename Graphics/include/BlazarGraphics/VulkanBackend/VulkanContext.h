@@ -41,11 +41,16 @@ struct QueueFamily
     VkQueueFamilyProperties properties;
 };
 
+class BindlessTextureTable;
+class QueueTimeline;
+class PipelineCache;
+
 enum class QueueType
 {
     Graphics,
     Presentation,
     Transfer,
+    Compute
 };
 
 struct VulkanContext
@@ -72,8 +77,23 @@ public:
     vk::Extent2D surfaceExtent { };
 
     RenderWindow* window;
+    // Null unless the device supports descriptor indexing, see VulkanDevice::supportsBindlessTextures
+    BindlessTextureTable* bindlessTextures = nullptr;
+    // Every submission to the graphics queue goes through the timeline, see QueueTimeline
+    QueueTimeline* graphicsTimeline = nullptr;
+    // Null unless the device has a compute queue family without graphics support and timeline semaphores
+    QueueTimeline* computeTimeline = nullptr;
+    // Graphics and compute family, resources used on both queues are shared concurrently between them. Empty without a compute timeline
+    std::vector< uint32_t > crossQueueFamilyIndices;
+    // Persisted between runs, see PipelineCache
+    PipelineCache* pipelineCache = nullptr;
     std::unordered_map< QueueType, QueueFamily > queueFamilies;
     std::unordered_map< QueueType, vk::Queue > queues;
+
+    // Recorded passes waiting to be submitted together with the next fenced pass of the frame
+    std::vector< vk::CommandBuffer > pendingGraphicsSubmits;
+    // Called with the uid of every buffer and texture once it is destroyed, keyed by the object caching it
+    std::unordered_map< const void *, std::function< void( const uint64_t & ) > > resourceDestroyedListeners;
 };
 
 END_NAMESPACES
\ No newline at end of file
@@ -24,6 +24,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "VulkanContext.h"
 #include "VulkanPipelineProvider.h"
 #include "VulkanRenderPassProvider.h"
+#include "BindlessTextureTable.h"
+#include "QueueTimeline.h"
+#include "PipelineCache.h"
 #include <BlazarCore/Logger.h>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
@@ -50,7 +53,8 @@ private:
     const std::vector< QueueType > queueTypes = {
             QueueType::Graphics,
             QueueType::Transfer,
-            QueueType::Presentation
+            QueueType::Presentation,
+            QueueType::Compute
     };
 
     VkDebugUtilsMessengerEXT debugMessenger { };
@@ -62,6 +66,10 @@ private:
     std::unique_ptr< IPipelineProvider > pipelineProvider;
     std::unique_ptr< IRenderPassProvider > renderPassProvider;
     std::unique_ptr< IResourceProvider > resourceProvider;
+    std::unique_ptr< BindlessTextureTable > bindlessTextureTable;
+    std::unique_ptr< QueueTimeline > graphicsTimeline;
+    std::unique_ptr< QueueTimeline > computeTimeline;
+    std::unique_ptr< PipelineCache > pipelineCache;
 public:
     VulkanDevice( ) = default;
 
@@ -113,6 +121,12 @@ private:
 
     void createLogicalDevice( );
 
+    static bool supportsBindlessTextures( const vk::PhysicalDevice &physicalDevice );
+
+    static bool supportsTimelineSemaphores( const vk::PhysicalDevice &physicalDevice );
+
+    static bool supportsAsyncCompute( const vk::PhysicalDevice &physicalDevice );
+
     void createSurface( );
 
     void createImageFormat( );
@@ -35,6 +35,7 @@ struct VulkanPipeline : IPipeline
     VulkanContext *context;
 
     std::shared_ptr< DescriptorManager > descriptorManager;
+    // Owned by the registry of VulkanPipelineProvider, shared by every request with the same state
     vk::Pipeline pipeline;
     vk::PipelineLayout layout;
     bool alreadyDisposed = false;
@@ -45,8 +46,6 @@ struct VulkanPipeline : IPipeline
         alreadyDisposed = true;
 
         descriptorManager.reset( );
-        context->logicalDevice.destroyPipeline( pipeline );
-        context->logicalDevice.destroyPipelineLayout( layout );
     }
 
     ~VulkanPipeline( ) override
@@ -62,6 +61,7 @@ struct PipelineCreateInfos
     std::vector< vk::PipelineColorBlendAttachmentState > colorBlendAttachments { };
     vk::PipelineTessellationStateCreateInfo tessellationStateCreateInfo { };
     vk::GraphicsPipelineCreateInfo pipelineCreateInfo { };
+    vk::ComputePipelineCreateInfo computePipelineCreateInfo { };
     vk::PipelineColorBlendStateCreateInfo colorBlending { };
     vk::PipelineRasterizationStateCreateInfo rasterizationStateCreateInfo { };
     vk::PipelineViewportStateCreateInfo viewportStateCreateInfo { };
@@ -79,6 +79,20 @@ struct PipelineCreateInfos
     std::shared_ptr< VulkanRenderPass > parentPass;
 };
 
+// Everything a pipeline is created from, registered pipelines are only shared once all of it matches
+struct PipelineDescription
+{
+    std::vector< vk::ShaderStageFlagBits > stages;
+    std::vector< std::vector< uint32_t > > spirv; // Per stage
+    std::vector< uint32_t > fixedFunctionState;
+    std::vector< uint32_t > passCompatibility; // See VulkanRenderPass::getCompatibilityKey
+
+    inline bool operator==( const PipelineDescription &other ) const
+    {
+        return stages == other.stages && fixedFunctionState == other.fixedFunctionState && passCompatibility == other.passCompatibility && spirv == other.spirv;
+    }
+};
+
 class VulkanPipelineProvider : public IPipelineProvider
 {
 private:
@@ -89,16 +103,35 @@ private:
             vk::DynamicState::eLineWidth
     };
 
+    struct RegisteredPipeline
+    {
+        PipelineDescription description;
+        vk::Pipeline pipeline;
+        vk::PipelineLayout layout;
+    };
+
+    struct RegisteredShaderModule
+    {
+        std::vector< uint32_t > spirv;
+        vk::ShaderModule module;
+    };
+
     VulkanContext *context;
     std::vector< std::unique_ptr< VulkanPipeline > > pipelineInstances;
-    std::vector< vk::ShaderModule > shaderModules;
+    // Kept for the lifetime of the device, render graph rebuilds get back the pipelines of the previous graph
+    std::unordered_multimap< size_t, RegisteredPipeline > pipelineRegistry; // Hash of the pipeline description - Pipeline
+    std::unordered_multimap< size_t, RegisteredShaderModule > shaderModules; // Hash of the SPIR-V - Module
 public:
     explicit inline VulkanPipelineProvider( VulkanContext *context ) : context( context )
     { }
 
     IPipeline * createPipeline( const PipelineRequest &request ) override;
+    std::vector< IPipeline * > createPipelines( const std::vector< PipelineRequest > &requests ) override;
 
-    void createPipeline( const PipelineRequest &request, VulkanPipeline * pipeline, const std::vector< GLSLShaderInfo > &shaderInfo );
+    static std::vector< GLSLShaderInfo > loadShaders( const PipelineRequest &request );
+    static bool isComputeRequest( const PipelineRequest &request );
+    void configurePipeline( PipelineCreateInfos &createInfo, VulkanPipeline * pipeline );
+    void configureComputePipeline( PipelineCreateInfos &createInfo, VulkanPipeline * pipeline );
     void configureVertexInput( PipelineCreateInfos &createInfo );
     void configureColorBlend( PipelineCreateInfos &createInfo );
     void configureRasterization( PipelineCreateInfos &createInfo );
@@ -108,7 +141,10 @@ public:
     void createPipelineLayout( PipelineCreateInfos &createInfo, VulkanPipeline * pipeline );
     void createRenderPass( PipelineCreateInfos &createInfo );
     void createDepthAttachmentImages( PipelineCreateInfos &createInfo );
-    vk::ShaderModule createShaderModule( std::vector< uint32_t > data );
+    vk::ShaderModule getShaderModule( const std::vector< uint32_t > &data );
+    static PipelineDescription describePipeline( const PipelineRequest &request, const std::vector< GLSLShaderInfo > &shaderInfos );
+    static size_t hashDescription( const PipelineDescription &description );
+    const RegisteredPipeline *findRegisteredPipeline( const size_t &key, const PipelineDescription &description ) const;
 
     ~VulkanPipelineProvider( ) override;
 };
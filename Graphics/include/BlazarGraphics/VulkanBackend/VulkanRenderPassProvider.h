@@ -23,6 +23,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "VulkanUtilities.h"
 #include "VulkanPipelineProvider.h"
 #include "VulkanResourceProvider.h"
+#include "CommandStateTracker.h"
+#include "ParallelCommandRecorder.h"
+#include "TransientMemoryPool.h"
 #include "../IRenderPassProvider.h"
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
@@ -33,14 +36,17 @@ struct VulkanRenderTarget : public IRenderTarget
 {
 private:
     VulkanContext *context;
+    TransientMemoryPool *transientMemory;
 public:
     std::function< void( ) > recreateBuffer;
 
-    inline explicit VulkanRenderTarget( VulkanContext *context ) : context( context )
+    inline explicit VulkanRenderTarget( VulkanContext *context, TransientMemoryPool *transientMemory ) : context( context ), transientMemory( transientMemory )
     { }
 
     vk::Framebuffer ref;
     std::vector< VulkanTextureWrapper > buffers;
+    std::vector< vk::ImageView > shaderReadViews; // Views of output images bound to descriptors, when they differ from the attachment view
+    std::unordered_map< std::string, vk::ImageView > attachmentViews; // By output name, for passes continuing the outputs
 
     void cleanup( ) override;
     ~VulkanRenderTarget( ) override;
@@ -65,14 +71,32 @@ private:
     uint32_t frameIndex { };
     // --
 
-    std::function< void( ) > bindVertexBuffer;
-    std::function< void( ) > bindIndexBuffer;
+    // Geometry lives in shared buffers, bound by the state tracker only when the buffer changes
+    vk::Buffer vertexBuffer { };
+    vk::Buffer indexBuffer { };
+
+    // Draws are captured while the pass is built and recorded on submit, inline or in parallel depending on their count
+    std::vector< RecordedDraw > recordedDraws;
+    std::vector< uint32_t > subpassBegins; // Index of the first draw of every subpass after the first one
+    std::unique_ptr< ParallelCommandRecorder > parallelRecorder;
+    CommandStateTracker stateTracker;
+
+    // Counts of the last recording are exposed through the CommandsEmitted and CommandsElided properties
+    CommandRecordingStats recordingStats;
 
     std::vector< vk::CommandBuffer > buffers;
     vk::RenderPass renderPass;
+    // Equal for render passes pipelines can be shared between, i.e. same attachment formats, samples and subpass references
+    std::vector< uint32_t > compatibilityKey;
+
+    // Async compute passes only record dispatches, outside of the render pass. They are submitted to the compute queue when the device has one
+    bool computePass = false;
+    QueueType queueType = QueueType::Graphics;
+    QueueTimeline * timeline = nullptr;
 
     std::string propertyVal_useMsaa = "false";
     std::string propertyVal_attachmentCount = "0";
+    std::vector< uint32_t > colorAttachmentCounts; // Per subpass
 
     vk::Viewport viewport { };
     vk::Rect2D viewScissor { };
@@ -106,14 +130,22 @@ public:
     const inline vk::Rect2D& getViewScissor( ) { return viewScissor; };
     void updateViewport( const uint32_t& width, const uint32_t& height );
 
-    void draw( const uint32_t& instanceCount ) override;
+    void draw( const uint32_t& instanceCount, const uint32_t& firstInstance = 0 ) override;
+    void dispatch( const uint32_t& groupCountX, const uint32_t& groupCountY, const uint32_t& groupCountZ ) override;
+    void nextSubpass( ) override;
     bool submit( std::vector< std::shared_ptr< IResourceLock > > waitOnLock, IResourceLock * notifyFence ) override;
     [[nodiscard]] const vk::RenderPass &getPassInstance( ) const;
+    [[nodiscard]] inline const std::vector< uint32_t > &getCompatibilityKey( ) const { return compatibilityKey; }
     [[nodiscard]] vk::PipelineBindPoint getBoundPipelineBindPoint( ) const;
+    [[nodiscard]] inline uint32_t getColorAttachmentCount( const uint32_t& subpass ) const { return colorAttachmentCounts[ subpass ]; }
     void presentPassToSwapChain( );
 
     void cleanup( ) override;
     ~VulkanRenderPass( ) override;
+private:
+    RecordedDraw &captureBoundState( );
+    void recordDraws( );
+    void recordComputeWork( );
 };
 
 class VulkanRenderPassProvider : public IRenderPassProvider
@@ -121,14 +153,19 @@ class VulkanRenderPassProvider : public IRenderPassProvider
 private:
     VulkanContext *context;
     std::unique_ptr< VulkanCommandExecutor > commandExecutor;
+    std::unique_ptr< TransientMemoryPool > transientMemory;
+    bool lazilyAllocatedMemory;
 public:
     explicit inline VulkanRenderPassProvider( VulkanContext *context ) : context( context )
     {
         commandExecutor = std::make_unique< VulkanCommandExecutor >( context );
+        transientMemory = std::make_unique< TransientMemoryPool >( context );
+        lazilyAllocatedMemory = VulkanUtilities::supportsLazilyAllocatedMemory( context->physicalDevice );
     }
 
     std::shared_ptr< IRenderPass > createRenderPass( const RenderPassRequest &request ) override;
     std::shared_ptr< IRenderTarget > createRenderTarget( const RenderTargetRequest &request ) override;
+    void reserveTransientMemory( const RenderTargetRequest &request ) override;
 
     static vk::Format getOutputImageVkFormat( VulkanContext *context, const OutputImage &outputImage );
     static vk::SampleCountFlagBits getOutputImageSamples( VulkanContext *context, const OutputImage &outputImage, bool force1ForColorAttachment = false );
@@ -138,7 +175,11 @@ public:
 
     ~VulkanRenderPassProvider( ) override = default;
 private:
-    VulkanTextureWrapper createAttachment( const vk::Format &format, const vk::ImageUsageFlags &usage, const vk::ImageAspectFlags &aspect, const vk::SampleCountFlagBits &sampleCount, const RenderTargetRequest request );
+    VulkanTextureWrapper createAttachment( const vk::Format &format, const vk::ImageUsageFlags &usage, const vk::ImageAspectFlags &aspect, const vk::SampleCountFlagBits &sampleCount,
+                                           const RenderTargetRequest request, const int32_t &aliasGroup, const bool &sharedAcrossQueues = false );
+    vk::ImageCreateInfo getAttachmentImageInfo( const vk::Format &format, const vk::ImageUsageFlags &usage, const vk::SampleCountFlagBits &sampleCount, const RenderTargetRequest &request ) const;
+    static int32_t getAliasGroup( const RenderTargetRequest &request, const uint32_t &outputIndex );
+    [[nodiscard]] bool isLazilyAllocated( const vk::ImageUsageFlags &usage ) const;
 };
 
 END_NAMESPACES
@@ -33,12 +33,15 @@ struct VulkanBufferWrapper
     std::pair< vk::Buffer, vma::Allocation > buffer;
     bool keepMemoryMapped;
     void * mappedMemory;
+    uint64_t uid = nextResourceUid( );
 };
 
+// Fences are points on a QueueTimeline, the timeline and value are assigned by the submission that notifies the fence
 class VulkanResourceLock : public IResourceLock
 {
 private:
-    vk::Fence fence { };
+    QueueTimeline * timeline = nullptr;
+    uint64_t timelineValue = 0;
     vk::Semaphore semaphore { };
 
     VulkanContext* context;
@@ -49,7 +52,14 @@ public:
     void reset( ) override;
     void notify( ) override;
 
-    const vk::Fence &getVkFence( );
+    inline void setTimelineValue( QueueTimeline * submittedTo, const uint64_t &value )
+    {
+        timeline = submittedTo;
+        timelineValue = value;
+    }
+
+    [[nodiscard]] inline QueueTimeline * getTimeline( ) const { return timeline; }
+    [[nodiscard]] inline uint64_t getTimelineValue( ) const { return timelineValue; }
     const vk::Semaphore &getVkSemaphore( );
 
     void cleanup( ) override;
@@ -68,6 +78,7 @@ public:
 
     std::shared_ptr< ShaderResource > createResource( const ShaderResourceRequest &request ) override;
     std::unique_ptr< IResourceLock > createLock( const ResourceLockType &lockType ) override;
+    void retire( std::function< void( ) > release ) override;
 
     void createBufferAllocator( const std::shared_ptr< ShaderResource > &resource );
     void createSampler2DAllocator( const std::shared_ptr< ShaderResource > &resource );
@@ -22,11 +22,28 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "../GraphicsException.h"
 #include "../IResourceProvider.h"
 #include "VulkanCommandExecutor.h"
+#include <atomic>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
+// Vulkan handles can be reused once destroyed, caches identify textures and buffers with this instead
+inline uint64_t nextResourceUid( )
+{
+    static std::atomic< uint64_t > uid { 0 };
+    return ++uid;
+}
+
+inline void notifyResourceDestroyed( VulkanContext * context, const uint64_t &uid )
+{
+    for ( const auto &[ owner, listener ]: context->resourceDestroyedListeners )
+    {
+        listener( uid );
+    }
+}
+
 struct VulkanTextureWrapper
 {
+    uint64_t uid = nextResourceUid( );
     ResourceUsage previousUsage { };
 
     vk::Sampler sampler { };
@@ -58,6 +75,8 @@ public:
 
     static vk::SampleCountFlagBits maxDeviceMSAASampleCount( const vk::PhysicalDevice &physicalDevice );
 
+    static bool supportsLazilyAllocatedMemory( const vk::PhysicalDevice &physicalDevice );
+
     static vk::Format findSupportedDepthFormat( vk::PhysicalDevice physicalDevice );
 
     static uint32_t getMatchingMemoryType( const VulkanContext *context,
@@ -72,6 +91,17 @@ public:
                                  const uint32_t &layerCount = 1 );
 
     static void prepareImageForUsage( VulkanCommandExecutor *commandExecutor, VulkanTextureWrapper *textureWrapper, const ResourceUsage &usage );
+
+    // Lets the graphics and the async compute queue use the resource without queue family ownership transfers, for image and buffer create infos
+    template< class CreateInfo >
+    static void shareAcrossQueues( const VulkanContext *context, CreateInfo &createInfo )
+    {
+        FUNCTION_BREAK( context->crossQueueFamilyIndices.empty( ) )
+
+        createInfo.sharingMode = vk::SharingMode::eConcurrent;
+        createInfo.queueFamilyIndexCount = context->crossQueueFamilyIndices.size( );
+        createInfo.pQueueFamilyIndices = context->crossQueueFamilyIndices.data( );
+    }
 };
 
 END_NAMESPACES
\ No newline at end of file
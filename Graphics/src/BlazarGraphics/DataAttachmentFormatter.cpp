@@ -155,24 +155,43 @@ Tessellation DataAttachmentFormatter::formatTessellationComponent( ECS::CTessell
     return { tessellation->innerLevel, tessellation->outerLevel };
 }
 
-InstanceData DataAttachmentFormatter::formatInstances( ECS::CInstances * instances, ECS::IGameEntity * entity )
+std::vector< glm::mat4 > DataAttachmentFormatter::formatInstances( ECS::CInstances * instances, ECS::IGameEntity * entity )
 {
-    InstanceData instanceData = { };
-    instanceData.instanceCount = 0;
+    std::vector< glm::mat4 > instanceData;
 
-    if ( instances == nullptr )
+    if ( instances != nullptr )
     {
-        return instanceData;
+        instanceData.reserve( instances->transforms.size( ) );
+
+        for ( auto &transform: instances->transforms )
+        {
+            instanceData.push_back( formatModelMatrix( &transform, entity ) );
+        }
     }
 
-    uint32_t i = 0;
+    // Storage buffers cannot be empty
+    if ( instanceData.empty( ) )
+    {
+        instanceData.emplace_back( 1.0f );
+    }
+
+    return instanceData;
+}
+
+std::vector< glm::mat4 > DataAttachmentFormatter::formatInstanceBatch( const std::vector< ECS::IGameEntity * >& entities )
+{
+    std::vector< glm::mat4 > instanceData;
+    instanceData.reserve( entities.size( ) );
+
+    for ( const auto& entity : entities )
+    {
+        instanceData.push_back( formatModelMatrix( entity->getComponent< ECS::CTransform >( ), entity ) );
+    }
 
-    for ( ; i < instances->transforms.size( ); ++i )
+    if ( instanceData.empty( ) )
     {
-        instanceData.instances[ i ] = formatModelMatrix( &instances->transforms[ i ], entity );
+        instanceData.emplace_back( 1.0f );
     }
-   
-    instanceData.instanceCount = i;
 
     return instanceData;
 }
@@ -249,6 +268,7 @@ WorldContext DataAttachmentFormatter::formatWorldContext( ECS::ComponentTable *
 
     WorldContext data { };
     data.cameraPosition = glm::vec4( activeCamera->position, 1.0f );
+    data.inverseViewProjection = glm::inverse( activeCamera->projection * activeCamera->view );
     return data;
 }
 
@@ -25,7 +25,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
-std::unique_ptr< Pass > CommonPasses::createGBufferPass( )
+std::unique_ptr< Pass > CommonPasses::createGBufferPass( const bool &bindlessTextures, const bool &compact )
 {
     auto gBufferPass = std::make_unique< Pass >( "gBufferPass" );
     gBufferPass->inputGeometry = InputGeometry::Model;
@@ -35,19 +35,23 @@ std::unique_ptr< Pass > CommonPasses::createGBufferPass( )
     depthBuffer.imageFormat = ResourceImageFormat::BestDepthFormat;
     depthBuffer.attachmentType = ResourceAttachmentType::DepthAndStencil;
 
-    auto &gBuffer_Position = gBufferPass->outputs.emplace_back( OutputImage { } );
-    gBuffer_Position.outputResourceName = "gBuffer_Position";
-    gBuffer_Position.imageFormat = ResourceImageFormat::R32G32B32A32Sfloat;
-    gBuffer_Position.attachmentType = ResourceAttachmentType::Color;
+    // The compact layout reconstructs positions from depth, 12 bytes per pixel instead of 28
+    if ( !compact )
+    {
+        auto &gBuffer_Position = gBufferPass->outputs.emplace_back( OutputImage { } );
+        gBuffer_Position.outputResourceName = "gBuffer_Position";
+        gBuffer_Position.imageFormat = ResourceImageFormat::R32G32B32A32Sfloat;
+        gBuffer_Position.attachmentType = ResourceAttachmentType::Color;
+    }
 
     auto &gBuffer_Normal = gBufferPass->outputs.emplace_back( OutputImage { } );
     gBuffer_Normal.outputResourceName = "gBuffer_Normal";
-    gBuffer_Normal.imageFormat = ResourceImageFormat::MatchSwapChainImageFormat;
+    gBuffer_Normal.imageFormat = compact ? ResourceImageFormat::R16G16Sfloat : ResourceImageFormat::MatchSwapChainImageFormat;
     gBuffer_Normal.attachmentType = ResourceAttachmentType::Color;
 
     auto &gBuffer_Albedo = gBufferPass->outputs.emplace_back( OutputImage { } );
     gBuffer_Albedo.outputResourceName = "gBuffer_Albedo";
-    gBuffer_Albedo.imageFormat = ResourceImageFormat::R8G8B8A8Unorm;
+    gBuffer_Albedo.imageFormat = compact ? ResourceImageFormat::R8G8B8A8Srgb : ResourceImageFormat::R8G8B8A8Unorm;
     gBuffer_Albedo.attachmentType = ResourceAttachmentType::Color;
 
     auto &gBuffer_Material = gBufferPass->outputs.emplace_back( OutputImage { } );
@@ -92,17 +96,20 @@ std::unique_ptr< Pass > CommonPasses::createGBufferPass( )
         request.stencilTestStateFront.passOp = StencilOp::Replace;
     };
 
+    const std::string fragmentShader = compact ? PATH( "/Shaders/SPIRV/Fragment/gBuffer_compact.spv" ) : PATH( "/Shaders/SPIRV/Fragment/gBuffer.spv" );
+    const std::string bindlessFragmentShader = compact ? PATH( "/Shaders/SPIRV/Fragment/gBuffer_compact_bindless.spv" ) : PATH( "/Shaders/SPIRV/Fragment/gBuffer_bindless.spv" );
+
     PipelineRequest &pipelineRequest = gBufferPass->pipelineRequests.emplace_back( PipelineRequest { } );
 
     pipelineRequest.shaderPaths[ ShaderType::Vertex ] = PATH( "/Shaders/SPIRV/Vertex/gBuffer.spv" );
-    pipelineRequest.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/gBuffer.spv" );
+    pipelineRequest.shaderPaths[ ShaderType::Fragment ] = bindlessTextures ? bindlessFragmentShader : fragmentShader;
     pipelineRequest.cullMode = ECS::CullMode::None;
     pipelineRequest.depthCompareOp = CompareOp::Less;
 
     PipelineRequest &heightmapTessellationPipeline = gBufferPass->pipelineRequests.emplace_back( PipelineRequest { } );
 
     heightmapTessellationPipeline.shaderPaths[ ShaderType::Vertex ] = PATH( "/Shaders/SPIRV/Vertex/gBuffer.spv" );
-    heightmapTessellationPipeline.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/gBuffer.spv" );
+    heightmapTessellationPipeline.shaderPaths[ ShaderType::Fragment ] = fragmentShader;
     heightmapTessellationPipeline.shaderPaths[ ShaderType::TessellationControl ] = PATH( "/Shaders/SPIRV/tesscontrol/height_map.spv" );
     heightmapTessellationPipeline.shaderPaths[ ShaderType::TessellationEval ] = PATH( "/Shaders/SPIRV/tesseval/height_map.spv" );
     heightmapTessellationPipeline.cullMode = ECS::CullMode::None;
@@ -111,7 +118,7 @@ std::unique_ptr< Pass > CommonPasses::createGBufferPass( )
     PipelineRequest &stencilTestEnabled = gBufferPass->pipelineRequests.emplace_back( PipelineRequest { } );
 
     stencilTestEnabled.shaderPaths[ ShaderType::Vertex ] = PATH( "/Shaders/SPIRV/Vertex/gBuffer.spv" );
-    stencilTestEnabled.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/gBuffer.spv" );
+    stencilTestEnabled.shaderPaths[ ShaderType::Fragment ] = fragmentShader;
     stencilTestEnabled.cullMode = ECS::CullMode::None;
     stencilTestEnabled.depthCompareOp = CompareOp::Less;
     setPipelineStencilDefaults( stencilTestEnabled );
@@ -119,7 +126,7 @@ std::unique_ptr< Pass > CommonPasses::createGBufferPass( )
     PipelineRequest &outlinedPipeline = gBufferPass->pipelineRequests.emplace_back( PipelineRequest { } );
 
     outlinedPipeline.shaderPaths[ ShaderType::Vertex ] = PATH( "/Shaders/SPIRV/Vertex/gBuffer_outlined.spv" );
-    outlinedPipeline.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/gBuffer_outlined.spv" );
+    outlinedPipeline.shaderPaths[ ShaderType::Fragment ] = compact ? PATH( "/Shaders/SPIRV/Fragment/gBuffer_outlined_compact.spv" ) : PATH( "/Shaders/SPIRV/Fragment/gBuffer_outlined.spv" );
     outlinedPipeline.cullMode = ECS::CullMode::None;
     outlinedPipeline.depthCompareOp = CompareOp::Less;
     outlinedPipeline.enableDepthTest = false;
@@ -133,14 +140,14 @@ std::unique_ptr< Pass > CommonPasses::createGBufferPass( )
     PipelineRequest &animatedGBufferRequest = gBufferPass->pipelineRequests.emplace_back( PipelineRequest { } );
 
     animatedGBufferRequest.shaderPaths[ ShaderType::Vertex ] = PATH( "/Shaders/SPIRV/Vertex/gBuffer_Animated.spv" );
-    animatedGBufferRequest.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/gBuffer.spv" );
+    animatedGBufferRequest.shaderPaths[ ShaderType::Fragment ] = fragmentShader;
     animatedGBufferRequest.cullMode = ECS::CullMode::None;
     animatedGBufferRequest.depthCompareOp = CompareOp::Less;
 
     return std::move( gBufferPass );
 }
 
-std::unique_ptr< Pass > CommonPasses::createLightingPass( )
+std::unique_ptr< Pass > CommonPasses::createLightingPass( const bool &compactGBuffer )
 {
     auto lightingPass = std::make_unique< Pass >( "lightingPass" );
     lightingPass->inputGeometry = InputGeometry::Quad;
@@ -158,7 +165,7 @@ std::unique_ptr< Pass > CommonPasses::createLightingPass( )
     PipelineRequest &pipelineRequest = lightingPass->pipelineRequests.emplace_back( );
 
     pipelineRequest.shaderPaths[ ShaderType::Vertex ] = PATH( "/Shaders/SPIRV/Vertex/quad_position.spv" );
-    pipelineRequest.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/lighting_pass.spv" );
+    pipelineRequest.shaderPaths[ ShaderType::Fragment ] = compactGBuffer ? PATH( "/Shaders/SPIRV/Fragment/lighting_pass_compact.spv" ) : PATH( "/Shaders/SPIRV/Fragment/lighting_pass.spv" );
     pipelineRequest.cullMode = ECS::CullMode::None;
     pipelineRequest.depthCompareOp = CompareOp::Less;
 
@@ -238,13 +245,20 @@ std::unique_ptr< Pass > CommonPasses::createSMAAEdgePass( )
 {
     auto smaaEdgePass = std::make_unique< Pass >( "smaaEdgePass" );
     smaaEdgePass->inputGeometry = InputGeometry::OverSizedTriangle;
+    smaaEdgePass->discardsFragments = true; // Pixels without edges
 
     auto &edgesTex = smaaEdgePass->outputs.emplace_back( OutputImage { } );
     edgesTex.outputResourceName = "edgesTex";
-    edgesTex.imageFormat = ResourceImageFormat::R32G32B32A32Sfloat;
+    edgesTex.imageFormat = ResourceImageFormat::R8G8Unorm;
     edgesTex.flags.msaaSampled = false;
     edgesTex.attachmentType = ResourceAttachmentType::Color;
 
+    // Marks the pixels with edges, the blend weight pass only runs on them
+    auto &edgeStencil = smaaEdgePass->outputs.emplace_back( OutputImage { } );
+    edgeStencil.outputResourceName = "smaaEdgeStencil";
+    edgeStencil.imageFormat = ResourceImageFormat::BestDepthFormat;
+    edgeStencil.attachmentType = ResourceAttachmentType::DepthAndStencil;
+
 
     RenderPassRequest renderPassRequest { };
 
@@ -256,6 +270,16 @@ std::unique_ptr< Pass > CommonPasses::createSMAAEdgePass( )
     pipelineRequest.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/smaaEdge.spv" );
     pipelineRequest.cullMode = ECS::CullMode::None;
     pipelineRequest.depthCompareOp = CompareOp::Less;
+    pipelineRequest.enableDepthTest = false;
+
+    pipelineRequest.stencilTestStateFront.enabled = true;
+    pipelineRequest.stencilTestStateFront.compareOp = CompareOp::Always;
+    pipelineRequest.stencilTestStateFront.compareMask = 0xFF;
+    pipelineRequest.stencilTestStateFront.writeMask = 0xFF;
+    pipelineRequest.stencilTestStateFront.ref = 1;
+    pipelineRequest.stencilTestStateFront.failOp = StencilOp::Keep;
+    pipelineRequest.stencilTestStateFront.depthFailOp = StencilOp::Keep;
+    pipelineRequest.stencilTestStateFront.passOp = StencilOp::Replace;
 
     smaaEdgePass->selectPipeline = [ ](  ECS::IGameEntity * entity )
     {
@@ -269,13 +293,20 @@ std::unique_ptr< Pass > CommonPasses::createSMAABlendWeightPass( )
 {
     auto smaaBlendWeightPass = std::make_unique< Pass >( "smaaBlendWeightPass" );
     smaaBlendWeightPass->inputGeometry = InputGeometry::OverSizedTriangle;
+    smaaBlendWeightPass->discardsFragments = true; // Pixels without edges fail the stencil test
 
     auto &blendTex = smaaBlendWeightPass->outputs.emplace_back( OutputImage { } );
     blendTex.outputResourceName = "blendTex";
-    blendTex.imageFormat = ResourceImageFormat::R32G32B32A32Sfloat;
+    blendTex.imageFormat = ResourceImageFormat::R8G8B8A8Unorm;
     blendTex.flags.msaaSampled = false;
     blendTex.attachmentType = ResourceAttachmentType::Color;
 
+    auto &edgeStencil = smaaBlendWeightPass->outputs.emplace_back( OutputImage { } );
+    edgeStencil.outputResourceName = "smaaEdgeStencil";
+    edgeStencil.imageFormat = ResourceImageFormat::BestDepthFormat;
+    edgeStencil.attachmentType = ResourceAttachmentType::DepthAndStencil;
+    edgeStencil.flags.continuesOutput = true;
+
 
     RenderPassRequest renderPassRequest { };
 
@@ -287,6 +318,16 @@ std::unique_ptr< Pass > CommonPasses::createSMAABlendWeightPass( )
     pipelineRequest.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/smaaBlendWeight.spv" );
     pipelineRequest.cullMode = ECS::CullMode::None;
     pipelineRequest.depthCompareOp = CompareOp::Less;
+    pipelineRequest.enableDepthTest = false;
+
+    pipelineRequest.stencilTestStateFront.enabled = true;
+    pipelineRequest.stencilTestStateFront.compareOp = CompareOp::Equal;
+    pipelineRequest.stencilTestStateFront.compareMask = 0xFF;
+    pipelineRequest.stencilTestStateFront.writeMask = 0x00;
+    pipelineRequest.stencilTestStateFront.ref = 1;
+    pipelineRequest.stencilTestStateFront.failOp = StencilOp::Keep;
+    pipelineRequest.stencilTestStateFront.depthFailOp = StencilOp::Keep;
+    pipelineRequest.stencilTestStateFront.passOp = StencilOp::Keep;
 
     smaaBlendWeightPass->selectPipeline = [ ](  ECS::IGameEntity * entity )
     {
@@ -303,7 +344,7 @@ std::unique_ptr< Pass > CommonPasses::createSMAANeighborPass( )
 
     auto &aliasedImage = smaaNeighborPass->outputs.emplace_back( OutputImage { } );
     aliasedImage.outputResourceName = "aliasedImage";
-    aliasedImage.imageFormat = ResourceImageFormat::R32G32B32A32Sfloat;
+    aliasedImage.imageFormat = ResourceImageFormat::R16G16B16A16Sfloat; // Matches the lit scene it filters
     aliasedImage.flags.msaaSampled = false;
     aliasedImage.attachmentType = ResourceAttachmentType::Color;
 
@@ -327,6 +368,36 @@ std::unique_ptr< Pass > CommonPasses::createSMAANeighborPass( )
     return std::move( smaaNeighborPass );
 }
 
+std::unique_ptr< Pass > CommonPasses::createFXAAPass( )
+{
+    auto fxaaPass = std::make_unique< Pass >( "fxaaPass" );
+    fxaaPass->inputGeometry = InputGeometry::OverSizedTriangle;
+
+    auto &aliasedImage = fxaaPass->outputs.emplace_back( OutputImage { } );
+    aliasedImage.outputResourceName = "aliasedImage";
+    aliasedImage.imageFormat = ResourceImageFormat::R16G16B16A16Sfloat;
+    aliasedImage.flags.msaaSampled = false;
+    aliasedImage.attachmentType = ResourceAttachmentType::Color;
+
+    RenderPassRequest renderPassRequest { };
+
+    fxaaPass->renderPassRequest = renderPassRequest;
+
+    PipelineRequest &pipelineRequest = fxaaPass->pipelineRequests.emplace_back( );
+
+    pipelineRequest.shaderPaths[ ShaderType::Vertex ] = PATH( "/Shaders/SPIRV/Vertex/fxaa.spv" );
+    pipelineRequest.shaderPaths[ ShaderType::Fragment ] = PATH( "/Shaders/SPIRV/Fragment/fxaa.spv" );
+    pipelineRequest.cullMode = ECS::CullMode::None;
+    pipelineRequest.depthCompareOp = CompareOp::Less;
+
+    fxaaPass->selectPipeline = [ ]( ECS::IGameEntity * )
+    {
+        RETURN_SINGLE_PIPELINE( 0 )
+    };
+
+    return std::move( fxaaPass );
+}
+
 std::unique_ptr< Pass > CommonPasses::createPresentPass( )
 {
     auto presentPass = std::make_unique< Pass >( "presentPass" );
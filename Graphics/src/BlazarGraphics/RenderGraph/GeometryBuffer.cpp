@@ -0,0 +1,303 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/RenderGraph/GeometryBuffer.h>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+uint64_t OffsetAllocator::allocate( const uint64_t& size, const uint64_t& alignment )
+{
+    for ( auto it = freeBlocks.begin( ); it != freeBlocks.end( ); ++it )
+    {
+        const uint64_t blockOffset = it->first;
+        const uint64_t blockEnd = it->first + it->second;
+        const uint64_t alignedOffset = ( ( blockOffset + alignment - 1 ) / alignment ) * alignment;
+
+        SKIP_ITERATION_IF( alignedOffset + size > blockEnd )
+
+        freeBlocks.erase( it );
+
+        if ( alignedOffset > blockOffset )
+        {
+            freeBlocks[ blockOffset ] = alignedOffset - blockOffset;
+        }
+
+        if ( alignedOffset + size < blockEnd )
+        {
+            freeBlocks[ alignedOffset + size ] = blockEnd - ( alignedOffset + size );
+        }
+
+        return alignedOffset;
+    }
+
+    grow( size, alignment );
+
+    return allocate( size, alignment );
+}
+
+void OffsetAllocator::free( const uint64_t& offset, const uint64_t& size )
+{
+    FUNCTION_BREAK( size == 0 )
+
+    auto it = freeBlocks.emplace( offset, size ).first;
+
+    if ( auto next = std::next( it ); next != freeBlocks.end( ) && it->first + it->second == next->first )
+    {
+        it->second += next->second;
+        freeBlocks.erase( next );
+    }
+
+    if ( it != freeBlocks.begin( ) )
+    {
+        if ( auto previous = std::prev( it ); previous->first + previous->second == it->first )
+        {
+            previous->second += it->second;
+            freeBlocks.erase( it );
+        }
+    }
+}
+
+void OffsetAllocator::grow( const uint64_t& size, const uint64_t& alignment )
+{
+    // Growing from the current end always leaves enough room, even if the last block is not free
+    const uint64_t alignedEnd = ( ( capacity + alignment - 1 ) / alignment ) * alignment;
+    const uint64_t newCapacity = std::max( capacity * 2, alignedEnd + size );
+
+    free( capacity, newCapacity - capacity );
+    capacity = newCapacity;
+}
+
+GeometryBuffer::GeometryBuffer( IRenderDevice * renderDevice ) : renderDevice( renderDevice )
+{
+    vertexPool.type = ResourceType::VertexData;
+    vertexPool.name = "VertexData";
+
+    indexPool.type = ResourceType::IndexData;
+    indexPool.name = "IndexData";
+}
+
+const GeometryAllocation& GeometryBuffer::acquire( const int& geometryIdx, const MeshGeometry& geometry )
+{
+    GeometryAllocation& allocation = allocations[ geometryIdx ];
+    ++allocation.refCount;
+
+    if ( allocation.refCount > 1 )
+    {
+        return allocation;
+    }
+
+    reclaimRetiredRanges( );
+
+    for ( const SubMeshGeometry& subMeshGeometry : geometry.subGeometries )
+    {
+        SubGeometryAllocation& subAllocation = allocation.subGeometries.emplace_back( );
+
+        subAllocation.vertexSize = subMeshGeometry.dataRaw.size( ) * sizeof( float );
+
+        // Vertices are aligned to their own stride so the offset can be expressed as firstVertex
+        const uint64_t vertexStride = subMeshGeometry.vertexCount == 0 ? sizeof( float ) : subAllocation.vertexSize / subMeshGeometry.vertexCount;
+        subAllocation.vertexOffset = write( vertexPool, subMeshGeometry.dataRaw.data( ), subAllocation.vertexSize, vertexStride );
+
+        std::unique_ptr< VertexData > vertexData = std::make_unique< VertexData >( );
+        vertexData->vertexCount = subMeshGeometry.vertexCount;
+        vertexData->firstVertex = subAllocation.vertexOffset / vertexStride;
+
+        subAllocation.vertices = std::make_shared< ShaderResource >( );
+        subAllocation.vertices->identifier = { vertexPool.name };
+        subAllocation.vertices->type = ResourceType::VertexData;
+        subAllocation.vertices->loadStrategy = ResourceLoadStrategy::LoadOnce;
+        subAllocation.vertices->dataAttachment = std::move( vertexData );
+        subAllocation.vertices->apiSpecificBuffer = nullptr;
+
+        SKIP_ITERATION_IF( subMeshGeometry.indices.empty( ) )
+
+        subAllocation.indexSize = subMeshGeometry.indices.size( ) * sizeof( uint32_t );
+        subAllocation.indexOffset = write( indexPool, subMeshGeometry.indices.data( ), subAllocation.indexSize, sizeof( uint32_t ) );
+
+        std::unique_ptr< IndexData > indexData = std::make_unique< IndexData >( );
+        indexData->indexCount = subMeshGeometry.indices.size( );
+        indexData->firstIndex = subAllocation.indexOffset / sizeof( uint32_t );
+
+        subAllocation.indices = std::make_shared< ShaderResource >( );
+        subAllocation.indices->identifier = { indexPool.name };
+        subAllocation.indices->type = ResourceType::IndexData;
+        subAllocation.indices->loadStrategy = ResourceLoadStrategy::LoadOnce;
+        subAllocation.indices->dataAttachment = std::move( indexData );
+        subAllocation.indices->apiSpecificBuffer = nullptr;
+    }
+
+    return allocation;
+}
+
+void GeometryBuffer::release( const int& geometryIdx )
+{
+    auto find = allocations.find( geometryIdx );
+
+    FUNCTION_BREAK( find == allocations.end( ) )
+    FUNCTION_BREAK( --find->second.refCount > 0 )
+
+    std::vector< FreedRange > freedRanges;
+
+    for ( const auto& subAllocation : find->second.subGeometries )
+    {
+        freedRanges.push_back( { &vertexPool, subAllocation.vertexOffset, subAllocation.vertexSize } );
+        freedRanges.push_back( { &indexPool, subAllocation.indexOffset, subAllocation.indexSize } );
+    }
+
+    allocations.erase( find );
+
+    // Submitted frames may still draw from the ranges, writing new geometry over them has to wait until they completed
+    renderDevice->getResourceProvider( )->retire( [ retiredRanges = retiredRanges, freedRanges = std::move( freedRanges ) ]( )
+    {
+        std::lock_guard< std::mutex > guard( retiredRanges->lock );
+        retiredRanges->ranges.insert( retiredRanges->ranges.end( ), freedRanges.begin( ), freedRanges.end( ) );
+    } );
+}
+
+void GeometryBuffer::reclaimRetiredRanges( )
+{
+    std::lock_guard< std::mutex > guard( retiredRanges->lock );
+
+    for ( const FreedRange& range : retiredRanges->ranges )
+    {
+        range.pool->allocator.free( range.offset, range.size );
+    }
+
+    retiredRanges->ranges.clear( );
+}
+
+void GeometryBuffer::flush( )
+{
+    FUNCTION_BREAK( vertexPool.dirtyRanges.empty( ) && indexPool.dirtyRanges.empty( ) )
+
+    upload( vertexPool );
+    upload( indexPool );
+    updateViews( );
+}
+
+uint64_t GeometryBuffer::write( BufferPool& pool, const void * data, const uint64_t& size, const uint64_t& alignment )
+{
+    if ( size == 0 )
+    {
+        return 0;
+    }
+
+    const uint64_t offset = pool.allocator.allocate( size, alignment );
+
+    if ( pool.content.size( ) < pool.allocator.getCapacity( ) )
+    {
+        pool.content.resize( pool.allocator.getCapacity( ) );
+    }
+
+    memcpy( pool.content.data( ) + offset, data, size );
+    markDirty( pool, offset, size );
+
+    return offset;
+}
+
+void GeometryBuffer::markDirty( BufferPool& pool, const uint64_t& offset, const uint64_t& size )
+{
+    uint64_t begin = offset;
+    uint64_t end = offset + size;
+
+    auto it = pool.dirtyRanges.upper_bound( begin );
+
+    if ( it != pool.dirtyRanges.begin( ) && std::prev( it )->second >= begin )
+    {
+        --it;
+        begin = it->first;
+    }
+
+    while ( it != pool.dirtyRanges.end( ) && it->first <= end )
+    {
+        end = std::max( end, it->second );
+        it = pool.dirtyRanges.erase( it );
+    }
+
+    pool.dirtyRanges[ begin ] = end;
+}
+
+void GeometryBuffer::upload( BufferPool& pool )
+{
+    FUNCTION_BREAK( pool.dirtyRanges.empty( ) || pool.content.empty( ) )
+
+    // Only ranges written since the last upload are copied. The copies are ordered after the submitted frames reading the buffer
+    if ( pool.resource != nullptr && pool.resource->dataAttachment->size == pool.content.size( ) )
+    {
+        for ( const auto& [ offset, end ] : pool.dirtyRanges )
+        {
+            pool.resource->write( offset, pool.content.data( ) + offset, end - offset );
+        }
+
+        pool.dirtyRanges.clear( );
+        return;
+    }
+
+    pool.dirtyRanges.clear( );
+
+    // The pool grew, the buffer is recreated with the new capacity. The old one is retired by the provider once no frame reads it
+    if ( pool.resource != nullptr )
+    {
+        pool.resource->deallocate( );
+    }
+
+    ShaderResourceRequest request { };
+    request.type = pool.type;
+    request.loadStrategy = ResourceLoadStrategy::LoadOnce;
+    request.persistStrategy = ResourcePersistStrategy::StoreOnDeviceMemory;
+    request.shaderStage = ResourceShaderStage::Vertex;
+
+    pool.resource = renderDevice->getResourceProvider( )->createResource( request );
+    pool.resource->identifier = { pool.name };
+    pool.resource->dataAttachment = std::make_unique< IDataAttachment >( false ); // Content is owned by the pool
+    pool.resource->dataAttachment->content = pool.content.data( );
+    pool.resource->dataAttachment->size = pool.content.size( );
+    pool.resource->allocate( );
+}
+
+void GeometryBuffer::updateViews( )
+{
+    void * vertexBuffer = vertexPool.resource == nullptr ? nullptr : vertexPool.resource->apiSpecificBuffer;
+    void * indexBuffer = indexPool.resource == nullptr ? nullptr : indexPool.resource->apiSpecificBuffer;
+
+    for ( auto& [ geometryIdx, allocation ] : allocations )
+    {
+        for ( auto& subAllocation : allocation.subGeometries )
+        {
+            subAllocation.vertices->apiSpecificBuffer = vertexBuffer;
+
+            if ( subAllocation.indices != nullptr )
+            {
+                subAllocation.indices->apiSpecificBuffer = indexBuffer;
+            }
+        }
+    }
+}
+
+GeometryBuffer::~GeometryBuffer( )
+{
+    for ( auto pool : { &vertexPool, &indexPool } )
+    {
+        if ( pool->resource != nullptr )
+        {
+            pool->resource->deallocate( );
+        }
+    }
+}
+
+END_NAMESPACES
@@ -17,25 +17,29 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <BlazarGraphics/RenderGraph/GlobalResourceTable.h>
+#include <boost/functional/hash.hpp>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
 GlobalResourceTable::GlobalResourceTable( IRenderDevice* renderDevice, AssetManager* assetManager ) : renderDevice( renderDevice ), assetManager( assetManager )
 {
 	frameResources.resize( renderDevice->getFrameCount( ) );
+	uniformRings.resize( renderDevice->getFrameCount( ) );
+	instancePools.resize( renderDevice->getFrameCount( ) );
 
     dummy = std::make_unique< ECS::DynamicGameEntity >( );
 	resourceBinder = std::make_unique< ShaderUniformBinder >( );
+	geometryBuffer = std::make_unique< GeometryBuffer >( this->renderDevice );
+	instanceDataBinderIdx = resourceBinder->getBinderIdx( StaticVars::getInputName( StaticVars::ShaderInput::InstanceData ) );
 
 	auto createPrimitiveEntityWrapper = [ = ]( const PrimitiveType& type )
 	{
-		auto primitive = assetManager->getPrimitive( type );
-		SubMeshGeometry& subGeometry = primitive.subGeometries[ 0 ];
-
 		EntityWrapper entityWrapper = { };
 		entityWrapper.entity = dummy.get( );
-		entityWrapper.geometryRef = assetManager->getPrimitive( type );
-		entityWrapper.subGeometries.push_back( createGeometryData( dummy.get( ), subGeometry ) );
+		entityWrapper.geometryIdx = static_cast< int >( type );
+
+		const auto& allocation = geometryBuffer->acquire( entityWrapper.geometryIdx, assetManager->getPrimitive( type ) );
+		entityWrapper.subGeometries.push_back( createGeometryData( dummy.get( ), allocation.subGeometries[ 0 ] ) );
 
 		return entityWrapper;
 	};
@@ -48,6 +52,256 @@ GlobalResourceTable::GlobalResourceTable( IRenderDevice* renderDevice, AssetMana
 void GlobalResourceTable::resetTable( ECS::ComponentTable * componentTable, const uint32_t& frameIndex )
 {
 	currentComponentTable = componentTable;
+
+	// The frame's previous submission has finished, its uniforms can be overwritten
+	uniformRings[ frameIndex ].activeChunk = 0;
+	uniformRings[ frameIndex ].head = 0;
+
+	geometryBuffer->flush( );
+	buildInstanceBatches( );
+}
+
+void GlobalResourceTable::buildInstanceBatches( )
+{
+	if ( instanceBatchesDirty )
+	{
+		groupInstanceBatches( );
+		instanceBatchesDirty = false;
+	}
+
+	// Only compares transforms, matrices of a batch are rebuilt and uploaded once one of them moved
+	for ( auto& wrapper : geometryList )
+	{
+		SKIP_ITERATION_IF( wrapper.drawnAsInstance || wrapper.subGeometries.empty( ) )
+
+		const bool moved = refreshInstanceTransforms( wrapper );
+		wrapper.instanceDataDirty = wrapper.instanceDataDirty || moved;
+	}
+}
+
+void GlobalResourceTable::groupInstanceBatches( )
+{
+	instanceBatchMap.clear( );
+
+	for ( uint32_t i = 0; i < geometryList.size( ); ++i )
+	{
+		EntityWrapper& wrapper = geometryList[ i ];
+		wrapper.batchedEntities.clear( );
+		wrapper.drawnAsInstance = false;
+		wrapper.instanceDataDirty = true;
+
+		// Removed entities keep their slot in the list without any geometry
+		SKIP_ITERATION_IF( wrapper.subGeometries.empty( ) || !canBeInstanced( wrapper.entity ) )
+
+		auto& batchLeaders = instanceBatchMap[ getInstanceBatchKey( wrapper.entity ) ];
+
+		for ( const uint32_t& leaderIdx : batchLeaders )
+		{
+			EntityWrapper& leader = geometryList[ leaderIdx ];
+
+			if ( isInstanceCompatible( leader.entity, wrapper.entity ) )
+			{
+				leader.batchedEntities.push_back( wrapper.entity );
+				wrapper.drawnAsInstance = true;
+				break;
+			}
+		}
+
+		if ( !wrapper.drawnAsInstance )
+		{
+			batchLeaders.push_back( i );
+		}
+	}
+}
+
+bool GlobalResourceTable::refreshInstanceTransforms( EntityWrapper& wrapper )
+{
+	// Batched entities cannot have instances of their own, a wrapper has either of them
+	const auto instances = wrapper.entity->getComponent< ECS::CInstances >( );
+	const size_t instanceCount = instances == nullptr ? wrapper.batchedEntities.size( ) : instances->transforms.size( );
+
+	auto getTransform = [ & ]( const size_t& i ) -> const ECS::CTransform&
+	{
+		return instances == nullptr ? *wrapper.batchedEntities[ i ]->getComponent< ECS::CTransform >( ) : instances->transforms[ i ];
+	};
+
+	bool moved = wrapper.instanceTransforms.size( ) != instanceCount;
+
+	for ( size_t i = 0; i < instanceCount && !moved; ++i )
+	{
+		moved = !isSameTransform( wrapper.instanceTransforms[ i ], getTransform( i ) );
+	}
+
+	if ( !moved )
+	{
+		return false;
+	}
+
+	wrapper.instanceTransforms.resize( instanceCount );
+
+	for ( size_t i = 0; i < instanceCount; ++i )
+	{
+		const ECS::CTransform& transform = getTransform( i );
+		wrapper.instanceTransforms[ i ] = { transform.position, transform.scale, transform.rotation };
+	}
+
+	return true;
+}
+
+bool GlobalResourceTable::isSameTransform( const InstanceTransform& lhs, const ECS::CTransform& rhs )
+{
+	return lhs.position == rhs.position &&
+		lhs.scale == rhs.scale &&
+		lhs.rotation.euler == rhs.rotation.euler &&
+		lhs.rotation.rotationUnit == rhs.rotation.rotationUnit;
+}
+
+void GlobalResourceTable::allocateInstanceData( const int& frameIndex, EntityWrapper& wrapper )
+{
+	if ( wrapper.instanceDataDirty )
+	{
+		wrapper.instanceData = wrapper.batchedEntities.empty( ) ?
+			DataAttachmentFormatter::formatInstances( wrapper.entity->getComponent< ECS::CInstances >( ), wrapper.entity ) :
+			DataAttachmentFormatter::formatInstanceBatch( wrapper.batchedEntities );
+
+		wrapper.instanceDataDirty = false;
+		++wrapper.instanceDataVersion;
+	}
+
+	if ( wrapper.instanceBuffers.empty( ) )
+	{
+		wrapper.instanceBuffers.resize( renderDevice->getFrameCount( ) );
+	}
+
+	InstanceBuffer& instanceBuffer = wrapper.instanceBuffers[ frameIndex ];
+	const InstancePool& pool = instancePools[ frameIndex ];
+
+	FUNCTION_BREAK( instanceBuffer.view != nullptr && instanceBuffer.version == wrapper.instanceDataVersion && instanceBuffer.poolGeneration == pool.generation )
+
+	const uint64_t size = wrapper.instanceData.size( ) * sizeof( glm::mat4 );
+	reserveInstanceBuffer( frameIndex, instanceBuffer, size );
+
+	pool.resource->write( instanceBuffer.offset, wrapper.instanceData.data( ), size );
+
+	// Every draw binds the whole pool, so one descriptor set serves the pool buffer, draws select their range through firstInstance
+	instanceBuffer.view->apiSpecificBuffer = pool.resource->apiSpecificBuffer;
+	instanceBuffer.version = wrapper.instanceDataVersion;
+	instanceBuffer.poolGeneration = pool.generation;
+}
+
+void GlobalResourceTable::reserveInstanceBuffer( const int& frameIndex, InstanceBuffer& instanceBuffer, const uint64_t& size )
+{
+	InstancePool& pool = instancePools[ frameIndex ];
+
+	if ( instanceBuffer.view == nullptr )
+	{
+		// Not allocated, the view only points into the pool which owns the buffer
+		instanceBuffer.view = std::make_shared< ShaderResource >( );
+		instanceBuffer.view->identifier = { StaticVars::getInputName( StaticVars::ShaderInput::InstanceData ) };
+		instanceBuffer.view->type = ResourceType::StorageBuffer;
+		instanceBuffer.view->loadStrategy = ResourceLoadStrategy::LoadPerFrame;
+	}
+
+	// Only grow the range, smaller instance sets are written into the existing one
+	if ( size > instanceBuffer.capacity )
+	{
+		pool.allocator.free( instanceBuffer.offset, instanceBuffer.capacity );
+
+		instanceBuffer.offset = pool.allocator.allocate( size, INSTANCE_POOL_ALIGNMENT );
+		instanceBuffer.capacity = size;
+	}
+
+	FUNCTION_BREAK( pool.resource != nullptr && pool.capacity == pool.allocator.getCapacity( ) )
+
+	// Draws recorded before the growth still read the old buffer, the provider retires it with the submission flushing this frame's passes
+	freeResource( pool.resource );
+
+	pool.capacity = pool.allocator.getCapacity( );
+	pool.resource = createResource( ResourceType::StorageBuffer );
+	pool.resource->identifier = { StaticVars::getInputName( StaticVars::ShaderInput::InstanceData ) };
+	pool.resource->dataAttachment = std::make_unique< IDataAttachment >( false );
+	pool.resource->dataAttachment->size = pool.capacity;
+	pool.resource->allocate( );
+
+	++pool.generation;
+}
+
+bool GlobalResourceTable::canBeInstanced( ECS::IGameEntity * entity )
+{
+	// These either select a different pipeline or carry per entity shader inputs
+	return entity->hasComponent< ECS::CTransform >( ) &&
+		!entity->hasComponent< ECS::CInstances >( ) &&
+		!entity->hasComponent< ECS::CAnimState >( ) &&
+		!entity->hasComponent< ECS::COutlined >( ) &&
+		!entity->hasComponent< ECS::CTessellation >( );
+}
+
+size_t GlobalResourceTable::getInstanceBatchKey( ECS::IGameEntity * entity )
+{
+	size_t key = 0;
+
+	boost::hash_combine( key, entity->getComponent< ECS::CMesh >( )->geometryRefIdx );
+
+	if ( const auto material = entity->getComponent< ECS::CMaterial >( ); material != nullptr )
+	{
+		for ( const auto& texture : material->textures )
+		{
+			boost::hash_combine( key, texture.path );
+		}
+
+		boost::hash_combine( key, material->heightMap.path );
+	}
+
+	return key;
+}
+
+bool GlobalResourceTable::isInstanceCompatible( ECS::IGameEntity * lhs, ECS::IGameEntity * rhs )
+{
+	const auto lhsMesh = lhs->getComponent< ECS::CMesh >( );
+	const auto rhsMesh = rhs->getComponent< ECS::CMesh >( );
+
+	if ( lhsMesh->geometryRefIdx != rhsMesh->geometryRefIdx || lhsMesh->cullMode != rhsMesh->cullMode )
+	{
+		return false;
+	}
+
+	const auto lhsMaterial = lhs->getComponent< ECS::CMaterial >( );
+	const auto rhsMaterial = rhs->getComponent< ECS::CMaterial >( );
+
+	if ( lhsMaterial == nullptr || rhsMaterial == nullptr )
+	{
+		return lhsMaterial == rhsMaterial;
+	}
+
+	auto isSameTexture = [ ]( const ECS::Material::TextureInfo& t1, const ECS::Material::TextureInfo& t2 )
+	{
+		return t1.path == t2.path &&
+			t1.isInMemory == t2.isInMemory &&
+			t1.inMemoryTexture.contents == t2.inMemoryTexture.contents &&
+			t1.magFilter == t2.magFilter &&
+			t1.minFilter == t2.minFilter &&
+			t1.U == t2.U &&
+			t1.V == t2.V &&
+			t1.W == t2.W;
+	};
+
+	if ( lhsMaterial->textures.size( ) != rhsMaterial->textures.size( ) || !isSameTexture( lhsMaterial->heightMap, rhsMaterial->heightMap ) )
+	{
+		return false;
+	}
+
+	for ( uint32_t i = 0; i < lhsMaterial->textures.size( ); ++i )
+	{
+		if ( !isSameTexture( lhsMaterial->textures[ i ], rhsMaterial->textures[ i ] ) )
+		{
+			return false;
+		}
+	}
+
+	return lhsMaterial->diffuse == rhsMaterial->diffuse &&
+		lhsMaterial->specular == rhsMaterial->specular &&
+		lhsMaterial->shininess == rhsMaterial->shininess &&
+		lhsMaterial->textureScale == rhsMaterial->textureScale;
 }
 
 void GlobalResourceTable::resetFrame( const int& frameIdx )
@@ -57,6 +311,8 @@ void GlobalResourceTable::resetFrame( const int& frameIdx )
 
 void GlobalResourceTable::addEntity( ECS::IGameEntity * entity )
 {
+	instanceBatchesDirty = true;
+
 	createGeometry( entity );
 	createGeometryList( entity->getChildren( ) );
 }
@@ -71,6 +327,8 @@ void GlobalResourceTable::removeEntity( ECS::IGameEntity * entity )
 {
 	FUNCTION_BREAK( entity->getUID( ) >= entityGeometryMap.size( ) );
 
+	instanceBatchesDirty = true;
+
 	for ( int idx : entityGeometryMap[ entity->getUID( ) ] )
 	{
 		auto& geometryData = geometryList[ idx ];
@@ -79,7 +337,15 @@ void GlobalResourceTable::removeEntity( ECS::IGameEntity * entity )
 		{
 			cleanGeometryData( subGeometry );
 		}
+
+		cleanInstanceBuffers( geometryData );
+
+		geometryBuffer->release( geometryData.geometryIdx );
+		geometryData.subGeometries.clear( );
 	}
+
+	// The geometry references were released above, a second remove or update must not release them again
+	entityGeometryMap[ entity->getUID( ) ].clear( );
 }
 
 void GlobalResourceTable::createGeometry( ECS::IGameEntity * entity )
@@ -96,12 +362,8 @@ void GlobalResourceTable::createGeometry( ECS::IGameEntity * entity )
 		entityGeometryMap.resize( entity->getUID( ) + 1 );
 	}
 
-	entityGeometryMap[ entity->getUID( ) ] = { };
-
-	for ( uint32_t i = geometryList.size( ) - entityGeometries.subGeometries.size( ); i < geometryList.size( ); ++i )
-	{
-		entityGeometryMap[ entity->getUID( ) ].push_back( i );
-	}
+	// One wrapper per entity holds all of its sub geometries
+	entityGeometryMap[ entity->getUID( ) ] = { static_cast< uint32_t >( geometryList.size( ) - 1 ) };
 }
 
 EntityWrapper GlobalResourceTable::createGeometryData( ECS::IGameEntity * entity )
@@ -113,59 +375,30 @@ EntityWrapper GlobalResourceTable::createGeometryData( ECS::IGameEntity * entity
 
 	std::string parentBoundingName = StaticVars::getInputName( StaticVars::ShaderInput::GeometryData );
 
-	MeshGeometry geometry = assetManager->getMeshGeometry( meshComponent->geometryRefIdx );
-
 	EntityWrapper result = { };
 	result.entity = entity;
+	result.geometryIdx = meshComponent->geometryRefIdx;
+
+	// Entities sharing a mesh share its vertices and indices
+	const auto& allocation = geometryBuffer->acquire( result.geometryIdx, assetManager->getMeshGeometry( result.geometryIdx ) );
 
-	for ( SubMeshGeometry& subMeshGeometry : geometry.subGeometries )
+	for ( const SubGeometryAllocation& subAllocation : allocation.subGeometries )
 	{
-		result.subGeometries.push_back( std::move( createGeometryData( entity, subMeshGeometry ) ) );
+		result.subGeometries.push_back( std::move( createGeometryData( entity, subAllocation ) ) );
 	}
 
-	result.geometryRef = std::move( geometry );
-
 	return std::move( result );
 }
 
-GeometryData GlobalResourceTable::createGeometryData( ECS::IGameEntity * entity, SubMeshGeometry& subMeshGeometry )
+GeometryData GlobalResourceTable::createGeometryData( ECS::IGameEntity * entity, const SubGeometryAllocation& allocation )
 {
 	GeometryData data{ };
-	data.subMeshGeometry = subMeshGeometry;
 
-	/*
-	* Create vertex data:
-	*/
-	auto vertices = createResource( ResourceType::VertexData, ResourceLoadStrategy::LoadOnce );
+	data.resources.push_back( { true, allocation.vertices } );
 
-	vertices->identifier = { "VertexData" };
-
-	std::unique_ptr< VertexData > vertexData = std::make_unique< VertexData >( );
-	vertexData->vertexCount = subMeshGeometry.vertexCount;
-	vertexData->content = subMeshGeometry.dataRaw.data( );
-	vertexData->size = subMeshGeometry.dataRaw.size( ) * sizeof( float );
-
-	vertices->dataAttachment = std::move( vertexData );
-	vertices->allocate( );
-
-	data.resources.push_back( { true, std::move( vertices ) } );
-	// ---
-
-	/*
-	 * Create index data:
-	 */
-	if ( !subMeshGeometry.indices.empty( ) )
+	if ( allocation.indices != nullptr )
 	{
-		auto indices = createResource( ResourceType::IndexData, ResourceLoadStrategy::LoadOnce );
-		indices->identifier = { "IndexData" };
-		std::unique_ptr< IndexData > indexData = std::make_unique< IndexData >( );
-		indexData->indexCount = subMeshGeometry.indices.size( );
-		indexData->content = subMeshGeometry.indices.data( );
-		indexData->size = subMeshGeometry.indices.size( ) * sizeof( uint32_t );
-		indices->dataAttachment = std::move( indexData );
-		indices->allocate( );
-
-		data.resources.push_back( { true, std::move( indices ) } );
+		data.resources.push_back( { true, allocation.indices } );
 	}
 
 	for ( const auto& loadOnceBinder : resourceBinder->getAllLoadOnceAllocators( ) )
@@ -200,7 +433,7 @@ void GlobalResourceTable::attachAllAttachments( const IShaderUniform* content, c
 
 void GlobalResourceTable::attachUniformAttachment( const IShaderUniform* content, const std::shared_ptr<ShaderResource>& resource ) const
 {
-	if ( content->resourceType == ResourceType::Uniform || content->resourceType == ResourceType::PushConstant )
+	if ( content->resourceType == ResourceType::Uniform || content->resourceType == ResourceType::PushConstant || content->resourceType == ResourceType::StorageBuffer )
 	{
 		if ( resource->dataAttachment == nullptr )
 		{
@@ -307,6 +540,75 @@ void GlobalResourceTable::allocateResource( const int& resourceIdx, const std::s
 	}
 }
 
+void GlobalResourceTable::allocateRingResource( const int& resourceIdx, const std::string& uniformName, const uint32_t& frameIndex, const IShaderUniform* content )
+{
+	if ( resourceIdx >= frameResources[ frameIndex ].size( ) )
+	{
+		frameResources[ frameIndex ].resize( resourceIdx + 1 );
+	}
+
+	const auto* pUniform = dynamic_cast< const StructShaderUniform* >( content );
+
+	UniformRingChunk& chunk = getRingChunk( frameIndex, pUniform->size );
+	UniformRing& ring = uniformRings[ frameIndex ];
+
+	const uint64_t offset = ring.head;
+	chunk.resource->write( offset, pUniform->data, pUniform->size );
+	ring.head = ( ( offset + pUniform->size + UNIFORM_RING_ALIGNMENT - 1 ) / UNIFORM_RING_ALIGNMENT ) * UNIFORM_RING_ALIGNMENT;
+
+	free( pUniform->data );
+
+	// Not marked as allocated, the wrapper only points into the ring chunk which owns the buffer
+	auto& wrapper = frameResources[ frameIndex ][ resourceIdx ];
+
+	if ( wrapper.ref == nullptr )
+	{
+		wrapper.ref = std::make_shared< ShaderResource >( );
+		wrapper.ref->identifier = { uniformName };
+		wrapper.ref->type = ResourceType::Uniform;
+		wrapper.ref->loadStrategy = ResourceLoadStrategy::LoadPerFrame;
+	}
+
+	wrapper.ref->apiSpecificBuffer = chunk.resource->apiSpecificBuffer;
+	wrapper.ref->bufferOffset = offset;
+}
+
+UniformRingChunk& GlobalResourceTable::getRingChunk( const uint32_t& frameIndex, const uint64_t& size )
+{
+	UniformRing& ring = uniformRings[ frameIndex ];
+
+	if ( !ring.chunks.empty( ) && ring.head + size <= ring.chunks[ ring.activeChunk ].capacity )
+	{
+		return ring.chunks[ ring.activeChunk ];
+	}
+
+	if ( !ring.chunks.empty( ) )
+	{
+		++ring.activeChunk;
+		ring.head = 0;
+	}
+
+	if ( ring.activeChunk < ring.chunks.size( ) && size <= ring.chunks[ ring.activeChunk ].capacity )
+	{
+		return ring.chunks[ ring.activeChunk ];
+	}
+
+	const uint64_t previousCapacity = ring.chunks.empty( ) ? UNIFORM_RING_CHUNK_SIZE / 2 : ring.chunks.back( ).capacity;
+
+	UniformRingChunk chunk { };
+	chunk.capacity = std::max( previousCapacity * 2, size );
+	chunk.resource = createResource( ResourceType::Uniform );
+	chunk.resource->identifier = { "UniformRing" };
+	chunk.resource->dataAttachment = std::make_unique< IDataAttachment >( false );
+	chunk.resource->dataAttachment->size = chunk.capacity;
+	chunk.resource->allocate( );
+
+	ring.activeChunk = ring.chunks.size( );
+	ring.chunks.push_back( std::move( chunk ) );
+
+	return ring.chunks.back( );
+}
+
 auto GlobalResourceTable::getSamplerDataAttachment( const ECS::Material::TextureInfo& texture ) -> std::unique_ptr< SamplerDataAttachment >
 {
 	std::unique_ptr< SamplerDataAttachment > samplerAttachment;
@@ -349,6 +651,26 @@ std::shared_ptr< ShaderResource >& GlobalResourceTable::getResource( const int&
 	return frameResources[ frameIndex ][ resourceIdx ].ref;
 }
 
+std::shared_ptr< ShaderResource >& GlobalResourceTable::getResource( EntityWrapper& wrapper, const int& resourceIdx, const uint32_t& frameIndex )
+{
+	if ( resourceIdx == instanceDataBinderIdx )
+	{
+		return wrapper.instanceBuffers[ frameIndex ].view;
+	}
+
+	return frameResources[ frameIndex ][ resourceIdx ].ref;
+}
+
+uint32_t GlobalResourceTable::getFirstInstance( const EntityWrapper& wrapper, const uint32_t& frameIndex ) const
+{
+	if ( wrapper.instanceBuffers.empty( ) )
+	{
+		return 0;
+	}
+
+	return static_cast< uint32_t >( wrapper.instanceBuffers[ frameIndex ].offset / sizeof( glm::mat4 ) );
+}
+
 void GlobalResourceTable::allocateAllPerGeometryResources( const int& frameIndex, const MeshGeometry& parent, const SubMeshGeometry& subMeshGeometry )
 {
 	for ( const int& binderIdx : perGeometryResources )
@@ -369,12 +691,25 @@ void GlobalResourceTable::allocateAllPerEntityResources( const int& frameIndex,
 	}
 }
 
-void GlobalResourceTable::allocatePerEntityResources( const int& frameIndex, ECS::IGameEntity * entity, std::vector< int > resources )
+void GlobalResourceTable::allocatePerEntityResources( const int& frameIndex, EntityWrapper& wrapper, const std::vector< int >& resources )
 {
 	for ( const int& binderIdx : resources )
 	{
+		if ( binderIdx == instanceDataBinderIdx )
+		{
+			allocateInstanceData( frameIndex, wrapper );
+			continue;
+		}
+
 		auto binder = resourceBinder->getBinderByIdx( binderIdx );
-		auto content = binder.perEntityUniformBinder( entity );
+		auto content = binder.perEntityUniformBinder( wrapper.entity );
+
+		if ( content->resourceType == ResourceType::Uniform )
+		{
+			allocateRingResource( binderIdx, binder.refUniform, frameIndex, content.get( ) );
+			continue;
+		}
+
 		allocateResource( binderIdx, binder.refUniform, frameIndex, content.get( ) );
 	}
 }
@@ -463,6 +798,19 @@ GlobalResourceTable::~GlobalResourceTable( )
 		}
 	}
 
+	for ( auto& ring : uniformRings )
+	{
+		for ( auto& chunk : ring.chunks )
+		{
+			freeResource( chunk.resource );
+		}
+	}
+
+	for ( auto& pool : instancePools )
+	{
+		freeResource( pool.resource );
+	}
+
 	auto cleanGeometryDataList = [ ]( std::vector< EntityWrapper >& geometries )
 	{
 		for ( auto& geometry : geometries )
@@ -471,6 +819,7 @@ GlobalResourceTable::~GlobalResourceTable( )
 			{
 				cleanGeometryData( subGeometry );
 			}
+
 		}
 	};
 
@@ -499,15 +848,28 @@ void GlobalResourceTable::freeResource( std::shared_ptr< ShaderResource >& resou
 
 void GlobalResourceTable::cleanGeometryData( GeometryData& geometryData )
 {
-	for ( auto& resource : geometryData.resources )
+	// Vertex and index views are released through the GeometryBuffer
+	geometryData.resources.clear( );
+
+	for ( auto& resource : geometryData.boundResources )
 	{
 		freeResource( resource.ref );
 	}
+}
 
-	for ( auto& resource : geometryData.boundResources )
+void GlobalResourceTable::cleanInstanceBuffers( EntityWrapper& wrapper )
+{
+	// Ranges are only handed out again while recording their frame, once its previous submission finished
+	for ( uint32_t frameIndex = 0; frameIndex < wrapper.instanceBuffers.size( ); ++frameIndex )
 	{
-		freeResource( resource.ref );
+		const InstanceBuffer& instanceBuffer = wrapper.instanceBuffers[ frameIndex ];
+		instancePools[ frameIndex ].allocator.free( instanceBuffer.offset, instanceBuffer.capacity );
 	}
+
+	wrapper.instanceBuffers.clear( );
+	wrapper.instanceTransforms.clear( );
+	wrapper.instanceData.clear( );
+	wrapper.instanceDataDirty = true;
 }
 
 END_NAMESPACES
\ No newline at end of file
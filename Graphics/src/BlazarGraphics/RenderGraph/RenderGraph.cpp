@@ -17,8 +17,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <BlazarGraphics/RenderGraph/RenderGraph.h>
+#include <BlazarCore/TaskPool.h>
 
 #include <utility>
+#include <set>
 #include <boost/format.hpp>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
@@ -51,23 +53,44 @@ void RenderGraph::clearGraph( )
     }
 
     this->pipelineInputOutputDependencies.clear( );
+    this->executionPlan.clear( );
     this->frameLocks.clear( );
     passes.clear( );
 }
 
 void RenderGraph::buildGraph( )
 {
+    // Shaders of every pipeline are compiled and reflected on worker threads, their inputs are gathered in order below
+    std::vector< const PipelineRequest * > pipelineRequests;
+
+    for ( const auto& pass : passes )
+    {
+        for ( const auto & pipelineRequest : pass.ref->pipelineRequests )
+        {
+            pipelineRequests.push_back( &pipelineRequest );
+        }
+    }
+
+    std::vector< std::unique_ptr< IShaderInfo > > pipelineSets( pipelineRequests.size( ) );
+
+    Core::TaskPool::run( pipelineRequests.size( ), [ & ]( const uint32_t& requestIdx )
+    {
+        pipelineSets[ requestIdx ] = renderDevice->getShaderInfo( pipelineRequests[ requestIdx ]->shaderPaths );
+    } );
+
+    uint32_t pipelineSetIndex = 0;
+
     // flatten pipeline input, saves a loop later
     for ( auto& pass : passes )
     {
         uint32_t pipelineIndex = 0;
         pass.pipelineInputsMap.resize( pass.ref->pipelineRequests.size( ) );
 
-        for ( const auto & pipelineRequest : pass.ref->pipelineRequests )
+        for ( uint32_t requestIdx = 0; requestIdx < pass.ref->pipelineRequests.size( ); ++requestIdx )
         {
             std::vector< std::string > & pipelineInputs = pass.pipelineInputs.emplace_back( );
 
-            auto pipelineSet = renderDevice->getShaderInfo( pipelineRequest.shaderPaths );
+            const auto& pipelineSet = pipelineSets[ pipelineSetIndex++ ];
 
             for ( const auto& input: pipelineSet->getMergedInputs( ) )
             {
@@ -78,69 +101,567 @@ void RenderGraph::buildGraph( )
                     pass.pipelineInputsMap[ pipelineIndex ][ input ] = true;
                 }
             }
+
+            const auto inputAttachments = pipelineSet->getInputAttachments( );
+
+            if ( pass.inputAttachments.size( ) < inputAttachments.size( ) )
+            {
+                pass.inputAttachments.resize( inputAttachments.size( ) );
+            }
+
+            // Pipelines of a subpass share its input attachments, an index has to name the same output in all of them
+            for ( uint32_t attachmentIndex = 0; attachmentIndex < inputAttachments.size( ); ++attachmentIndex )
+            {
+                std::string &inputAttachment = pass.inputAttachments[ attachmentIndex ];
+
+                SKIP_ITERATION_IF( inputAttachments[ attachmentIndex ].empty( ) )
+                ASSERT_M( inputAttachment.empty( ) || inputAttachment == inputAttachments[ attachmentIndex ], "Pipelines of a pass read different outputs through the same input attachment index!" );
+
+                inputAttachment = inputAttachments[ attachmentIndex ];
+            }
         }
     }
 
-    // build dependencies
-    for ( auto& firstPass : passes )
+    // map every output to the pass producing it, a later pass wins if two passes write the same output
+    std::unordered_map< std::string, uint32_t > outputProducers;
+    std::unordered_map< std::string, uint32_t > outputOwners; // Passes creating the image of the output
+
+    for ( uint32_t passIdx = 0; passIdx < passes.size( ); ++passIdx )
     {
-        for ( const auto& secondPass : passes )
+        for ( const auto& output : passes[ passIdx ].ref->outputs )
         {
-            for ( const auto& firstPassInput : firstPass.pipelineInputsFlat )
+            outputProducers[ output.outputResourceName ] = passIdx;
+
+            if ( !output.flags.continuesOutput )
             {
-                for ( const auto& secondPassOutput : secondPass.ref->outputs )
-                {
-                    if ( firstPassInput == secondPassOutput.outputResourceName )
-                    {
-                        firstPass.dependencies.push_back( secondPass.ref->name );
-                    }
-                }
+                outputOwners[ output.outputResourceName ] = passIdx;
             }
         }
     }
 
-    // Prepare input-output map
+    // A continued output is attached from the render target of its owner, which has to run first
+    for ( uint32_t passIdx = 0; passIdx < passes.size( ); ++passIdx )
+    {
+        PassWrapper& pass = passes[ passIdx ];
+
+        for ( const auto& output : pass.ref->outputs )
+        {
+            SKIP_ITERATION_IF( !output.flags.continuesOutput )
+
+            auto owner = outputOwners.find( output.outputResourceName );
+
+            if ( owner == outputOwners.end( ) || owner->second == passIdx || output.flags.msaaSampled || output.flags.presentedImage )
+            {
+                throw std::runtime_error( ( boost::format( "Pass %1% continues %2%, which is not a single sampled output of another pass." ) % pass.ref->name % output.outputResourceName ).str( ) );
+            }
+
+            pass.continuedOutputOwners[ output.outputResourceName ] = owner->second;
+
+            if ( std::find( pass.dependencies.begin( ), pass.dependencies.end( ), owner->second ) == pass.dependencies.end( ) )
+            {
+                pass.dependencies.push_back( owner->second );
+            }
+        }
+    }
+
+    // Async compute passes write their outputs through image stores, only plain color images can be written that way
     for ( const auto& pass : passes )
     {
-        for ( const auto& dependency : pass.dependencies )
+        SKIP_ITERATION_IF( pass.ref->renderPassRequest.queue != PassQueue::AsyncCompute )
+
+        for ( const auto& output : pass.ref->outputs )
         {
-            PassWrapper& dependencyPass = passes[ passMap[ dependency ] ];
-            for ( const auto& input : pass.pipelineInputsFlat )
+            if ( output.attachmentType != ResourceAttachmentType::Color || output.flags.msaaSampled || output.flags.presentedImage || output.flags.continuesOutput )
             {
-                for ( const auto& dependencyOutput : dependencyPass.ref->outputs )
-                {
-                    if ( input == dependencyOutput.outputResourceName )
-                    {
-                        this->pipelineInputOutputDependencies[ input ] = dependency;
-                    }
-                }
+                throw std::runtime_error( ( boost::format( "Async compute pass %1% writes %2%, which is not a single sampled color output." ) % pass.ref->name % output.outputResourceName ).str( ) );
             }
         }
     }
 
+    // build dependencies and the input-output map
+    for ( uint32_t passIdx = 0; passIdx < passes.size( ); ++passIdx )
+    {
+        PassWrapper& pass = passes[ passIdx ];
+
+        for ( const auto& input : pass.pipelineInputsFlat )
+        {
+            auto producer = outputProducers.find( input );
+
+            // A pass reading its own output sees the content of the previous frame, it does not order anything
+            SKIP_ITERATION_IF( producer == outputProducers.end( ) || producer->second == passIdx )
+
+            this->pipelineInputOutputDependencies[ input ] = passes[ producer->second ].ref->name;
+
+            if ( std::find( pass.dependencies.begin( ), pass.dependencies.end( ), producer->second ) == pass.dependencies.end( ) )
+            {
+                pass.dependencies.push_back( producer->second );
+            }
+        }
+    }
+
+    for ( auto& pass : passes )
+    {
+        for ( const uint32_t& dependency : pass.dependencies )
+        {
+            passes[ dependency ].signalsOtherQueue |= !runsOnSameQueue( pass, passes[ dependency ] );
+        }
+    }
+
+    const std::vector< bool > livePasses = findLivePasses( );
+
+    mergeSubpasses( livePasses );
+    sortPasses( livePasses );
+    inferOutputAccess( );
+    assignAliasGroups( );
+
+    // Shared allocations are sized for their largest user before any render target exists
+    for ( const uint32_t& passIdx : executionPlan )
+    {
+        // Outputs of merged passes are part of the render target of the pass they are merged into
+        SKIP_ITERATION_IF( passes[ passIdx ].mergedInto >= 0 )
+
+        for ( uint32_t frame = 0; frame < renderDevice->getFrameCount( ); ++frame )
+        {
+            renderDevice->getRenderPassProvider( )->reserveTransientMemory( createRenderTargetRequest( passes[ passIdx ], frame ) );
+        }
+    }
+
     for ( int i = 0; i < renderDevice->getFrameCount( ); ++i )
     {
         frameLocks.push_back( std::make_unique< std::mutex >( ) );
 
         // todo support threading
     }
+
+    // Fences outlive graph rebuilds, frames still in flight signal them
+    while ( frameFences.size( ) < renderDevice->getFrameCount( ) )
+    {
+        frameFences.push_back( renderDevice->getResourceProvider( )->createLock( ResourceLockType::Fence ) );
+    }
 }
 
-void RenderGraph::prepare( ECS::ComponentTable * componentTable )
+std::vector< bool > RenderGraph::findLivePasses( ) const
+{
+    std::vector< bool > livePasses( passes.size( ), false );
+    std::vector< uint32_t > pending;
+
+    for ( uint32_t passIdx = 0; passIdx < passes.size( ); ++passIdx )
+    {
+        for ( const auto& output : passes[ passIdx ].ref->outputs )
+        {
+            if ( output.flags.presentedImage )
+            {
+                pending.push_back( passIdx );
+            }
+        }
+    }
+
+    // Without a presenting pass nothing can be proven unused, keep every pass
+    if ( pending.empty( ) )
+    {
+        return std::vector< bool >( passes.size( ), true );
+    }
+
+    while ( !pending.empty( ) )
+    {
+        const uint32_t passIdx = pending.back( );
+        pending.pop_back( );
+
+        SKIP_ITERATION_IF( livePasses[ passIdx ] )
+        livePasses[ passIdx ] = true;
+
+        for ( const uint32_t& dependency : passes[ passIdx ].dependencies )
+        {
+            pending.push_back( dependency );
+        }
+    }
+
+    return livePasses;
+}
+
+void RenderGraph::mergeSubpasses( const std::vector< bool >& livePasses )
+{
+    for ( uint32_t passIdx = 0; passIdx < passes.size( ); ++passIdx )
+    {
+        PassWrapper& pass = passes[ passIdx ];
+
+        SKIP_ITERATION_IF( !livePasses[ passIdx ] || pass.inputAttachments.empty( ) )
+
+        // Input attachments are read at the same pixel within one render pass, they all have to come from the same producer
+        int32_t producerIdx = -1;
+
+        for ( const auto& input : pass.inputAttachments )
+        {
+            SKIP_ITERATION_IF( input.empty( ) )
+
+            auto find = pipelineInputOutputDependencies.find( input );
+
+            if ( find == pipelineInputOutputDependencies.end( ) )
+            {
+                throw std::runtime_error( ( boost::format( "Pass %1% reads %2% as an input attachment, but no other pass produces it." ) % pass.ref->name % input ).str( ) );
+            }
+
+            const auto producer = static_cast< int32_t >( passMap[ find->second ] );
+
+            if ( producerIdx >= 0 && producer != producerIdx )
+            {
+                throw std::runtime_error( ( boost::format( "Input attachments of pass %1% are produced by more than one pass." ) % pass.ref->name ).str( ) );
+            }
+
+            producerIdx = producer;
+
+            const auto& outputs = passes[ producerIdx ].ref->outputs;
+            const auto output = std::find_if( outputs.begin( ), outputs.end( ), [ & ]( const OutputImage& candidate ) { return candidate.outputResourceName == input; } );
+
+            // Depth and stencil attachments are read through their depth aspect, there is nothing to read from a stencil only one
+            if ( output->attachmentType == ResourceAttachmentType::Stencil )
+            {
+                throw std::runtime_error( ( boost::format( "Pass %1% reads %2% as an input attachment, only color and depth outputs can be read that way." ) % pass.ref->name % input ).str( ) );
+            }
+        }
+
+        SKIP_ITERATION_IF( producerIdx < 0 )
+
+        PassWrapper& producer = passes[ producerIdx ];
+
+        if ( !canMergeInto( pass, producer ) || producer.mergedInto >= 0 || !pass.mergedPasses.empty( ) )
+        {
+            throw std::runtime_error( ( boost::format( "Pass %1% reads outputs of %2% as input attachments, but cannot be merged into its render pass." ) % pass.ref->name % producer.ref->name ).str( ) );
+        }
+
+        pass.mergedInto = producerIdx;
+        pass.subpass = producer.mergedPasses.size( ) + 1;
+        producer.mergedPasses.push_back( passIdx );
+
+        // The pass is submitted with its producer, which takes over its other dependencies and its dependents on the other queue
+        for ( const uint32_t& dependency : pass.dependencies )
+        {
+            if ( static_cast< int32_t >( dependency ) != producerIdx && std::find( producer.dependencies.begin( ), producer.dependencies.end( ), dependency ) == producer.dependencies.end( ) )
+            {
+                producer.dependencies.push_back( dependency );
+            }
+        }
+
+        producer.signalsOtherQueue |= pass.signalsOtherQueue;
+        pass.signalsOtherQueue = false;
+    }
+}
+
+bool RenderGraph::canMergeInto( const PassWrapper& pass, const PassWrapper& producer )
+{
+    const RenderPassRequest& request = pass.ref->renderPassRequest;
+    const RenderPassRequest& producerRequest = producer.ref->renderPassRequest;
+
+    // Input attachments are read with the sample count of the subpass, multisampled and presented outputs keep their own pass
+    auto hasPlainOutputs = [ ]( const Pass * ref )
+    {
+        return std::none_of( ref->outputs.begin( ), ref->outputs.end( ), [ ]( const OutputImage& output )
+        {
+            return output.flags.msaaSampled || output.flags.presentedImage || output.flags.continuesOutput;
+        } );
+    };
+
+    const bool sameRenderArea = request.renderArea.x == producerRequest.renderArea.x && request.renderArea.y == producerRequest.renderArea.y &&
+                                request.renderArea.width == producerRequest.renderArea.width && request.renderArea.height == producerRequest.renderArea.height;
+
+    return sameRenderArea && hasPlainOutputs( pass.ref ) && hasPlainOutputs( producer.ref ) &&
+           request.queue == PassQueue::Graphics && producerRequest.queue == PassQueue::Graphics &&
+           request.dependencySet == DependencySet::DefaultColor && producerRequest.dependencySet == DependencySet::DefaultColor &&
+           !request.isFinalDrawPass && !producerRequest.isFinalDrawPass;
+}
+
+void RenderGraph::sortPasses( const std::vector< bool >& livePasses )
 {
-    // Last pass should always be the render pass!
-    PassWrapper& lastPass = passes[ passes.size( ) - 1 ];
-    if ( !lastPass.executeLocks.empty( ) ) // make sure it is not the very first frame
+    std::vector< uint32_t > remainingDependencies( passes.size( ), 0 );
+    std::vector< std::vector< uint32_t > > dependents( passes.size( ) );
+
+    for ( uint32_t passIdx = 0; passIdx < passes.size( ); ++passIdx )
+    {
+        SKIP_ITERATION_IF( !livePasses[ passIdx ] )
+
+        remainingDependencies[ passIdx ] = passes[ passIdx ].dependencies.size( );
+
+        for ( const uint32_t& dependency : passes[ passIdx ].dependencies )
+        {
+            dependents[ dependency ].push_back( passIdx );
+        }
+    }
+
+    // Ready passes are taken in insertion order, independent passes keep the order they were added in.
+    // Async compute passes are taken first so their work overlaps with the graphics passes submitted after them
+    std::set< std::pair< bool, uint32_t > > ready;
+
+    auto readyKey = [ & ]( const uint32_t& passIdx )
     {
-        lastPass.executeLocks[ frameIndex ]->wait( );
+        return std::make_pair( passes[ passIdx ].ref->renderPassRequest.queue != PassQueue::AsyncCompute, passIdx );
+    };
+
+    for ( uint32_t passIdx = 0; passIdx < passes.size( ); ++passIdx )
+    {
+        if ( livePasses[ passIdx ] && remainingDependencies[ passIdx ] == 0 )
+        {
+            ready.insert( readyKey( passIdx ) );
+        }
     }
 
+    executionPlan.clear( );
+
+    while ( !ready.empty( ) )
+    {
+        const uint32_t passIdx = ready.begin( )->second;
+        ready.erase( ready.begin( ) );
+
+        // Merged passes directly follow the pass they are merged into, their other dependencies are done before it
+        std::vector< uint32_t > taken { passIdx };
+        taken.insert( taken.end( ), passes[ passIdx ].mergedPasses.begin( ), passes[ passIdx ].mergedPasses.end( ) );
+
+        for ( const uint32_t& takenIdx : taken )
+        {
+            executionPlan.push_back( takenIdx );
+
+            for ( const uint32_t& dependent : dependents[ takenIdx ] )
+            {
+                if ( --remainingDependencies[ dependent ] == 0 && passes[ dependent ].mergedInto < 0 )
+                {
+                    ready.insert( readyKey( dependent ) );
+                }
+            }
+        }
+    }
+
+    const auto liveCount = static_cast< size_t >( std::count( livePasses.begin( ), livePasses.end( ), true ) );
+
+    if ( executionPlan.size( ) != liveCount )
+    {
+        std::string cycle;
+
+        for ( uint32_t passIdx = 0; passIdx < passes.size( ); ++passIdx )
+        {
+            if ( livePasses[ passIdx ] && remainingDependencies[ passIdx ] > 0 )
+            {
+                cycle += ( cycle.empty( ) ? "" : ", " ) + passes[ passIdx ].ref->name;
+            }
+        }
+
+        throw std::runtime_error( "Render graph contains a dependency cycle between passes: " + cycle );
+    }
+}
+
+void RenderGraph::inferOutputAccess( )
+{
+    auto readsAsInputAttachment = [ & ]( const uint32_t& readerIdx, const uint32_t& producerIdx, const std::string& outputName )
+    {
+        const auto& inputAttachments = passes[ readerIdx ].inputAttachments;
+        return passes[ readerIdx ].mergedInto == static_cast< int32_t >( producerIdx ) &&
+               std::find( inputAttachments.begin( ), inputAttachments.end( ), outputName ) != inputAttachments.end( );
+    };
+
+    // Includes the producer itself, which reads the content of the previous frame. Input attachments are read within the render pass
+    auto isRead = [ & ]( const uint32_t& producerIdx, const std::string& outputName )
+    {
+        return std::any_of( executionPlan.begin( ), executionPlan.end( ), [ & ]( const uint32_t& readerIdx )
+        {
+            const auto& inputs = passes[ readerIdx ].pipelineInputsFlat;
+            return std::find( inputs.begin( ), inputs.end( ), outputName ) != inputs.end( ) && !readsAsInputAttachment( readerIdx, producerIdx, outputName );
+        } );
+    };
+
+    auto isReadOnOtherQueue = [ & ]( const uint32_t& producerIdx, const std::string& outputName )
+    {
+        return std::any_of( executionPlan.begin( ), executionPlan.end( ), [ & ]( const uint32_t& readerIdx )
+        {
+            const auto& inputs = passes[ readerIdx ].pipelineInputsFlat;
+            return std::find( inputs.begin( ), inputs.end( ), outputName ) != inputs.end( ) && !runsOnSameQueue( passes[ readerIdx ], passes[ producerIdx ] );
+        } );
+    };
+
+    auto isInputAttachment = [ & ]( const uint32_t& producerIdx, const std::string& outputName )
+    {
+        const auto& mergedPasses = passes[ producerIdx ].mergedPasses;
+
+        return std::any_of( mergedPasses.begin( ), mergedPasses.end( ), [ & ]( const uint32_t& readerIdx )
+        {
+            return readsAsInputAttachment( readerIdx, producerIdx, outputName );
+        } );
+    };
+
+    // Passes after the position attaching the same image load its content
+    auto isContinuedAfter = [ & ]( const uint32_t& position, const uint32_t& ownerIdx, const std::string& outputName )
+    {
+        return std::any_of( executionPlan.begin( ) + position + 1, executionPlan.end( ), [ & ]( const uint32_t& passIdx )
+        {
+            const auto& owners = passes[ passIdx ].continuedOutputOwners;
+            const auto find = owners.find( outputName );
+            return find != owners.end( ) && find->second == ownerIdx;
+        } );
+    };
+
+    for ( uint32_t position = 0; position < executionPlan.size( ); ++position )
+    {
+        const uint32_t passIdx = executionPlan[ position ];
+        Pass * pass = passes[ passIdx ].ref;
+
+        // A triangle covering the whole target writes every pixel, unless the pass discards fragments
+        const bool coversTarget = pass->inputGeometry == InputGeometry::OverSizedTriangle && !pass->discardsFragments;
+
+        for ( auto& output : pass->outputs )
+        {
+            const uint32_t ownerIdx = output.flags.continuesOutput ? passes[ passIdx ].continuedOutputOwners[ output.outputResourceName ] : passIdx;
+
+            output.access.overwritten = coversTarget && output.attachmentType == ResourceAttachmentType::Color && !output.flags.msaaSampled && !output.flags.continuesOutput;
+            output.access.attachedAfterPass = isContinuedAfter( position, ownerIdx, output.outputResourceName );
+            output.access.readAfterPass = output.flags.presentedImage || output.access.attachedAfterPass || isRead( passIdx, output.outputResourceName );
+            output.access.inputAttachment = isInputAttachment( passIdx, output.outputResourceName );
+            output.access.storageImage = pass->renderPassRequest.queue == PassQueue::AsyncCompute;
+            output.access.sharedAcrossQueues = isReadOnOtherQueue( passIdx, output.outputResourceName );
+        }
+    }
+}
+
+void RenderGraph::assignAliasGroups( )
+{
+    std::unordered_map< std::string, uint32_t > producerCount;
+
+    for ( const uint32_t& passIdx : executionPlan )
+    {
+        for ( const auto& output : passes[ passIdx ].ref->outputs )
+        {
+            ++producerCount[ output.outputResourceName ];
+        }
+    }
+
+    struct AliasGroup
+    {
+        uint32_t lastUse;
+        bool depth;
+    };
+
+    std::vector< AliasGroup > groups;
+
+    // Plan positions are submission order, an output is alive from the position of its producer to the position of its last reader
+    for ( uint32_t position = 0; position < executionPlan.size( ); ++position )
+    {
+        PassWrapper& pass = passes[ executionPlan[ position ] ];
+        pass.aliasGroups.assign( pass.ref->outputs.size( ), -1 );
+
+        SKIP_ITERATION_IF( !canAliasOutputs( pass ) )
+
+        // Outputs of a merged pass are written within the render pass of its producer, which directly precedes it
+        const uint32_t firstUse = position - pass.subpass;
+
+        for ( uint32_t outputIdx = 0; outputIdx < pass.ref->outputs.size( ); ++outputIdx )
+        {
+            const OutputImage& output = pass.ref->outputs[ outputIdx ];
+
+            SKIP_ITERATION_IF( output.flags.presentedImage || producerCount[ output.outputResourceName ] > 1 )
+
+            bool transient = true;
+            uint32_t lastUse = position;
+
+            for ( uint32_t readerPosition = 0; readerPosition < executionPlan.size( ) && transient; ++readerPosition )
+            {
+                const PassWrapper& reader = passes[ executionPlan[ readerPosition ] ];
+                const auto& inputs = reader.pipelineInputsFlat;
+
+                SKIP_ITERATION_IF( std::find( inputs.begin( ), inputs.end( ), output.outputResourceName ) == inputs.end( ) )
+
+                // Reading the content of the previous frame or from another queue requires the output to stay intact
+                transient = readerPosition > position && runsOnSameQueue( reader, pass );
+                lastUse = std::max( lastUse, readerPosition );
+            }
+
+            SKIP_ITERATION_IF( !transient )
+
+            const bool depth = output.attachmentType != ResourceAttachmentType::Color;
+
+            // Color and depth images usually live in different memory types, they are kept in separate groups
+            auto group = std::find_if( groups.begin( ), groups.end( ), [ & ]( const AliasGroup& candidate )
+            {
+                return candidate.depth == depth && candidate.lastUse < firstUse;
+            } );
+
+            if ( group == groups.end( ) )
+            {
+                group = groups.insert( groups.end( ), AliasGroup { lastUse, depth } );
+            }
+
+            group->lastUse = lastUse;
+            pass.aliasGroups[ outputIdx ] = static_cast< int32_t >( std::distance( groups.begin( ), group ) );
+        }
+    }
+}
+
+bool RenderGraph::canAliasOutputs( const PassWrapper& pass )
+{
+    const RenderPassRequest& request = pass.ref->renderPassRequest;
+
+    // The incoming dependency of DefaultColor waits for all earlier work, which orders the writes after the last use of the
+    // previous image in the same memory. The other dependency sets only wait for specific stages
+    return request.queue == PassQueue::Graphics && request.dependencySet == DependencySet::DefaultColor && !request.isFinalDrawPass;
+}
+
+RenderTargetRequest RenderGraph::createRenderTargetRequest( const PassWrapper& pass, const uint32_t& frameIndex ) const
+{
+    RenderTargetRequest renderTargetRequest{ };
+    renderTargetRequest.renderPass = pass.renderPass;
+    renderTargetRequest.frameIndex = frameIndex;
+    renderTargetRequest.type = RenderTargetType::Intermediate;
+    renderTargetRequest.renderArea = pass.ref->renderPassRequest.renderArea;
+
+    for ( const auto& output : pass.ref->outputs )
+    {
+        if ( output.flags.presentedImage )
+        {
+            renderTargetRequest.type = RenderTargetType::SwapChain;
+        }
+    }
+
+    renderTargetRequest.outputImages = pass.ref->outputs;
+    renderTargetRequest.aliasGroups = pass.aliasGroups;
+
+    // Outputs of merged passes follow in subpass order, matching the attachments of the render pass
+    for ( const uint32_t& mergedIdx : pass.mergedPasses )
+    {
+        const PassWrapper& merged = passes[ mergedIdx ];
+
+        renderTargetRequest.outputImages.insert( renderTargetRequest.outputImages.end( ), merged.ref->outputs.begin( ), merged.ref->outputs.end( ) );
+        renderTargetRequest.aliasGroups.insert( renderTargetRequest.aliasGroups.end( ), merged.aliasGroups.begin( ), merged.aliasGroups.end( ) );
+    }
+
+    // Owners run first, their render targets exist by the time this pass is prepared. Reserving memory does not need them
+    for ( const auto& [ outputName, ownerIdx ] : pass.continuedOutputOwners )
+    {
+        const auto& ownerTargets = passes[ ownerIdx ].renderTargets;
+
+        if ( frameIndex < ownerTargets.size( ) )
+        {
+            renderTargetRequest.continuedOutputs[ outputName ] = ownerTargets[ frameIndex ];
+        }
+    }
+
+    return renderTargetRequest;
+}
+
+bool RenderGraph::runsOnSameQueue( const PassWrapper& pass, const PassWrapper& other )
+{
+    // Whether the device has an async compute queue is up to the backend, it ignores waits within the same queue
+    return pass.ref->renderPassRequest.queue == other.ref->renderPassRequest.queue;
+}
+
+void RenderGraph::prepare( ECS::ComponentTable * componentTable )
+{
+    // A fence that was never notified does not block, the very first frame goes through
+    frameFences[ frameIndex ]->wait( );
+
     globalResourceTable->resetTable( componentTable, frameIndex );
 
-    for ( auto& pass : passes )
+    for ( const uint32_t& passIdx : executionPlan )
     {
-        preparePass( pass );
+        preparePass( passes[ passIdx ] );
     }
+
+    // Needs the render passes of every pass, created above
+    createPipelines( );
 }
 
 void RenderGraph::preparePass( PassWrapper& pass )
@@ -152,59 +673,76 @@ void RenderGraph::preparePass( PassWrapper& pass )
         pass.inputsBuilt = true;
     }
 
+    // Merged passes share the render pass and render targets of their producer, which is prepared before them
+    if ( pass.renderPass == nullptr && pass.mergedInto >= 0 )
+    {
+        pass.renderPass = passes[ pass.mergedInto ].renderPass;
+        pass.renderTargets = passes[ pass.mergedInto ].renderTargets;
+    }
+
     if ( pass.renderPass == nullptr )
     {
         pass.ref->renderPassRequest.outputImages = pass.ref->outputs;
+        pass.ref->renderPassRequest.subpasses.clear( );
+
+        for ( const uint32_t& mergedIdx : pass.mergedPasses )
+        {
+            SubpassRequest& subpassRequest = pass.ref->renderPassRequest.subpasses.emplace_back( );
+            subpassRequest.outputImages = passes[ mergedIdx ].ref->outputs;
+            subpassRequest.inputAttachments = passes[ mergedIdx ].inputAttachments;
+        }
+
         pass.renderPass = renderDevice->getRenderPassProvider( )->createRenderPass( pass.ref->renderPassRequest );
         pass.renderPass->create( pass.ref->renderPassRequest );
     }
 
-    if ( pass.renderTargets.empty( ) )
+    while ( pass.signalsOtherQueue && pass.queueLocks.size( ) < renderDevice->getFrameCount( ) )
     {
-        RenderTargetRequest renderTargetRequest{ };
-        renderTargetRequest.renderPass = pass.renderPass;
+        pass.queueLocks.push_back( renderDevice->getResourceProvider( )->createLock( ResourceLockType::Fence ) );
+    }
 
+    if ( pass.renderTargets.empty( ) )
+    {
         pass.renderTargets.resize( renderDevice->getFrameCount( ) );
 
         for ( uint32_t frame = 0; frame < pass.renderTargets.size( ); ++frame )
         {
-            renderTargetRequest.frameIndex = frame;
-            renderTargetRequest.type = RenderTargetType::Intermediate;
-            renderTargetRequest.renderArea = pass.ref->renderPassRequest.renderArea;
-
-            for ( const auto& output : pass.ref->outputs )
-            {
-                if ( output.flags.presentedImage )
-                {
-                    renderTargetRequest.type = RenderTargetType::SwapChain;
-                }
-            }
-
-            renderTargetRequest.outputImages = pass.ref->outputs;
-
-            pass.renderTargets[ frame ] = renderDevice->getRenderPassProvider( )->createRenderTarget( renderTargetRequest );
+            pass.renderTargets[ frame ] = renderDevice->getRenderPassProvider( )->createRenderTarget( createRenderTargetRequest( pass, frame ) );
         }
     }
 
-    if ( pass.pipelines.empty( ) )
+}
+
+void RenderGraph::createPipelines( )
+{
+    std::vector< PipelineRequest > requests;
+
+    for ( const uint32_t& passIdx : executionPlan )
     {
-        int pipelineIdx = 0;
-        pass.pipelines.resize( pass.ref->pipelineRequests.size( ) );
+        PassWrapper& pass = passes[ passIdx ];
+        SKIP_ITERATION_IF( !pass.pipelines.empty( ) )
 
         for ( auto& pipelineRequest : pass.ref->pipelineRequests )
         {
             pipelineRequest.parentPass = pass.renderPass;
-            pass.pipelines[ pipelineIdx ] = renderDevice->getPipelineProvider( )->createPipeline( pipelineRequest );
-            ++pipelineIdx;
+            pipelineRequest.subpass = pass.subpass;
+            requests.push_back( pipelineRequest );
         }
     }
 
-    if ( pass.executeLocks.empty( ) )
+    FUNCTION_BREAK( requests.empty( ) )
+
+    // One batch for the whole graph, the provider spreads the compilation of every pipeline over the worker threads
+    const std::vector< IPipeline * > pipelines = renderDevice->getPipelineProvider( )->createPipelines( requests );
+    uint32_t pipelineIdx = 0;
+
+    for ( const uint32_t& passIdx : executionPlan )
     {
-        for ( int i = 0; i < renderDevice->getFrameCount( ); ++i )
-        {
-            pass.executeLocks.push_back( std::move( renderDevice->getResourceProvider( )->createLock( ResourceLockType::Fence ) ) );
-        }
+        PassWrapper& pass = passes[ passIdx ];
+        SKIP_ITERATION_IF( !pass.pipelines.empty( ) )
+
+        pass.pipelines.assign( pipelines.begin( ) + pipelineIdx, pipelines.begin( ) + pipelineIdx + pass.ref->pipelineRequests.size( ) );
+        pipelineIdx += pass.ref->pipelineRequests.size( );
     }
 }
 
@@ -272,9 +810,9 @@ void RenderGraph::execute( )
 
     frameLocks[ frameIndex ]->lock( );
 
-    for ( auto& pass : passes )
+    for ( const uint32_t& passIdx : executionPlan )
     {
-        executePass( pass );
+        executePass( passes[ passIdx ] );
     }
 
     frameLocks[ frameIndex ]->unlock( );
@@ -287,63 +825,118 @@ void RenderGraph::execute( )
 
 void RenderGraph::executePass( const PassWrapper& pass )
 {
+    // Recorded as a subpass of the render pass it is merged into
+    FUNCTION_BREAK( pass.mergedInto >= 0 )
+
     auto renderPass = pass.renderPass;
 
-    renderPass->frameStart( frameIndex, pass.pipelines );
+    std::vector< const PassWrapper * > subpasses { &pass };
 
-    for ( auto& output : pass.ref->outputs )
+    for ( const uint32_t& mergedIdx : pass.mergedPasses )
     {
-        if ( std::shared_ptr< ShaderResource >& outputResource = pass.renderTargets[ frameIndex ]->outputImageMap[ output.outputResourceName ]; outputResource != nullptr )
+        subpasses.push_back( &passes[ mergedIdx ] );
+    }
+
+    for ( const PassWrapper * subpass : subpasses )
+    {
+        renderPass->frameStart( frameIndex, subpass->pipelines );
+
+        for ( auto& output : subpass->ref->outputs )
         {
-            outputResource->prepareForUsage( ResourceUsage::RenderTarget );
+            if ( std::shared_ptr< ShaderResource >& outputResource = pass.renderTargets[ frameIndex ]->outputImageMap[ output.outputResourceName ]; outputResource != nullptr )
+            {
+                outputResource->prepareForUsage( ResourceUsage::RenderTarget );
+            }
+        }
+
+        auto pipelineIndex = 0;
+
+        for ( auto& pipeline : subpass->pipelines )
+        {
+            renderPass->bindPipeline( pipeline );
+
+            bindDependentInputs( *subpass, renderPass, pipelineIndex );
+
+            for ( auto perFrameInput : subpass->perFrameInputs[ pipelineIndex ] )
+            {
+                renderPass->bindPerFrame( globalResourceTable->getResource( perFrameInput, frameIndex ) );
+            }
+
+            ++pipelineIndex;
         }
     }
 
-    for ( const auto& dependency : pass.dependencies )
+    renderPass->begin( pass.renderTargets[ frameIndex ], { 0.0f, 0.0f, 0.0f, 1.0f } );
+
+    // Async compute passes are never merged, they have no geometry to draw
+    if ( pass.ref->renderPassRequest.queue == PassQueue::AsyncCompute )
     {
-        if ( PassWrapper& dependencyPass = passes[ passMap[ dependency ] ]; !dependencyPass.executeLocks.empty( ) )
+        dispatchPipelines( pass, renderPass );
+    }
+    else
+    {
+        for ( const PassWrapper * subpass : subpasses )
         {
-            dependencyPass.executeLocks[ frameIndex ]->wait( );
+            if ( subpass != &pass )
+            {
+                renderPass->nextSubpass( );
+            }
+
+            for ( auto& wrapper : globalResourceTable->getGeometryList( subpass->ref->inputGeometry ) )
+            {
+                drawEntity( *subpass, renderPass, wrapper );
+            }
         }
     }
 
-    auto pipelineIndex = 0;
+    // Dependencies on the same queue are ordered on the GPU, producers on the other queue are waited for through their queue lock
+    std::vector< std::shared_ptr< IResourceLock > > waitOnLock;
 
-    for ( auto& pipeline : pass.pipelines )
+    for ( const uint32_t& dependency : pass.dependencies )
     {
-        renderPass->bindPipeline( pipeline );
-
-        bindDependentInputs( pass, renderPass, pipelineIndex );
+        // Merged producers are submitted with the pass they are merged into
+        const PassWrapper& producer = passes[ dependency ].mergedInto < 0 ? passes[ dependency ] : passes[ passes[ dependency ].mergedInto ];
 
-        for ( auto perFrameInput : pass.perFrameInputs[ pipelineIndex ] )
+        if ( !runsOnSameQueue( pass, producer ) )
         {
-            renderPass->bindPerFrame( globalResourceTable->getResource( perFrameInput, frameIndex ) );
+            waitOnLock.push_back( producer.queueLocks[ frameIndex ] );
         }
-
-        ++pipelineIndex;
     }
 
-    renderPass->begin( pass.renderTargets[ frameIndex ], { 0.0f, 0.0f, 0.0f, 1.0f } );
+    // Only the last pass of the plan signals the frame fence, it has no dependents on the other queue
+    const PassWrapper& lastPlanned = passes[ executionPlan.back( ) ];
+    const bool lastPass = &pass == ( lastPlanned.mergedInto < 0 ? &lastPlanned : &passes[ lastPlanned.mergedInto ] );
+    IResourceLock * notifyFence = nullptr;
 
-    for ( auto& wrapper : globalResourceTable->getGeometryList( pass.ref->inputGeometry ) )
+    if ( lastPass )
+    {
+        notifyFence = frameFences[ frameIndex ].get( );
+    }
+    else if ( pass.signalsOtherQueue )
     {
-        drawEntity( pass, renderPass, wrapper );
+        notifyFence = pass.queueLocks[ frameIndex ].get( );
     }
 
-    redrawFrame = !renderPass->submit( std::vector< std::shared_ptr< IResourceLock > >( ), pass.executeLocks[ frameIndex ].get( ) );
+    redrawFrame = !renderPass->submit( waitOnLock, notifyFence );
 
-    for ( auto& output : pass.ref->outputs )
+    for ( const PassWrapper * subpass : subpasses )
     {
-        if ( std::shared_ptr< ShaderResource >& outputResource = pass.renderTargets[ frameIndex ]->outputImageMap[ output.outputResourceName ]; outputResource != nullptr )
+        for ( auto& output : subpass->ref->outputs )
         {
-            outputResource->prepareForUsage( ResourceUsage::ShaderInputSampler2D );
+            if ( std::shared_ptr< ShaderResource >& outputResource = pass.renderTargets[ frameIndex ]->outputImageMap[ output.outputResourceName ]; outputResource != nullptr )
+            {
+                outputResource->prepareForUsage( ResourceUsage::ShaderInputSampler2D );
+            }
         }
     }
 }
 
-void RenderGraph::drawEntity( const PassWrapper& pass, const std::shared_ptr< IRenderPass >& renderPass, const EntityWrapper& wrapper ) const
+void RenderGraph::drawEntity( const PassWrapper& pass, const std::shared_ptr< IRenderPass >& renderPass, EntityWrapper& wrapper ) const
 {
-    globalResourceTable->allocatePerEntityResources( frameIndex, wrapper.entity, pass.perEntityInputsFlattened );
+    // Already drawn as an instance of another entity with the same geometry and material
+    FUNCTION_BREAK( wrapper.drawnAsInstance )
+
+    globalResourceTable->allocatePerEntityResources( frameIndex, wrapper, pass.perEntityInputsFlattened );
 
     auto selectedPipelines = pass.ref->selectPipeline( wrapper.entity );
 
@@ -353,10 +946,10 @@ void RenderGraph::drawEntity( const PassWrapper& pass, const std::shared_ptr< IR
 
         for ( const int& resourceIdx : pass.perEntityInputs[ selectedPipeline ] )
         {
-            renderPass->bindPerObject( globalResourceTable->getResource( resourceIdx, frameIndex ) );
+            renderPass->bindPerObject( globalResourceTable->getResource( wrapper, resourceIdx, frameIndex ) );
         }
 
-        for ( auto& [ ignored, resources, boundResources, subMeshGeometry ] : wrapper.subGeometries )
+        for ( auto& [ ignored, resources, boundResources ] : wrapper.subGeometries )
         {
             for ( const int& resourceIdx : pass.loadOnceInputs[ selectedPipeline ] )
             {
@@ -368,18 +961,38 @@ void RenderGraph::drawEntity( const PassWrapper& pass, const std::shared_ptr< IR
                 renderPass->bindPerObject( resource.ref );
             }
 
-            uint32_t instanceCount = 1;
+            uint32_t instanceCount = 1 + wrapper.batchedEntities.size( );
 
             if ( auto instances = wrapper.entity->getComponent< ECS::CInstances >( ); instances != nullptr )
             {
                 instanceCount += instances->transforms.size( );
             }
 
-            renderPass->draw( instanceCount );
+            renderPass->draw( instanceCount, globalResourceTable->getFirstInstance( wrapper, frameIndex ) );
         }
     }
 }
 
+void RenderGraph::dispatchPipelines( const PassWrapper& pass, const std::shared_ptr< IRenderPass >& renderPass ) const
+{
+    const RenderArea renderArea = renderPass->getRenderArea( );
+    const uint32_t groupCountX = ( renderArea.width + pass.ref->workGroupWidth - 1 ) / pass.ref->workGroupWidth;
+    const uint32_t groupCountY = ( renderArea.height + pass.ref->workGroupHeight - 1 ) / pass.ref->workGroupHeight;
+
+    for ( auto& pipeline : pass.pipelines )
+    {
+        renderPass->bindPipeline( pipeline );
+
+        // Shaders write the outputs through storage images named like them
+        for ( auto& output : pass.ref->outputs )
+        {
+            renderPass->bindPerFrame( pass.renderTargets[ frameIndex ]->outputImageMap[ output.outputResourceName ] );
+        }
+
+        renderPass->dispatch( groupCountX, groupCountY, 1 );
+    }
+}
+
 void RenderGraph::bindDependentInputs( const PassWrapper& pass, std::shared_ptr< IRenderPass >& renderPass, int pipelineIndex )
 {
     for ( auto& input : pass.passDependentInputs[ pipelineIndex ] )
@@ -411,11 +1024,19 @@ RenderGraph::~RenderGraph( )
 {
     globalResourceTable.reset( );
 
+    for ( auto& fence : frameFences )
+    {
+        fence->cleanup( );
+    }
+
     for ( auto& pass : passes )
     {
-        for ( auto& lock : pass.executeLocks )
+        // Culled passes never created their resources
+        SKIP_ITERATION_IF( pass.renderPass == nullptr )
+
+        for ( auto& queueLock : pass.queueLocks )
         {
-            lock->cleanup( );
+            queueLock->cleanup( );
         }
 
         for ( auto& pipeline : pass.pipelines )
@@ -423,6 +1044,9 @@ RenderGraph::~RenderGraph( )
             pipeline->cleanup( );
         }
 
+        // The render pass and render targets of a merged pass belong to the pass it is merged into
+        SKIP_ITERATION_IF( pass.mergedInto >= 0 )
+
         for ( auto& renderTarget : pass.renderTargets )
         {
             renderTarget->cleanup( );
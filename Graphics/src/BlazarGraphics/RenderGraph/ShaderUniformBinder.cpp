@@ -29,7 +29,9 @@ ShaderUniformBinder::ShaderUniformBinder( )
             [ ]( ECS::IGameEntity * entity ) -> std::unique_ptr< IShaderUniform >
             {
                 const auto data = DataAttachmentFormatter::formatInstances( entity->getComponent< ECS::CInstances >( ), entity );
-                return getAttachment< InstanceData >( data );
+                auto attachment = getAttachment( data );
+                attachment->resourceType = ResourceType::StorageBuffer;
+                return attachment;
             }
     );
 
@@ -0,0 +1,160 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/BindlessTextureTable.h>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+BindlessTextureTable::BindlessTextureTable( VulkanContext * context ) : context( context )
+{
+    vk::DescriptorSetLayoutBinding binding { };
+    binding.binding = 0;
+    binding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    binding.descriptorCount = BINDLESS_TEXTURE_CAPACITY;
+    binding.stageFlags = vk::ShaderStageFlagBits::eAllGraphics;
+
+    // Unused elements may stay unwritten, new textures are written while the set is bound by frames in flight
+    vk::DescriptorBindingFlagsEXT bindingFlags = vk::DescriptorBindingFlagBitsEXT::ePartiallyBound |
+                                                 vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind |
+                                                 vk::DescriptorBindingFlagBitsEXT::eUpdateUnusedWhilePending;
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsCreateInfo { };
+    bindingFlagsCreateInfo.bindingCount = 1;
+    bindingFlagsCreateInfo.pBindingFlags = &bindingFlags;
+
+    vk::DescriptorSetLayoutCreateInfo layoutCreateInfo { };
+    layoutCreateInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT;
+    layoutCreateInfo.bindingCount = 1;
+    layoutCreateInfo.pBindings = &binding;
+    layoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+
+    layout = context->logicalDevice.createDescriptorSetLayout( layoutCreateInfo );
+
+    vk::DescriptorPoolSize poolSize { };
+    poolSize.type = vk::DescriptorType::eCombinedImageSampler;
+    poolSize.descriptorCount = BINDLESS_TEXTURE_CAPACITY;
+
+    vk::DescriptorPoolCreateInfo poolCreateInfo { };
+    poolCreateInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT;
+    poolCreateInfo.maxSets = 1;
+    poolCreateInfo.poolSizeCount = 1;
+    poolCreateInfo.pPoolSizes = &poolSize;
+
+    pool = context->logicalDevice.createDescriptorPool( poolCreateInfo );
+
+    vk::DescriptorSetAllocateInfo allocateInfo { };
+    allocateInfo.descriptorPool = pool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &layout;
+
+    set = context->logicalDevice.allocateDescriptorSets( allocateInfo )[ 0 ];
+}
+
+uint32_t BindlessTextureTable::getIndex( const VulkanTextureWrapper & texture )
+{
+    auto find = slots.find( texture.uid );
+
+    if ( find != slots.end( ) )
+    {
+        TextureSlot & slot = find->second;
+
+        // Render targets recreate their images in place when the surface is resized
+        if ( slot.imageView != texture.imageView || slot.sampler != texture.sampler )
+        {
+            slot.imageView = texture.imageView;
+            slot.sampler = texture.sampler;
+            write( slot );
+        }
+
+        return slot.index;
+    }
+
+    uint32_t index;
+
+    if ( !freeIndices.empty( ) )
+    {
+        index = freeIndices.back( );
+        freeIndices.pop_back( );
+    }
+    else
+    {
+        if ( nextIndex == BINDLESS_TEXTURE_CAPACITY )
+        {
+            throw GraphicsException( "BindlessTextureTable", "Bindless texture capacity exceeded." );
+        }
+
+        index = nextIndex++;
+    }
+
+    TextureSlot & slot = slots[ texture.uid ];
+    slot.index = index;
+    slot.imageView = texture.imageView;
+    slot.sampler = texture.sampler;
+
+    write( slot );
+
+    return index;
+}
+
+void BindlessTextureTable::release( const uint64_t & uid )
+{
+    auto find = slots.find( uid );
+
+    FUNCTION_BREAK( find == slots.end( ) )
+
+    const uint32_t index = find->second.index;
+    slots.erase( find );
+
+    if ( context->graphicsTimeline == nullptr )
+    {
+        freeIndices.push_back( index );
+        return;
+    }
+
+    // Recorded passes may still push the index, the table outlives the timeline so the release can reference it
+    context->graphicsTimeline->retireAfterPending( [ this, index ]( )
+    {
+        freeIndices.push_back( index );
+    } );
+}
+
+void BindlessTextureTable::write( const TextureSlot & slot )
+{
+    vk::DescriptorImageInfo descriptorImageInfo { };
+    descriptorImageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    descriptorImageInfo.imageView = slot.imageView;
+    descriptorImageInfo.sampler = slot.sampler;
+
+    vk::WriteDescriptorSet writeDescriptorSet { };
+    writeDescriptorSet.dstSet = set;
+    writeDescriptorSet.dstBinding = 0;
+    writeDescriptorSet.dstArrayElement = slot.index;
+    writeDescriptorSet.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.pImageInfo = &descriptorImageInfo;
+
+    context->logicalDevice.updateDescriptorSets( 1, &writeDescriptorSet, 0, nullptr );
+}
+
+BindlessTextureTable::~BindlessTextureTable( )
+{
+    context->logicalDevice.destroyDescriptorPool( pool );
+    context->logicalDevice.destroyDescriptorSetLayout( layout );
+}
+
+END_NAMESPACES
@@ -0,0 +1,169 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/CommandStateTracker.h>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+void CommandStateTracker::begin( const vk::CommandBuffer &commandBuffer )
+{
+    this->commandBuffer = commandBuffer;
+
+    stats = { };
+    pipeline = nullptr;
+    pipelineLayout = nullptr;
+    hasViewport = false;
+    hasScissor = false;
+    hasDepthBias = false;
+    vertexBuffer = nullptr;
+    indexBuffer = nullptr;
+    descriptorSets.clear( );
+    dynamicOffsets.clear( );
+    pushConstantRanges.clear( );
+}
+
+void CommandStateTracker::bindPipeline( const vk::PipelineBindPoint &bindPoint, const vk::Pipeline &pipeline, const vk::PipelineLayout &layout )
+{
+    if ( this->pipeline == pipeline )
+    {
+        ++stats.elided;
+        return;
+    }
+
+    commandBuffer.bindPipeline( bindPoint, pipeline );
+    this->pipeline = pipeline;
+    ++stats.emitted;
+
+    // Sets and push constants bound with another layout are disturbed
+    if ( pipelineLayout != layout )
+    {
+        pipelineLayout = layout;
+        descriptorSets.clear( );
+        dynamicOffsets.clear( );
+        pushConstantRanges.clear( );
+    }
+}
+
+void CommandStateTracker::setViewport( const vk::Viewport &viewport )
+{
+    if ( hasViewport && this->viewport == viewport )
+    {
+        ++stats.elided;
+        return;
+    }
+
+    commandBuffer.setViewport( 0, 1, &viewport );
+    this->viewport = viewport;
+    hasViewport = true;
+    ++stats.emitted;
+}
+
+void CommandStateTracker::setScissor( const vk::Rect2D &scissor )
+{
+    if ( hasScissor && this->scissor == scissor )
+    {
+        ++stats.elided;
+        return;
+    }
+
+    commandBuffer.setScissor( 0, 1, &scissor );
+    this->scissor = scissor;
+    hasScissor = true;
+    ++stats.emitted;
+}
+
+void CommandStateTracker::setDepthBias( const float &constant, const float &slope )
+{
+    if ( hasDepthBias && depthBiasConstant == constant && depthBiasSlope == slope )
+    {
+        ++stats.elided;
+        return;
+    }
+
+    commandBuffer.setDepthBias( constant, 0.0f, slope );
+    depthBiasConstant = constant;
+    depthBiasSlope = slope;
+    hasDepthBias = true;
+    ++stats.emitted;
+}
+
+void CommandStateTracker::bindVertexBuffer( const vk::Buffer &buffer )
+{
+    if ( vertexBuffer == buffer )
+    {
+        ++stats.elided;
+        return;
+    }
+
+    const vk::DeviceSize offset = 0;
+    commandBuffer.bindVertexBuffers( 0, 1, &buffer, &offset );
+    vertexBuffer = buffer;
+    ++stats.emitted;
+}
+
+void CommandStateTracker::bindIndexBuffer( const vk::Buffer &buffer )
+{
+    if ( indexBuffer == buffer )
+    {
+        ++stats.elided;
+        return;
+    }
+
+    commandBuffer.bindIndexBuffer( buffer, 0, vk::IndexType::eUint32 );
+    indexBuffer = buffer;
+    ++stats.emitted;
+}
+
+void CommandStateTracker::bindDescriptorSet( const vk::PipelineBindPoint &bindPoint, const uint32_t &set, const vk::DescriptorSet &descriptorSet, const std::vector< uint32_t > &offsets )
+{
+    if ( set < descriptorSets.size( ) && descriptorSets[ set ] == descriptorSet && dynamicOffsets[ set ] == offsets )
+    {
+        ++stats.elided;
+        return;
+    }
+
+    commandBuffer.bindDescriptorSets( bindPoint, pipelineLayout, set, 1, &descriptorSet, offsets.size( ), offsets.data( ) );
+
+    if ( set >= descriptorSets.size( ) )
+    {
+        descriptorSets.resize( set + 1 );
+        dynamicOffsets.resize( set + 1 );
+    }
+
+    descriptorSets[ set ] = descriptorSet;
+    dynamicOffsets[ set ] = offsets;
+    ++stats.emitted;
+}
+
+void CommandStateTracker::pushConstants( const vk::ShaderStageFlags &stage, const uint32_t &offset, const uint32_t &size, const char *data )
+{
+    const uint64_t rangeKey = ( uint64_t( VkShaderStageFlags( stage ) ) << 32 ) | offset;
+    std::vector< char > &range = pushConstantRanges[ rangeKey ];
+
+    if ( range.size( ) == size && memcmp( range.data( ), data, size ) == 0 )
+    {
+        ++stats.elided;
+        return;
+    }
+
+    commandBuffer.pushConstants( pipelineLayout, stage, offset, size, data );
+    range.assign( data, data + size );
+    ++stats.emitted;
+}
+
+END_NAMESPACES
@@ -18,56 +18,83 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <BlazarGraphics/VulkanBackend/DescriptorManager.h>
 
+#include <algorithm>
+#include <array>
 #include <utility>
+#include <boost/functional/hash.hpp>
 #include <BlazarCore/Utilities.h>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
-const uint32_t DescriptorManager::texturePreallocateCount = 12;
 const uint32_t DescriptorManager::descriptorPoolSize = 120;
 
 DescriptorManager::DescriptorManager( VulkanContext * context, std::shared_ptr< GLSLShaderSet > shaderSet ) : context( context ), shaderSet( std::move( shaderSet ) )
 {
     createDescriptorPool( );
 
-    uniformLayouts.resize( this->shaderSet->getDescriptorSets( ).size( ) );
-    textureLayouts.resize( uniformLayouts.size( ) );
-    layouts.resize( uniformLayouts.size( ) );
+    uint32_t setCount = 0;
 
-    for ( const auto &sets: this->shaderSet->getDescriptorSets( ) )
+    for ( const auto &set: this->shaderSet->getDescriptorSets( ) )
     {
-        uint32_t setIndex = sets.id;
+        setCount = std::max( setCount, set.id + 1 );
+    }
+
+    setStates.resize( setCount );
+    layouts.resize( setCount );
 
-        for ( const auto &bindings: sets.descriptorSetBindings )
+    for ( const auto &set: this->shaderSet->getDescriptorSets( ) )
+    {
+        uint32_t setIndex = set.id;
+        DescriptorSetState &setState = setStates[ setIndex ];
+
+        for ( const auto &binding: set.descriptorSetBindings )
         {
-            orders.push_back( { bindings.type, bindings.name, setIndex, bindings.index } );
+            orders.push_back( { binding.type, binding.name, setIndex, int( binding.layout.binding ) } );
 
-            uniformLocations[ bindings.name ] = UniformLocation {
-                    true, setIndex, bindings.index,
+            uniformLocations[ binding.name ] = UniformLocation {
+                    true, setIndex, binding.layout.binding, uint32_t( setState.bindings.size( ) )
             };
+
+            SetBindingState &bindingState = setState.bindings.emplace_back( );
+            bindingState.name = binding.name;
+            bindingState.type = binding.type;
+            bindingState.binding = binding.layout.binding;
+            bindingState.size = binding.size;
         }
 
-        const DescriptorSet &set = this->shaderSet->getDescriptorSetBySetId( setIndex );
+        for ( const auto &layoutBinding: set.descriptorSetLayoutBindings )
+        {
+            setState.descriptorCounts[ layoutBinding.descriptorType ] += layoutBinding.descriptorCount;
+        }
+
+        if ( set.descriptorSetBindings[ 0 ].name == BINDLESS_TEXTURES_NAME )
+        {
+            if ( this->context->bindlessTextures == nullptr )
+            {
+                throw GraphicsException( "DescriptorManager", "Shader uses bindless textures but the device does not support descriptor indexing." );
+            }
+
+            bindlessSet = setIndex;
+            setState.layout = this->context->bindlessTextures->getLayout( );
+            layouts[ setIndex ] = setState.layout;
+            continue;
+        }
 
         vk::DescriptorSetLayoutCreateInfo createInfo { };
+        createInfo.bindingCount = set.descriptorSetLayoutBindings.size( );
+        createInfo.pBindings = set.descriptorSetLayoutBindings.data( );
 
-        std::vector< vk::DescriptorSetLayoutBinding > vkDescriptorSetBindings = set.descriptorSetLayoutBindings;
+        setState.layout = this->context->logicalDevice.createDescriptorSetLayout( createInfo );
+        layouts[ setIndex ] = setState.layout;
+    }
 
-        createInfo.bindingCount = vkDescriptorSetBindings.size( );
-        createInfo.pBindings = vkDescriptorSetBindings.data( );
+    // Frequencies a shader has no resources for, i.e. a pass without inputs, are bound to an empty set
+    for ( uint32_t i = 0; i < setCount; ++i )
+    {
+        SKIP_ITERATION_IF( layouts[ i ] )
 
-        if ( vkDescriptorSetBindings[ 0 ].descriptorType == vk::DescriptorType::eCombinedImageSampler )
-        {
-            textureLayouts[ setIndex ] = this->context->logicalDevice.createDescriptorSetLayout( createInfo );
-            uniformLayouts[ setIndex ] = nullptr;
-            layouts[ setIndex ] = textureLayouts[ setIndex ];
-        }
-        else
-        {
-            textureLayouts[ setIndex ] = nullptr;
-            uniformLayouts[ setIndex ] = this->context->logicalDevice.createDescriptorSetLayout( createInfo );
-            layouts[ setIndex ] = uniformLayouts[ setIndex ];
-        }
+        setStates[ i ].layout = this->context->logicalDevice.createDescriptorSetLayout( vk::DescriptorSetLayoutCreateInfo { } );
+        layouts[ i ] = setStates[ i ].layout;
     }
 
     for ( uint32_t i = 0; i < this->context->swapChainImages.size( ); ++i )
@@ -77,6 +104,7 @@ DescriptorManager::DescriptorManager( VulkanContext * context, std::shared_ptr<
             auto &parent = pushConstantParents[ pushConstantDetail.stage ].emplace_back( );
 
             parent.data = static_cast< char* >( malloc( pushConstantDetail.size ) );
+            parent.offset = pushConstantDetail.offset;
             parent.totalSize = pushConstantDetail.size;
             parent.stage = pushConstantDetail.stage;
 
@@ -85,6 +113,14 @@ DescriptorManager::DescriptorManager( VulkanContext * context, std::shared_ptr<
                 stagesWithPushConstants.push_back( pushConstantDetail.stage );
             }
 
+            if ( i == 0 && pushConstantDetail.name == BINDLESS_TEXTURE_INDICES_NAME )
+            {
+                for ( const auto &childElement: pushConstantDetail.children )
+                {
+                    bindlessTextureNames.push_back( childElement.name );
+                }
+            }
+
             for ( const auto& childElement: pushConstantDetail.children )
             {
                 auto & binding = pushConstants[ childElement.name ].emplace_back( );
@@ -98,7 +134,7 @@ DescriptorManager::DescriptorManager( VulkanContext * context, std::shared_ptr<
     {
         if ( o1.set == o2.set )
         {
-            return o1.location <= o2.location;
+            return o1.location < o2.location;
         }
 
         return o1.set < o2.set;
@@ -107,220 +143,286 @@ DescriptorManager::DescriptorManager( VulkanContext * context, std::shared_ptr<
     frameUpdatedTextures.resize( this->context->swapChainImages.size( ) );
 
     createNullResources( );
+
+    this->context->resourceDestroyedListeners[ this ] = [ this ]( const uint64_t &uid )
+    {
+        evictResource( uid );
+    };
 }
 
-void DescriptorManager::addUniformDescriptorSet( const std::string &uniformName, UniformLocation &location, vk::DescriptorSetLayout &layout, const uint32_t& objectIndex  )
+void DescriptorManager::createDescriptorPool( )
 {
-    uint32_t swapChainImageCount = context->swapChainImages.size( );
-
-    std::vector< vk::DescriptorSetLayout > layoutsPtr { swapChainImageCount, layout };
-
-    DescriptorPool & pool = findFreeDescriptorPool( true, layoutsPtr.size( ) );
-
-    vk::DescriptorSetAllocateInfo allocateInfo { };
-    allocateInfo.descriptorPool = pool.pool;
-    allocateInfo.descriptorSetCount = layoutsPtr.size( );
-    allocateInfo.pSetLayouts = layoutsPtr.data( );
-    pool.freeDescriptors -= layoutsPtr.size( );
+    auto swapChainImageCount = static_cast< uint32_t >( context->swapChainImages.size( ) );
 
-    if ( uniformSetMaps.find( uniformName ) == uniformSetMaps.end( ) )
+    std::array< vk::DescriptorPoolSize, 5 > poolSizes { };
+    poolSizes[ 0 ].type = vk::DescriptorType::eUniformBufferDynamic;
+    poolSizes[ 0 ].descriptorCount = swapChainImageCount * descriptorPoolSize;
+    poolSizes[ 1 ].type = vk::DescriptorType::eStorageBuffer;
+    poolSizes[ 1 ].descriptorCount = swapChainImageCount * descriptorPoolSize;
+    poolSizes[ 2 ].type = vk::DescriptorType::eCombinedImageSampler;
+    poolSizes[ 2 ].descriptorCount = swapChainImageCount * descriptorPoolSize;
+    poolSizes[ 3 ].type = vk::DescriptorType::eInputAttachment;
+    poolSizes[ 3 ].descriptorCount = swapChainImageCount * descriptorPoolSize;
+    poolSizes[ 4 ].type = vk::DescriptorType::eStorageImage;
+    poolSizes[ 4 ].descriptorCount = swapChainImageCount * descriptorPoolSize;
+
+    vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo { };
+    // Sets are freed when a resource they were written with is destroyed
+    descriptorPoolCreateInfo.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+    descriptorPoolCreateInfo.poolSizeCount = poolSizes.size( );
+    descriptorPoolCreateInfo.pPoolSizes = poolSizes.data( );
+    descriptorPoolCreateInfo.maxSets = swapChainImageCount * descriptorPoolSize;
+
+    auto & pool = descriptorPools.emplace_back( );
+    pool.pool = context->logicalDevice.createDescriptorPool( descriptorPoolCreateInfo );
+    pool.freeSets = descriptorPoolCreateInfo.maxSets;
+
+    for ( const auto &poolSize: poolSizes )
     {
-        uniformSetMaps[ uniformName ] = { };
+        pool.freeDescriptors[ poolSize.type ] = poolSize.descriptorCount;
     }
+}
 
-    if ( uniformSetMaps[ uniformName ].size( ) <= objectIndex )
-    {
-        uniformSetMaps[ uniformName ].resize( objectIndex + 100 );
-    }
+void DescriptorManager::updatePushConstant( const uint32_t &frameIndex, const std::string &uniformName, void *data )
+{
+    auto &pushConstantChild = pushConstants[ uniformName ][ frameIndex ];
 
-    uniformSetMaps[ uniformName ][ objectIndex ] = context->logicalDevice.allocateDescriptorSets( allocateInfo );
+    memcpy( pushConstantChild.parent.data + pushConstantChild.ref.offset, data, pushConstantChild.ref.size );
 }
 
-void DescriptorManager::addTextureDescriptorSet( const std::string &uniformName, UniformLocation &location, vk::DescriptorSetLayout &layout, const uint32_t& objectIndex )
+void DescriptorManager::updateUniform( const uint32_t &frameIndex, const std::string &uniformName, const VulkanBufferWrapper &buffer, const int &arrayIndex )
 {
-    uint32_t swapChainImageCount = context->swapChainImages.size( );
+    uint32_t set;
+    SetBindingState * binding = findBinding( uniformName, set );
 
-    std::vector< vk::DescriptorSetLayout > layoutsPtr { swapChainImageCount, layout };
+    FUNCTION_BREAK( binding == nullptr )
 
-    DescriptorPool & pool = findFreeDescriptorPool( false, layoutsPtr.size( ) );
+    // Storage buffers end with a runtime array, their size is only known by the bound buffer
+    const vk::DeviceSize range = binding->type == vk::DescriptorType::eStorageBuffer ? VK_WHOLE_SIZE : binding->size;
 
-    vk::DescriptorSetAllocateInfo allocateInfo { };
-    allocateInfo.descriptorPool = pool.pool;
-    allocateInfo.descriptorSetCount = layoutsPtr.size( );
-    allocateInfo.pSetLayouts = layoutsPtr.data( );
-    pool.freeDescriptors -= layoutsPtr.size( );
+    BoundResource resource { };
+    resource.uid = buffer.uid;
+    resource.arrayElement = arrayIndex < 0 ? 0 : uint32_t( arrayIndex );
+    resource.bufferInfo.buffer = buffer.buffer.first;
+    resource.bufferInfo.offset = 0;
+    resource.bufferInfo.range = range;
 
-    if ( textureSetMaps.find( uniformName ) == textureSetMaps.end( ) )
-    {
-        textureSetMaps[ uniformName ] = { };
-    }
-
-    if ( textureSetMaps[ uniformName ].size( ) <= objectIndex )
-    {
-        textureSetMaps[ uniformName ].resize( objectIndex + 100 );
-    }
+    bindResource( *binding, set, resource );
+}
 
-    textureSetMaps[ uniformName ][ objectIndex ] = context->logicalDevice.allocateDescriptorSets( allocateInfo );
+void DescriptorManager::setDynamicOffset( const std::string &uniformName, const uint32_t &offset )
+{
+    dynamicOffsets[ uniformName ] = offset;
 }
 
-void DescriptorManager::createDescriptorPool( )
+void DescriptorManager::updateTexture( const uint32_t &frameIndex, const std::string &uniformName, const VulkanTextureWrapper &buffer )
 {
-    auto swapChainImageCount = static_cast< uint32_t >( context->swapChainImages.size( ) );
+    frameUpdatedTextures[ frameIndex ][ uniformName ] = true;
 
-    vk::DescriptorPoolSize uniformPoolSize { };
-    uniformPoolSize.type = vk::DescriptorType::eUniformBuffer;
-    uniformPoolSize.descriptorCount = swapChainImageCount * descriptorPoolSize;
+    if ( bindlessSet != -1 && pushConstants.find( uniformName ) != pushConstants.end( ) )
+    {
+        uint32_t textureIndex = context->bindlessTextures->getIndex( buffer );
+        updatePushConstant( frameIndex, uniformName, &textureIndex );
+        return;
+    }
 
-    vk::DescriptorPoolCreateInfo uniformDescriptorPoolCreateInfo { };
-    uniformDescriptorPoolCreateInfo.poolSizeCount = 1;
-    uniformDescriptorPoolCreateInfo.pPoolSizes = &uniformPoolSize;
-    uniformDescriptorPoolCreateInfo.maxSets = swapChainImageCount * descriptorPoolSize;
+    uint32_t set;
+    SetBindingState * binding = findBinding( uniformName, set );
 
-    auto & uniformPool = uniformDescriptorPool.emplace_back( );
-    uniformPool.pool = context->logicalDevice.createDescriptorPool( uniformDescriptorPoolCreateInfo );
-    uniformPool.freeDescriptors = swapChainImageCount * descriptorPoolSize;
+    FUNCTION_BREAK( binding == nullptr )
 
-    vk::DescriptorPoolSize samplerPoolSize { };
-    samplerPoolSize.type = vk::DescriptorType::eCombinedImageSampler;
-    samplerPoolSize.descriptorCount = swapChainImageCount * descriptorPoolSize;
+    // Storage images are written by compute passes in the general layout, they are not sampled
+    const bool isStorageImage = binding->type == vk::DescriptorType::eStorageImage;
 
-    vk::DescriptorPoolCreateInfo samplerDescriptorPoolCreateInfo { };
-    samplerDescriptorPoolCreateInfo.poolSizeCount = 1;
-    samplerDescriptorPoolCreateInfo.pPoolSizes = &samplerPoolSize;
-    samplerDescriptorPoolCreateInfo.maxSets = swapChainImageCount * descriptorPoolSize;
+    BoundResource resource { };
+    resource.uid = buffer.uid;
+    resource.imageInfo.imageLayout = isStorageImage ? vk::ImageLayout::eGeneral : vk::ImageLayout::eShaderReadOnlyOptimal;
+    resource.imageInfo.imageView = buffer.imageView;
+    resource.imageInfo.sampler = isStorageImage ? vk::Sampler { } : buffer.sampler;
 
-    auto & samplerPool = samplerDescriptorPool.emplace_back( );
-    samplerPool.pool = context->logicalDevice.createDescriptorPool( samplerDescriptorPoolCreateInfo );
-    samplerPool.freeDescriptors = swapChainImageCount * descriptorPoolSize;
+    bindResource( *binding, set, resource );
 }
 
-vk::WriteDescriptorSet DescriptorManager::getCommonWriteDescriptorSet( const UniformLocation &uniformLocation, const BindingUpdateInfo &updateInfo )
+SetBindingState *DescriptorManager::findBinding( const std::string &uniformName, uint32_t &set )
 {
-    const DescriptorSet &set = shaderSet->getDescriptorSetBySetId( uniformLocation.set );
+    auto find = uniformLocations.find( uniformName );
 
-    const DescriptorSetBinding &ref = set.descriptorSetBindings[ updateInfo.index ];
-    vk::WriteDescriptorSet writeDescriptorSet { };
-
-    writeDescriptorSet.dstSet = updateInfo.parent;
-    writeDescriptorSet.dstBinding = uniformLocation.binding;
-    writeDescriptorSet.dstArrayElement = updateInfo.arrayElement;
-    writeDescriptorSet.descriptorType = ref.type;
-    writeDescriptorSet.descriptorCount = 1;
+    if ( find == uniformLocations.end( ) )
+    {
+        return nullptr;
+    }
 
-    return writeDescriptorSet;
+    set = find->second.set;
+    return &setStates[ set ].bindings[ find->second.index ];
 }
 
-void DescriptorManager::ensureTextureHasDescriptor( const uint32_t &frameIndex, const std::string &uniformName, const uint32_t& objectIndex  )
+void DescriptorManager::bindResource( SetBindingState &binding, const uint32_t &set, const BoundResource &resource )
 {
-    const std::string &key = getUniformKey( uniformName );
+    FUNCTION_BREAK( binding.resource == resource )
 
-    auto findResult = textureSetMaps.find( key );
+    binding.resource = resource;
+    setStates[ set ].dirty = true;
+}
 
-    if ( findResult == textureSetMaps.end( ) || findResult->second.size( ) <= objectIndex || findResult->second[ objectIndex ].empty( ) )
+vk::DescriptorSet DescriptorManager::resolveSet( const DescriptorSetState &setState )
+{
+    vk::DescriptorSet descriptorSet;
+
+    if ( findOrAllocateSet( setState, descriptorSet ) )
     {
-        auto &uniformSet = uniformLocations[ uniformName ];
-        auto &layout = textureLayouts[ uniformSet.set ];
+        return descriptorSet;
+    }
 
-        addTextureDescriptorSet( uniformName, uniformSet, layout, objectIndex );
+    std::vector< vk::WriteDescriptorSet > writeDescriptorSets;
+
+    for ( const auto &binding: setState.bindings )
+    {
+        SKIP_ITERATION_IF( binding.resource.uid == 0 )
+
+        // Input attachments and storage images are written like sampled images, their sampler is ignored
+        const bool isImage = binding.type == vk::DescriptorType::eCombinedImageSampler || binding.type == vk::DescriptorType::eInputAttachment ||
+                             binding.type == vk::DescriptorType::eStorageImage;
+
+        vk::WriteDescriptorSet &writeDescriptorSet = writeDescriptorSets.emplace_back( );
+        writeDescriptorSet.dstSet = descriptorSet;
+        writeDescriptorSet.dstBinding = binding.binding;
+        writeDescriptorSet.dstArrayElement = binding.resource.arrayElement;
+        writeDescriptorSet.descriptorType = binding.type;
+        writeDescriptorSet.descriptorCount = 1;
+        writeDescriptorSet.pBufferInfo = isImage ? nullptr : &binding.resource.bufferInfo;
+        writeDescriptorSet.pImageInfo = isImage ? &binding.resource.imageInfo : nullptr;
+        writeDescriptorSet.pTexelBufferView = nullptr;
     }
+
+    context->logicalDevice.updateDescriptorSets( writeDescriptorSets.size( ), writeDescriptorSets.data( ), 0, nullptr );
+
+    return descriptorSet;
 }
 
-void DescriptorManager::ensureUniformHasDescriptor( const uint32_t &frameIndex, const std::string &uniformName, const uint32_t& objectIndex, const int &arrayIndex  )
+bool DescriptorManager::findOrAllocateSet( const DescriptorSetState &setState, vk::DescriptorSet &result )
 {
-    const std::string &key = getUniformKey( uniformName, arrayIndex );
+    size_t setKey = 0;
+    boost::hash_combine( setKey, static_cast< VkDescriptorSetLayout >( setState.layout ) );
 
-    auto findResult = uniformSetMaps.find( key );
+    std::vector< BoundResource > resources;
+    resources.reserve( setState.bindings.size( ) );
 
-    if ( findResult == uniformSetMaps.end( ) || findResult->second.size( ) <= objectIndex || findResult->second[ objectIndex ].empty( ) )
+    for ( const auto &binding: setState.bindings )
     {
-        auto &uniformSet = uniformLocations[ uniformName ];
-        auto &layout = uniformLayouts[ uniformSet.set ];
+        resources.push_back( binding.resource );
 
-        addUniformDescriptorSet( uniformName, uniformSet, layout, objectIndex );
+        boost::hash_combine( setKey, binding.resource.uid );
+        boost::hash_combine( setKey, binding.resource.arrayElement );
+        boost::hash_combine( setKey, static_cast< VkBuffer >( binding.resource.bufferInfo.buffer ) );
+        boost::hash_combine( setKey, binding.resource.bufferInfo.range );
+        boost::hash_combine( setKey, static_cast< VkImageView >( binding.resource.imageInfo.imageView ) );
     }
-}
 
-vk::DescriptorSet &DescriptorManager::getUniformDescriptorSet( const uint32_t &frameIndex, const std::string &uniformName, const uint32_t& objectIndex, const uint32_t &arrayIndex )
-{
-    ensureUniformHasDescriptor( frameIndex, uniformName, objectIndex, arrayIndex );
+    // Hashes may collide, a set is only shared if it was written with the very same resources
+    auto [ begin, end ] = cachedSets.equal_range( setKey );
 
-    return uniformSetMaps[ getUniformKey( uniformName, arrayIndex ) ][ objectIndex ][ frameIndex ];
-}
+    for ( auto it = begin; it != end; ++it )
+    {
+        SKIP_ITERATION_IF( it->second.layout != setState.layout || it->second.resources != resources )
 
-vk::DescriptorSet &DescriptorManager::getTextureDescriptorSet( const uint32_t &frameIndex, const std::string &uniformName, const uint32_t& objectIndex, const uint32_t &textureIndex )
-{
-    ensureTextureHasDescriptor( frameIndex, uniformName, objectIndex);
+        result = it->second.set;
+        return true;
+    }
 
-    return textureSetMaps[ uniformName ][ objectIndex ][ frameIndex ];
-}
+    CachedSet cachedSet { };
+    cachedSet.layout = setState.layout;
+    cachedSet.resources = std::move( resources );
+    cachedSet.set = allocateSet( setState, cachedSet.pool );
 
-void DescriptorManager::updatePushConstant( const uint32_t &frameIndex, const std::string &uniformName, void *data )
-{
-    auto &pushConstantChild = pushConstants[ uniformName ][ frameIndex ];
+    result = cachedSet.set;
+    cachedSets.emplace( setKey, std::move( cachedSet ) );
 
-    memcpy( pushConstantChild.parent.data + pushConstantChild.ref.offset, data, pushConstantChild.ref.size );
+    return false;
 }
 
-void DescriptorManager::updateUniform( const uint32_t &frameIndex, const std::string &uniformName, const std::pair< vk::Buffer, vma::Allocation > &buffer,
-                                       const uint32_t& objectIndex, const int &arrayIndex )
+vk::DescriptorSet DescriptorManager::allocateSet( const DescriptorSetState &setState, uint32_t &poolIndex )
 {
-    ensureUniformHasDescriptor( frameIndex, uniformName, objectIndex, arrayIndex );
+    poolIndex = findFreeDescriptorPool( setState );
+    DescriptorPool &pool = descriptorPools[ poolIndex ];
 
-    const std::string &key = getUniformKey( uniformName, arrayIndex );
+    vk::DescriptorSetAllocateInfo allocateInfo { };
+    allocateInfo.descriptorPool = pool.pool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &setState.layout;
 
-    UniformLocation &uniformLocation = uniformLocations[ key ];
+    vk::DescriptorSet result;
 
-    BindingUpdateInfo updateInfo {
-            uniformLocation.binding,
-            uniformSetMaps[ key ][ objectIndex ][ frameIndex ],
-            arrayIndex < 0 ? 0 : uint32_t( arrayIndex )
-    };
-
-    const DescriptorSet &set = shaderSet->getDescriptorSetBySetId( uniformLocation.set );
-    const DescriptorSetBinding &ref = set.descriptorSetBindings[ uniformLocation.binding ];
-    vk::WriteDescriptorSet writeDescriptorSet = getCommonWriteDescriptorSet( uniformLocation, updateInfo );
+    try
+    {
+        result = context->logicalDevice.allocateDescriptorSets( allocateInfo )[ 0 ];
+    }
+    catch ( const vk::FragmentedPoolError & )
+    {
+        // Freed sets can leave the pool without a large enough range even though the counts fit
+        pool.fragmented = true;
+        return allocateSet( setState, poolIndex );
+    }
+    catch ( const vk::OutOfPoolMemoryError & )
+    {
+        pool.fragmented = true;
+        return allocateSet( setState, poolIndex );
+    }
 
-    vk::DescriptorBufferInfo descriptorBufferInfo { };
-    descriptorBufferInfo.buffer = buffer.first;
-    descriptorBufferInfo.offset = 0;
-    descriptorBufferInfo.range = ref.size;
+    pool.freeSets -= 1;
 
-    writeDescriptorSet.pBufferInfo = &descriptorBufferInfo;
-    writeDescriptorSet.pImageInfo = nullptr;
-    writeDescriptorSet.pTexelBufferView = nullptr;
+    for ( const auto &[ type, count ]: setState.descriptorCounts )
+    {
+        pool.freeDescriptors[ type ] -= count;
+    }
 
-    context->logicalDevice.updateDescriptorSets( 1, &writeDescriptorSet, 0, nullptr );
+    return result;
 }
 
-void DescriptorManager::updateTexture( const uint32_t &frameIndex, const std::string &uniformName, const VulkanTextureWrapper &buffer, const uint32_t& objectIndex )
+void DescriptorManager::evictResource( const uint64_t &uid )
 {
-    ensureTextureHasDescriptor( frameIndex, uniformName, objectIndex );
+    for ( auto it = cachedSets.begin( ); it != cachedSets.end( ); )
+    {
+        const CachedSet &cachedSet = it->second;
 
-    // Todo + texture index when texture arrays are implemented
-    const std::string &key = getUniformKey( uniformName );
+        auto usesResource = std::find_if( cachedSet.resources.begin( ), cachedSet.resources.end( ), [ &uid ]( const BoundResource &resource )
+        {
+            return resource.uid == uid;
+        } );
 
-    frameUpdatedTextures[ frameIndex ][ uniformName ] = true;
+        if ( usesResource == cachedSet.resources.end( ) )
+        {
+            ++it;
+            continue;
+        }
 
-    UniformLocation &uniformLocation = uniformLocations[ key ];
-    BindingUpdateInfo updateInfo {
-            uniformLocation.binding,
-            textureSetMaps[ uniformName ][ objectIndex ][ frameIndex ]
-    };
+        for ( auto &setState: setStates )
+        {
+            if ( setState.current == cachedSet.set )
+            {
+                setState.current = vk::DescriptorSet { };
+                setState.dirty = true;
+            }
+        }
+
+        DescriptorPool &pool = descriptorPools[ cachedSet.pool ];
+        context->logicalDevice.freeDescriptorSets( pool.pool, 1, &cachedSet.set );
+
+        pool.freeSets += 1;
 
-    const DescriptorSet &set = shaderSet->getDescriptorSetBySetId( uniformLocation.set );
-    const DescriptorSetBinding &ref = set.descriptorSetBindings[ uniformLocation.binding ];
-    vk::WriteDescriptorSet writeDescriptorSet = getCommonWriteDescriptorSet( uniformLocation, updateInfo );
+        for ( const auto &setState: setStates )
+        {
+            SKIP_ITERATION_IF( setState.layout != cachedSet.layout )
 
-    vk::DescriptorImageInfo descriptorImageInfo { };
-    descriptorImageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-    descriptorImageInfo.imageView = buffer.imageView;
-    descriptorImageInfo.sampler = buffer.sampler;
+            for ( const auto &[ type, count ]: setState.descriptorCounts )
+            {
+                pool.freeDescriptors[ type ] += count;
+            }
 
-    writeDescriptorSet.pImageInfo = &descriptorImageInfo;
-    writeDescriptorSet.pBufferInfo = nullptr;
-    writeDescriptorSet.pTexelBufferView = nullptr;
+            break;
+        }
 
-    context->logicalDevice.updateDescriptorSets( 1, &writeDescriptorSet, 0, nullptr );
+        it = cachedSets.erase( it );
+    }
 }
 
 const std::vector< vk::DescriptorSetLayout > &DescriptorManager::getLayouts( )
@@ -328,41 +430,67 @@ const std::vector< vk::DescriptorSetLayout > &DescriptorManager::getLayouts( )
     return layouts;
 }
 
-std::vector< vk::DescriptorSet > DescriptorManager::getOrderedSets( const uint32_t &frame, const uint32_t& objectIndex )
+std::vector< vk::DescriptorSet > DescriptorManager::getOrderedSets( const uint32_t &frame )
 {
-    std::vector< vk::DescriptorSet > set( orders.size( ) );
+    for ( const auto &textureName: bindlessTextureNames )
+    {
+        if ( frameUpdatedTextures[ frame ].find( textureName ) == frameUpdatedTextures[ frame ].end( ) )
+        {
+            updateTexture( frame, textureName, emptyImage );
+        }
+    }
 
-    for ( uint32_t i = 0; i < set.size( ); ++i )
+    for ( const auto &order: orders )
     {
-        std::string &uniformName = orders[ i ].name;
+        SKIP_ITERATION_IF( order.type != vk::DescriptorType::eCombinedImageSampler || int( order.set ) == bindlessSet )
 
-        if ( orders[ i ].type == vk::DescriptorType::eCombinedImageSampler )
+        // In case an image input is not provided pass a null image
+        if ( frameUpdatedTextures[ frame ].find( order.name ) == frameUpdatedTextures[ frame ].end( ) )
         {
-            auto &objects = textureSetMaps[ uniformName ];
-            // If it is an object updated per frame and not per object, only the 0th index will have values
-            // Todo maybe add the possibility to mark an descriptorSet as per frame or per object
-            // In case an image input is not provided pass a null image
-            if ( objects.empty( ) || frameUpdatedTextures[ frame ].find( uniformName ) == frameUpdatedTextures[ frame ].end( ) )
-            {
-                auto logEntry = boost::format( "Note, the shader input with name: %1% has no matching parameter a null value is being passed." ) % uniformName;
-
-                Core::Logger::get( ).log( Core::Verbosity::Debug, "AssetManager", logEntry.str( ).c_str( ) );
+            auto logEntry = boost::format( "Note, the shader input with name: %1% has no matching parameter a null value is being passed." ) % order.name;
 
-                updateTexture( frame, uniformName, emptyImage, objectIndex );
-                objects = textureSetMaps[ uniformName ];
-            }
+            Core::Logger::get( ).log( Core::Verbosity::Debug, "AssetManager", logEntry.str( ).c_str( ) );
 
-            set[ i ] = objects[ objectIndex ].empty( ) ? objects[ 0 ][ frame ] : objects[ objectIndex ][ frame ];
+            updateTexture( frame, order.name, emptyImage );
         }
-        else
+    }
+
+    std::vector< vk::DescriptorSet > result( setStates.size( ) );
+
+    for ( uint32_t i = 0; i < setStates.size( ); ++i )
+    {
+        DescriptorSetState &setState = setStates[ i ];
+
+        if ( int( i ) == bindlessSet )
         {
-            const auto &objects = uniformSetMaps[ uniformName ];
+            result[ i ] = context->bindlessTextures->getSet( );
+            continue;
+        }
 
-            set[ i ] = objects[ objectIndex ].empty( ) ? objects[ 0 ][ frame ] : objects[ objectIndex ][ frame ];
+        if ( setState.dirty )
+        {
+            setState.current = resolveSet( setState );
+            setState.dirty = false;
         }
+
+        result[ i ] = setState.current;
+    }
+
+    return result;
+}
+
+std::vector< uint32_t > DescriptorManager::getDynamicOffsets( const uint32_t &set )
+{
+    std::vector< uint32_t > result { };
+
+    // Ordered by binding, the order dynamic descriptors appear in the set
+    for ( const auto &order: orders )
+    {
+        SKIP_ITERATION_IF( order.set != set || order.type != vk::DescriptorType::eUniformBufferDynamic )
+        result.push_back( dynamicOffsets[ order.name ] );
     }
 
-    return set;
+    return result;
 }
 
 std::vector< PushConstantParent > DescriptorManager::getPushConstantBindings( const uint32_t &frame )
@@ -377,45 +505,61 @@ std::vector< PushConstantParent > DescriptorManager::getPushConstantBindings( co
     return result;
 }
 
-std::string DescriptorManager::getUniformKey( const std::string &uniformName, const int &arrayIndex )
+uint32_t DescriptorManager::findFreeDescriptorPool( const DescriptorSetState &setState )
 {
-    if ( arrayIndex == -1 )
+    for ( uint32_t i = 0; i < descriptorPools.size( ); ++i )
+    {
+        if ( fitsInPool( descriptorPools[ i ], setState ) )
+        {
+            return i;
+        }
+    }
+
+    // Every pool ran out of sets or of a descriptor type the layout needs
+    createDescriptorPool( );
+
+    if ( !fitsInPool( descriptorPools.back( ), setState ) )
     {
-        return uniformName;
+        throw GraphicsException( "DescriptorManager", "Descriptor set layout needs more descriptors than a descriptor pool holds." );
     }
 
-    std::stringstream key;
-    key << uniformName << arrayIndex;
-    return key.str( );
+    return descriptorPools.size( ) - 1;
 }
 
-DescriptorPool& DescriptorManager::findFreeDescriptorPool( const bool& findUniformPool, const uint32_t& requiredAllocations )
+bool DescriptorManager::fitsInPool( const DescriptorPool &pool, const DescriptorSetState &setState )
 {
-    auto & pools = findUniformPool ? uniformDescriptorPool : samplerDescriptorPool;
+    if ( pool.fragmented || pool.freeSets == 0 )
+    {
+        return false;
+    }
 
-    for ( DescriptorPool & pool : pools )
+    for ( const auto &[ type, count ]: setState.descriptorCounts )
     {
-        if ( pool.freeDescriptors >= requiredAllocations )
+        auto freeDescriptors = pool.freeDescriptors.find( type );
+
+        if ( freeDescriptors == pool.freeDescriptors.end( ) || freeDescriptors->second < count )
         {
-            return pool;
+            return false;
         }
     }
 
-    // No free descriptor not found
-    createDescriptorPool( );
-    return findFreeDescriptorPool( findUniformPool, requiredAllocations );
+    return true;
 }
 
 DescriptorManager::~DescriptorManager( )
 {
+    context->resourceDestroyedListeners.erase( this );
+
     free( nullAttachment->content );
     context->vma.destroyImage( emptyImage.image, emptyImage.allocation );
     context->logicalDevice.destroySampler( emptyImage.sampler );
     context->logicalDevice.destroyImageView( emptyImage.imageView );
 
-    for ( auto &layout: layouts )
+    for ( uint32_t i = 0; i < layouts.size( ); ++i )
     {
-        context->logicalDevice.destroyDescriptorSetLayout( layout );
+        // The bindless layout is shared by every pipeline and owned by the device
+        SKIP_ITERATION_IF( int( i ) == bindlessSet )
+        context->logicalDevice.destroyDescriptorSetLayout( layouts[ i ] );
     }
 
     for ( auto &stage: stagesWithPushConstants )
@@ -426,12 +570,7 @@ DescriptorManager::~DescriptorManager( )
         }
     }
 
-    for ( auto & pool: uniformDescriptorPool )
-    {
-        context->logicalDevice.destroyDescriptorPool( pool.pool );
-    }
-
-    for ( auto & pool: samplerDescriptorPool )
+    for ( auto & pool: descriptorPools )
     {
         context->logicalDevice.destroyDescriptorPool( pool.pool );
     }
@@ -17,96 +17,109 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <BlazarGraphics/VulkanBackend/GLSLShaderSet.h>
-#include <BlazarGraphics/VulkanBackend/SpirvHelper.h>
+
+#include <algorithm>
+#include <filesystem>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
+GLSLShaderInfo::GLSLShaderInfo( vk::ShaderStageFlagBits type, const std::string &path )
+{
+    this->type = type;
+    data = SpirvCache::compile( type, path );
+
+    const std::string reflectionFile = ShaderReflection::getReflectionFile( path );
+
+    if ( std::filesystem::exists( reflectionFile ) && ShaderReflection::deserialize( Core::Utilities::readFile( reflectionFile ), data, reflection ) )
+    {
+        ASSERT_M( reflection.stage == type, reflectionFile + " was reflected for another shader stage!" );
+        return;
+    }
+
+#ifdef RUNTIME_SHADER_REFLECTION
+    reflection = ShaderReflection::reflect( type, data );
+#else
+    throw std::runtime_error( path + " has no up to date " + reflectionFile + " and runtime shader reflection is disabled." );
+#endif
+}
+
 GLSLShaderSet::GLSLShaderSet( const std::vector< GLSLShaderInfo > &shaderInfos, const bool &interleavedMode ) : interleavedMode( interleavedMode )
 {
     for ( const GLSLShaderInfo &shaderInfo : shaderInfos )
     {
         onEachShader( shaderInfo );
     }
+
+    // Sets can hold several bindings and be shared between stages, they are only listed once all stages are reflected
+    for ( const auto &set: descriptorSetMap )
+    {
+        SKIP_ITERATION_IF( set.second.descriptorSetBindings.empty( ) )
+        descriptorSets.push_back( set.second );
+    }
+
+    std::sort( descriptorSets.begin( ), descriptorSets.end( ), [ ]( const DescriptorSet &s1, const DescriptorSet &s2 )
+    {
+        return s1.id < s2.id;
+    } );
 }
 
 void GLSLShaderSet::onEachShader( const GLSLShaderInfo &shaderInfo )
 {
-    spirv_cross::Compiler compiler( shaderInfo.data );
-
-    auto shaderResources = compiler.get_shader_resources( );
-
-    auto stageInputs = shaderResources.stage_inputs;
-    auto samplers = shaderResources.sampled_images;
-    auto uniforms = shaderResources.uniform_buffers;
-    auto shaderPushConstants = shaderResources.push_constant_buffers;
+    const ShaderReflection &reflection = shaderInfo.reflection;
 
     uint32_t offsetIter = 0;
 
-    // TODO is this fine? if so maybe throw an error if no vertex shader i
     if ( shaderInfo.type == vk::ShaderStageFlagBits::eVertex )
     {
-        std::sort( stageInputs.begin( ), stageInputs.end( ), [ & ]( const spirv_cross::Resource &r1, const spirv_cross::Resource &r2 )
+        // Inputs are sorted by location
+        for ( const ReflectedVertexInput &input : reflection.vertexInputs )
         {
-            SpvDecoration decoration1 = getDecoration( compiler, r1 );
-            SpvDecoration decoration2 = getDecoration( compiler, r2 );
-            return decoration1.location < decoration2.location;
-        } );
-
-        for ( const spirv_cross::Resource &resource : stageInputs )
-        {
-            SpvDecoration decoration = getDecoration( compiler, resource );
-            GLSLShaderSet::GLSLType gType = spvToGLSLType( decoration.type );
-            createVertexInput( offsetIter, gType, decoration.location );
-            offsetIter += gType.size;
+            createVertexInput( offsetIter, input );
+            offsetIter += input.size;
         }
 
         if ( interleavedMode )
         {
             vk::VertexInputBindingDescription &bindingDesc = inputBindingDescriptions.emplace_back( vk::VertexInputBindingDescription { } );
             bindingDesc.binding = 0;
-            bindingDesc.inputRate = vk::VertexInputRate::eVertex; // TODO investigate later for instanced rendering
+            bindingDesc.inputRate = vk::VertexInputRate::eVertex; // Per instance data is read from the InstanceData storage buffer
             bindingDesc.stride = offsetIter;
         }
     }
 
-    for ( const spirv_cross::Resource &resource : samplers )
+    for ( const ReflectedBinding &reflectedBinding : reflection.bindings )
     {
-        DescriptorBindingCreateInfo createInfo;
-        createInfo.binding = 0;
-        createInfo.resource = resource;
-        createInfo.stage = shaderInfo.type;
-        createInfo.type = vk::DescriptorType::eCombinedImageSampler;
+        createDescriptorSetBinding( reflectedBinding, shaderInfo.type );
 
-        createDescriptorSetBinding( compiler, createInfo );
-    }
+        SKIP_ITERATION_IF( reflectedBinding.inputAttachmentIndex < 0 )
 
-    for ( const spirv_cross::Resource &resource : uniforms )
-    {
-        DescriptorBindingCreateInfo createInfo;
-        createInfo.binding = 0;
-        createInfo.resource = resource;
-        createInfo.stage = shaderInfo.type;
-        createInfo.type = vk::DescriptorType::eUniformBuffer;
+        const uint32_t attachmentIndex = reflectedBinding.inputAttachmentIndex;
 
-        createDescriptorSetBinding( compiler, createInfo );
+        if ( inputAttachments.size( ) <= attachmentIndex )
+        {
+            inputAttachments.resize( attachmentIndex + 1 );
+        }
+
+        inputAttachments[ attachmentIndex ] = reflectedBinding.name;
     }
 
-    for ( const spirv_cross::Resource &resource : shaderPushConstants )
+    for ( const ReflectedPushConstant &reflectedPushConstant : reflection.pushConstants )
     {
-        SpvDecoration decoration = getDecoration( compiler, resource );
+        const uint32_t offset = reflectedPushConstant.children.empty( ) ? 0 : reflectedPushConstant.children.front( ).offset;
 
         vk::PushConstantRange pushConstant { };
-        pushConstant.offset = 0; // TODO Could a push constant have any other offset?
-        pushConstant.size = decoration.size;
+        pushConstant.offset = offset;
+        pushConstant.size = reflectedPushConstant.size - offset;
         pushConstant.stageFlags = shaderInfo.type;
 
         pushConstants.push_back( std::move( pushConstant ) );
 
         auto &detail = pushConstantDetails.emplace_back( );
         detail.stage = shaderInfo.type;
-        detail.size = decoration.size;
-        detail.name = decoration.name;
-        detail.children = std::move( decoration.children );
+        detail.offset = offset;
+        detail.size = reflectedPushConstant.size;
+        detail.name = reflectedPushConstant.name;
+        detail.children = reflectedPushConstant.children;
     }
 }
 
@@ -119,7 +132,7 @@ void GLSLShaderSet::ensureSetExists( uint32_t set )
     }
 }
 
-void GLSLShaderSet::createVertexInput( const uint32_t &offset, const GLSLType &type, const uint32_t &location )
+void GLSLShaderSet::createVertexInput( const uint32_t &offset, const ReflectedVertexInput &input )
 {
     vk::VertexInputAttributeDescription &desc = vertexAttributeDescriptions.emplace_back( vk::VertexInputAttributeDescription { } );
 
@@ -131,234 +144,66 @@ void GLSLShaderSet::createVertexInput( const uint32_t &offset, const GLSLType &t
     {
         vk::VertexInputBindingDescription &bindingDesc = inputBindingDescriptions.emplace_back( vk::VertexInputBindingDescription { } );
         bindingDesc.binding = inputBindingDescriptions.size( ) - 1;
-        bindingDesc.inputRate = vk::VertexInputRate::eVertex; // TODO investigate later for instanced rendering
+        bindingDesc.inputRate = vk::VertexInputRate::eVertex; // Per instance data is read from the InstanceData storage buffer
         bindingDesc.stride = 0;
 
         desc.binding = bindingDesc.binding;
     }
 
-    desc.location = location;
-    desc.format = type.format;
+    desc.location = input.location;
+    desc.format = input.format;
     desc.offset = offset;
 }
 
-
-void GLSLShaderSet::createDescriptorSetBinding( const spirv_cross::Compiler &compiler, const DescriptorBindingCreateInfo &bindingCreateInfo )
+void GLSLShaderSet::createDescriptorSetBinding( const ReflectedBinding &reflectedBinding, const vk::ShaderStageFlagBits &stage )
 {
-    SpvDecoration decoration = getDecoration( compiler, bindingCreateInfo.resource );
-    auto stages = compiler.get_entry_points_and_stages( );
-
-    DescriptorSet &descriptorSet = descriptorSetMap[ decoration.set ];
+    ensureSetExists( reflectedBinding.set );
+    DescriptorSet &descriptorSet = descriptorSetMap[ reflectedBinding.set ];
 
-    if ( descriptorSet.descriptorSetBindingMap.find( decoration.name ) != descriptorSet.descriptorSetBindingMap.end( ) )
+    if ( descriptorSet.descriptorSetBindingMap.find( reflectedBinding.name ) != descriptorSet.descriptorSetBindingMap.end( ) )
     {
-        updateDecoration( bindingCreateInfo, decoration, descriptorSet );
+        updateDecoration( reflectedBinding, stage );
 
         return;
     }
 
     vk::DescriptorSetLayoutBinding &layoutBinding = descriptorSet.descriptorSetLayoutBindings.emplace_back( vk::DescriptorSetLayoutBinding { } );
 
-    layoutBinding.binding = decoration.binding;
-    layoutBinding.descriptorType = bindingCreateInfo.type;
-    layoutBinding.descriptorCount = decoration.arraySize;
-    layoutBinding.stageFlags = bindingCreateInfo.stage;
+    layoutBinding.binding = reflectedBinding.binding;
+    layoutBinding.descriptorType = reflectedBinding.type;
+    layoutBinding.descriptorCount = reflectedBinding.descriptorCount;
+    layoutBinding.stageFlags = stage;
 
     DescriptorSetBinding &binding = descriptorSet.descriptorSetBindings.emplace_back( DescriptorSetBinding { } );
     binding.index = descriptorSet.descriptorSetBindings.size( ) - 1;
-    binding.size = decoration.size;
-    binding.type = bindingCreateInfo.type;
-    binding.name = decoration.name;
+    binding.size = reflectedBinding.size;
+    binding.type = reflectedBinding.type;
+    binding.name = reflectedBinding.name;
     binding.layout = layoutBinding;
 
-    descriptorSet.descriptorSetBindingMap[ decoration.name ] = binding;
-    descriptorSets.emplace_back( descriptorSet );
+    descriptorSet.descriptorSetBindingMap[ reflectedBinding.name ] = binding;
 }
 
-void GLSLShaderSet::updateDecoration( const GLSLShaderSet::DescriptorBindingCreateInfo &bindingCreateInfo, const GLSLShaderSet::SpvDecoration &decoration, const DescriptorSet &descriptorSet )
+void GLSLShaderSet::updateDecoration( const ReflectedBinding &reflectedBinding, const vk::ShaderStageFlagBits &stage )
 {
-    DescriptorSetBinding &binding = descriptorSetMap[ decoration.set ].descriptorSetBindingMap[ decoration.name ];
-    binding.layout.stageFlags |= bindingCreateInfo.stage;
+    DescriptorSetBinding &binding = descriptorSetMap[ reflectedBinding.set ].descriptorSetBindingMap[ reflectedBinding.name ];
+    binding.layout.stageFlags |= stage;
 
-    for ( auto &set: descriptorSets )
-    {
-        for ( auto &setBinding: set.descriptorSetBindings )
-        {
-            if ( setBinding.name == binding.name )
-            {
-                setBinding.layout.stageFlags |= bindingCreateInfo.stage;
-
-                for ( auto &layoutBinding: set.descriptorSetLayoutBindings )
-                {
-                    if ( layoutBinding.binding == decoration.binding )
-                    {
-                        layoutBinding.stageFlags |= bindingCreateInfo.stage;
-                    }
-                }
-            }
-        }
-    }
-
-    for ( auto &setBinding: descriptorSetMap[ decoration.set ].descriptorSetBindings )
+    for ( auto &setBinding: descriptorSetMap[ reflectedBinding.set ].descriptorSetBindings )
     {
         if ( setBinding.name == binding.name )
         {
-            setBinding.layout.stageFlags |= bindingCreateInfo.stage;
-        }
-    }
-
-    for ( auto &layoutBinding: descriptorSetMap[ decoration.set ].descriptorSetLayoutBindings )
-    {
-        if ( layoutBinding.binding == decoration.binding )
-        {
-            layoutBinding.stageFlags |= bindingCreateInfo.stage;
+            setBinding.layout.stageFlags |= stage;
         }
     }
-}
-
-GLSLShaderSet::GLSLType GLSLShaderSet::spvToGLSLType( const spirv_cross::SPIRType &type )
-{
-    vk::Format format = vk::Format::eUndefined;
-    uint32_t size = 0;
-
-    auto make32Int = [ ]( const uint32_t &numOfElements ) -> vk::Format
-    {
-        if (numOfElements == 1) return vk::Format::eR32Sint;
-        if (numOfElements == 2) return vk::Format::eR32G32Sint;
-        if (numOfElements == 3) return vk::Format::eR32G32B32Sint;
-        if (numOfElements == 4) return vk::Format::eR32G32B32A32Sint;
-        return vk::Format::eUndefined;
-    };
-
-    auto make64Int = [ ]( const uint32_t &numOfElements ) -> vk::Format
-    {
-        if (numOfElements == 1) return vk::Format::eR64Sint;
-        if (numOfElements == 2) return vk::Format::eR64G64Sint;
-        if (numOfElements == 3) return vk::Format::eR64G64B64Sint;
-        if (numOfElements == 4) return vk::Format::eR64G64B64A64Sint;
-        return vk::Format::eUndefined;
-    };
-
-    auto make32UInt = [ ]( const uint32_t &numOfElements ) -> vk::Format
-    {
-        if (numOfElements == 1) return vk::Format::eR32Uint;
-        if (numOfElements == 2) return vk::Format::eR32G32Uint;
-        if (numOfElements == 3) return vk::Format::eR32G32B32Uint;
-        if (numOfElements == 4) return vk::Format::eR32G32B32A32Uint;
-        return vk::Format::eUndefined;
-    };
-
-    auto make64UInt = [ ]( const uint32_t &numOfElements ) -> vk::Format
-    {
-        if (numOfElements == 1) return vk::Format::eR64Uint;
-        if (numOfElements == 2) return vk::Format::eR64G64Uint;
-        if (numOfElements == 3) return vk::Format::eR64G64B64Uint;
-        if (numOfElements == 4) return vk::Format::eR64G64B64A64Uint;
-        return vk::Format::eUndefined;
-    };
-
-    auto make32Float = [ ]( const uint32_t &numOfElements ) -> vk::Format
-    {
-        if (numOfElements == 1) return vk::Format::eR32Sfloat;
-        if (numOfElements == 2) return vk::Format::eR32G32Sfloat;
-        if (numOfElements == 3) return vk::Format::eR32G32B32Sfloat;
-        if (numOfElements == 4) return vk::Format::eR32G32B32A32Sfloat;
-        return vk::Format::eUndefined;
-    };
-
-    auto make64Float = [ ]( const uint32_t &numOfElements ) -> vk::Format
-    {
-        if (numOfElements == 1) return vk::Format::eR64Sfloat;
-        if (numOfElements == 2) return vk::Format::eR64G64Sfloat;
-        if (numOfElements == 3) return vk::Format::eR64G64B64Sfloat;
-        if (numOfElements == 4) return vk::Format::eR64G64B64A64Sfloat;
-        return vk::Format::eUndefined;
-    };
-
-    switch ( type.basetype )
-    {
-        default:
-            break;
-        case spirv_cross::SPIRType::Short:
-        case spirv_cross::SPIRType::UShort:
-        case spirv_cross::SPIRType::Int:
-            format = make32Int( type.vecsize );
-            size = sizeof( int32_t );
-            break;
-        case spirv_cross::SPIRType::Int64:
-            format = make32Int( type.vecsize );
-            size = sizeof( int64_t );
-            break;
-        case spirv_cross::SPIRType::UInt:
-            format = make32UInt( type.vecsize );
-            size = sizeof( uint32_t );
-            break;
-        case spirv_cross::SPIRType::UInt64:
-            format = make64UInt( type.vecsize );
-            size = sizeof( uint64_t );
-            break;
-        case spirv_cross::SPIRType::Float:
-            format = make32Float( type.vecsize );
-            size = sizeof( float );
-            break;
-        case spirv_cross::SPIRType::Double:
-            format = make64Float( type.vecsize );
-            size = sizeof( double );
-            break;
-    }
-
-
-    return GLSLType { format, size * type.vecsize };
-}
 
-GLSLShaderSet::SpvDecoration GLSLShaderSet::getDecoration( const spirv_cross::Compiler &compiler, const spirv_cross::Resource &resource )
-{
-    SpvDecoration decoration { };
-
-    decoration.set = compiler.get_decoration( resource.id, spv::DecorationDescriptorSet );
-    decoration.type = compiler.get_type( resource.type_id );
-
-    if ( decoration.type.basetype == spirv_cross::SPIRType::Struct )
+    for ( auto &layoutBinding: descriptorSetMap[ reflectedBinding.set ].descriptorSetLayoutBindings )
     {
-        uint32_t structSize = compiler.get_declared_struct_size( decoration.type );
-        // Doesn't seem necessary at the moment:
-        // uint32_t m1_size = compiler.get_declared_struct_member_size( decoration.type, 0 );
-        uint32_t offsetIter = 0;
-
-        uint32_t size = 0;
-
-        for ( uint32_t i = 0; offsetIter != structSize; i++ )
+        if ( layoutBinding.binding == reflectedBinding.binding )
         {
-            size = compiler.get_declared_struct_member_size( decoration.type, i );
-
-            auto &child = decoration.children.emplace_back( );
-
-            child.offset = offsetIter;
-            child.size = size;
-            child.name = compiler.get_member_name( resource.base_type_id, i );
-
-            offsetIter += size;
+            layoutBinding.stageFlags |= stage;
         }
-
-        decoration.size = structSize;
     }
-
-    decoration.location = compiler.get_decoration( resource.id, spv::DecorationLocation );
-    decoration.binding = compiler.get_decoration( resource.id, spv::DecorationBinding );
-
-    uint32_t totalArraySize = 0;
-
-    for ( uint32_t dimensionSize : decoration.type.array )
-    {
-        totalArraySize += dimensionSize;
-    }
-
-    decoration.arraySize = totalArraySize == 0 ? 1 : decoration.size / totalArraySize;
-    decoration.name = resource.name;
-
-    ensureSetExists( decoration.set );
-
-    return decoration;
 }
 
-END_NAMESPACES
\ No newline at end of file
+END_NAMESPACES
@@ -0,0 +1,159 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/ParallelCommandRecorder.h>
+#include <BlazarCore/TaskPool.h>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+ParallelCommandRecorder::ParallelCommandRecorder( VulkanContext * context, const uint32_t &frameCount ) : context( context )
+{
+    // The calling thread records a chunk as well
+    chunkCount = Core::TaskPool::getWorkerCount( ) + 1;
+
+    vk::CommandPoolCreateInfo commandPoolCreateInfo { };
+    commandPoolCreateInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+    commandPoolCreateInfo.queueFamilyIndex = context->queueFamilies[ QueueType::Graphics ].index;
+
+    commandPools.resize( chunkCount );
+    trackers.resize( chunkCount );
+    secondaryBuffers.resize( frameCount );
+
+    for ( auto &commandPool: commandPools )
+    {
+        commandPool = context->logicalDevice.createCommandPool( commandPoolCreateInfo );
+    }
+
+    for ( auto &frameBuffers: secondaryBuffers )
+    {
+        for ( const auto &commandPool: commandPools )
+        {
+            vk::CommandBufferAllocateInfo bufferAllocateInfo { };
+            bufferAllocateInfo.level = vk::CommandBufferLevel::eSecondary;
+            bufferAllocateInfo.commandPool = commandPool;
+            bufferAllocateInfo.commandBufferCount = 1;
+
+            frameBuffers.push_back( context->logicalDevice.allocateCommandBuffers( bufferAllocateInfo )[ 0 ] );
+        }
+    }
+}
+
+void ParallelCommandRecorder::record( const uint32_t &frameIndex, const vk::CommandBuffer &primary, const vk::CommandBufferInheritanceInfo &inheritanceInfo,
+                                      const PassRecordingState &state, const RecordedDraw *draws, const uint32_t &drawCount, CommandRecordingStats &stats )
+{
+    // Chunks are contiguous, executing them in order keeps the submission order of the draws
+    const uint32_t drawsPerChunk = ( drawCount + chunkCount - 1 ) / chunkCount;
+    const uint32_t usedChunks = ( drawCount + drawsPerChunk - 1 ) / drawsPerChunk;
+
+    auto recordChunk = [ & ]( const uint32_t &chunk )
+    {
+        vk::CommandBufferBeginInfo beginInfo { };
+        beginInfo.flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        const vk::CommandBuffer &buffer = secondaryBuffers[ frameIndex ][ chunk ];
+        buffer.begin( beginInfo );
+
+        CommandStateTracker &tracker = trackers[ chunk ];
+        tracker.begin( buffer );
+
+        const uint32_t end = std::min< uint32_t >( ( chunk + 1 ) * drawsPerChunk, drawCount );
+
+        for ( uint32_t i = chunk * drawsPerChunk; i < end; ++i )
+        {
+            recordDraw( tracker, state, draws[ i ] );
+        }
+
+        buffer.end( );
+    };
+
+    Core::TaskPool::run( usedChunks, recordChunk );
+
+    for ( uint32_t chunk = 0; chunk < usedChunks; ++chunk )
+    {
+        stats.emitted += trackers[ chunk ].getStats( ).emitted;
+        stats.elided += trackers[ chunk ].getStats( ).elided;
+    }
+
+    primary.executeCommands( usedChunks, secondaryBuffers[ frameIndex ].data( ) );
+}
+
+void ParallelCommandRecorder::recordDraw( CommandStateTracker &tracker, const PassRecordingState &state, const RecordedDraw &draw )
+{
+    tracker.setViewport( state.viewport );
+    tracker.setScissor( state.scissor );
+    tracker.bindPipeline( draw.bindPoint, draw.pipeline, draw.layout );
+    tracker.bindVertexBuffer( draw.vertexBuffer );
+
+    if ( draw.indexBuffer )
+    {
+        tracker.bindIndexBuffer( draw.indexBuffer );
+    }
+
+    if ( state.setDepthBias )
+    {
+        tracker.setDepthBias( state.depthBiasConstant, state.depthBiasSlope );
+    }
+
+    for ( uint32_t set = 0; set < draw.descriptorSets.size( ); ++set )
+    {
+        tracker.bindDescriptorSet( draw.bindPoint, set, draw.descriptorSets[ set ], draw.dynamicOffsets[ set ] );
+    }
+
+    for ( const auto &pushConstant: draw.pushConstants )
+    {
+        tracker.pushConstants( pushConstant.stage, pushConstant.offset, pushConstant.data.size( ), pushConstant.data.data( ) );
+    }
+
+    if ( draw.indexBuffer )
+    {
+        tracker.getCommandBuffer( ).drawIndexed( draw.count, draw.instanceCount, draw.firstElement, draw.vertexOffset, draw.firstInstance );
+    }
+    else
+    {
+        tracker.getCommandBuffer( ).draw( draw.count, draw.instanceCount, draw.firstElement, draw.firstInstance );
+    }
+}
+
+void ParallelCommandRecorder::recordDispatch( CommandStateTracker &tracker, const RecordedDraw &dispatch )
+{
+    tracker.bindPipeline( dispatch.bindPoint, dispatch.pipeline, dispatch.layout );
+
+    for ( uint32_t set = 0; set < dispatch.descriptorSets.size( ); ++set )
+    {
+        tracker.bindDescriptorSet( dispatch.bindPoint, set, dispatch.descriptorSets[ set ], dispatch.dynamicOffsets[ set ] );
+    }
+
+    for ( const auto &pushConstant: dispatch.pushConstants )
+    {
+        tracker.pushConstants( pushConstant.stage, pushConstant.offset, pushConstant.data.size( ), pushConstant.data.data( ) );
+    }
+
+    tracker.getCommandBuffer( ).dispatch( dispatch.groupCount[ 0 ], dispatch.groupCount[ 1 ], dispatch.groupCount[ 2 ] );
+}
+
+ParallelCommandRecorder::~ParallelCommandRecorder( )
+{
+    // Destroying a pool frees the buffers allocated from it
+    for ( const auto &commandPool: commandPools )
+    {
+        context->logicalDevice.destroyCommandPool( commandPool );
+    }
+}
+
+END_NAMESPACES
@@ -0,0 +1,124 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/PipelineCache.h>
+#include <BlazarCore/Logger.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+PipelineCache::PipelineCache( VulkanContext * context, std::string path ) : context( context ), path( std::move( path ) )
+{
+    const std::string initialData = loadInitialData( );
+
+    vk::PipelineCacheCreateInfo createInfo { };
+    createInfo.initialDataSize = initialData.size( );
+    createInfo.pInitialData = initialData.empty( ) ? nullptr : initialData.data( );
+
+    cache = context->logicalDevice.createPipelineCache( createInfo );
+}
+
+std::string PipelineCache::loadInitialData( ) const
+{
+    std::ifstream file( path, std::ios::binary );
+
+    if ( !file.is_open( ) )
+    {
+        return { };
+    }
+
+    std::string data( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >( ) );
+
+    if ( !isCompatible( data ) )
+    {
+        Core::Logger::get( ).log( Core::Verbosity::Information, "PipelineCache", "Ignoring the pipeline cache of another device or driver." );
+        return { };
+    }
+
+    return data;
+}
+
+bool PipelineCache::isCompatible( const std::string &data ) const
+{
+    // VkPipelineCacheHeaderVersionOne, drivers should reject foreign data themselves but not all of them do
+    struct Header
+    {
+        uint32_t headerSize;
+        uint32_t headerVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint8_t pipelineCacheUUID[ VK_UUID_SIZE ];
+    };
+
+    if ( data.size( ) < sizeof( Header ) )
+    {
+        return false;
+    }
+
+    Header header { };
+    memcpy( &header, data.data( ), sizeof( Header ) );
+
+    // The UUID changes with the driver version
+    const vk::PhysicalDeviceProperties properties = context->physicalDevice.getProperties( );
+
+    return header.headerSize >= sizeof( Header ) && header.headerSize <= data.size( ) &&
+           header.headerVersion == static_cast< uint32_t >( vk::PipelineCacheHeaderVersion::eOne ) &&
+           header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           memcmp( header.pipelineCacheUUID, properties.pipelineCacheUUID.data( ), VK_UUID_SIZE ) == 0;
+}
+
+void PipelineCache::save( ) const
+{
+    const std::vector< uint8_t > data = context->logicalDevice.getPipelineCacheData( cache );
+
+    // Written under a temporary name and moved in place so a crash mid write never leaves a partial cache behind
+    const std::string temporaryFile = path + ".tmp";
+
+    {
+        std::ofstream file( temporaryFile, std::ios::binary | std::ios::trunc );
+
+        if ( !file.is_open( ) )
+        {
+            Core::Logger::get( ).log( Core::Verbosity::Warning, "PipelineCache", "Failed to write the pipeline cache to " + path + "." );
+            return;
+        }
+
+        file.write( reinterpret_cast< const char * >( data.data( ) ), data.size( ) );
+    }
+
+    std::error_code error;
+    std::filesystem::rename( temporaryFile, path, error );
+
+    if ( error )
+    {
+        Core::Logger::get( ).log( Core::Verbosity::Warning, "PipelineCache", "Failed to replace the pipeline cache at " + path + "." );
+    }
+}
+
+PipelineCache::~PipelineCache( )
+{
+    save( );
+    context->logicalDevice.destroyPipelineCache( cache );
+}
+
+END_NAMESPACES
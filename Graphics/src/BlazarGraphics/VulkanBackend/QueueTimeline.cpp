@@ -0,0 +1,243 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/QueueTimeline.h>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+QueueTimeline::QueueTimeline( VulkanContext * context, const QueueType &queueType, const bool &useTimelineSemaphore ) :
+        context( context ), queueType( queueType ), useTimelineSemaphore( useTimelineSemaphore )
+{
+    FUNCTION_BREAK( !useTimelineSemaphore )
+
+    vk::SemaphoreTypeCreateInfoKHR semaphoreTypeCreateInfo { };
+    semaphoreTypeCreateInfo.semaphoreType = vk::SemaphoreTypeKHR::eTimeline;
+    semaphoreTypeCreateInfo.initialValue = 0;
+
+    vk::SemaphoreCreateInfo semaphoreCreateInfo { };
+    semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+    semaphore = context->logicalDevice.createSemaphore( semaphoreCreateInfo );
+}
+
+uint64_t QueueTimeline::submit( const std::vector< vk::SubmitInfo > &submitInfos )
+{
+    const uint64_t value = ++submittedValue;
+
+    std::vector< vk::SubmitInfo > batches = submitInfos;
+    vk::TimelineSemaphoreSubmitInfoKHR timelineSubmitInfo { };
+    vk::Fence fence = nullptr;
+
+    // Storage of the last batch when cross queue waits are merged into it, has to outlive the submit call
+    std::vector< vk::Semaphore > waitSemaphores;
+    std::vector< vk::PipelineStageFlags > waitStages;
+    std::vector< uint64_t > waitValues;
+    vk::TimelineSemaphoreSubmitInfoKHR waitSubmitInfo { };
+
+    if ( !pendingWaits.empty( ) && !batches.empty( ) )
+    {
+        // Only the batch consuming the other queue's results waits, earlier batches may start right away
+        vk::SubmitInfo &lastBatch = batches.back( );
+
+        waitSemaphores.assign( lastBatch.pWaitSemaphores, lastBatch.pWaitSemaphores + lastBatch.waitSemaphoreCount );
+        waitStages.assign( lastBatch.pWaitDstStageMask, lastBatch.pWaitDstStageMask + lastBatch.waitSemaphoreCount );
+        waitValues.resize( waitSemaphores.size( ), 0 ); // Ignored for binary semaphores
+
+        for ( const auto &pendingWait: pendingWaits )
+        {
+            waitSemaphores.push_back( pendingWait.semaphore );
+            waitStages.push_back( pendingWait.stage );
+            waitValues.push_back( pendingWait.value );
+        }
+
+        waitSubmitInfo.pNext = lastBatch.pNext;
+        waitSubmitInfo.waitSemaphoreValueCount = waitValues.size( );
+        waitSubmitInfo.pWaitSemaphoreValues = waitValues.data( );
+
+        lastBatch.pNext = &waitSubmitInfo;
+        lastBatch.waitSemaphoreCount = waitSemaphores.size( );
+        lastBatch.pWaitSemaphores = waitSemaphores.data( );
+        lastBatch.pWaitDstStageMask = waitStages.data( );
+
+        pendingWaits.clear( );
+    }
+
+    if ( useTimelineSemaphore )
+    {
+        // Signaled by a trailing empty batch, it only signals after every batch submitted before it completed
+        timelineSubmitInfo.signalSemaphoreValueCount = 1;
+        timelineSubmitInfo.pSignalSemaphoreValues = &value;
+
+        vk::SubmitInfo &signalBatch = batches.emplace_back( );
+        signalBatch.pNext = &timelineSubmitInfo;
+        signalBatch.signalSemaphoreCount = 1;
+        signalBatch.pSignalSemaphores = &semaphore;
+    }
+    else
+    {
+        if ( freeFences.empty( ) )
+        {
+            fence = context->logicalDevice.createFence( vk::FenceCreateInfo { } );
+        }
+        else
+        {
+            fence = freeFences.back( );
+            freeFences.pop_back( );
+        }
+
+        pendingFences.emplace_back( value, fence );
+    }
+
+    VkCheckResult( context->queues[ queueType ].submit( batches.size( ), batches.data( ), fence ) );
+
+    collect( );
+    return value;
+}
+
+void QueueTimeline::wait( const uint64_t &value )
+{
+    if ( value > getCompletedValue( ) )
+    {
+        if ( useTimelineSemaphore )
+        {
+            vk::SemaphoreWaitInfoKHR waitInfo { };
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &semaphore;
+            waitInfo.pValues = &value;
+
+            VkCheckResult( context->logicalDevice.waitSemaphoresKHR( waitInfo, UINT64_MAX ) );
+        }
+        else
+        {
+            auto reached = std::find_if( pendingFences.begin( ), pendingFences.end( ), [ & ]( const auto &pending )
+            {
+                return pending.first >= value;
+            } );
+
+            if ( reached != pendingFences.end( ) )
+            {
+                VkCheckResult( context->logicalDevice.waitForFences( 1, &reached->second, true, UINT64_MAX ) );
+            }
+        }
+    }
+
+    collect( );
+}
+
+uint64_t QueueTimeline::getCompletedValue( )
+{
+    if ( useTimelineSemaphore )
+    {
+        completedValue = context->logicalDevice.getSemaphoreCounterValueKHR( semaphore );
+        return completedValue;
+    }
+
+    while ( !pendingFences.empty( ) && context->logicalDevice.getFenceStatus( pendingFences.front( ).second ) == vk::Result::eSuccess )
+    {
+        completedValue = pendingFences.front( ).first;
+
+        context->logicalDevice.resetFences( pendingFences.front( ).second );
+        freeFences.push_back( pendingFences.front( ).second );
+        pendingFences.pop_front( );
+    }
+
+    return completedValue;
+}
+
+void QueueTimeline::waitFor( QueueTimeline * other, const uint64_t &value, const vk::PipelineStageFlags &stage )
+{
+    FUNCTION_BREAK( other == this || value == 0 )
+    ASSERT_M( useTimelineSemaphore && other->useTimelineSemaphore, "Cross queue waits require timeline semaphores!" );
+
+    pendingWaits.push_back( CrossQueueWait { other->semaphore, value, stage } );
+}
+
+void QueueTimeline::retireAt( const uint64_t &value, std::function< void( ) > release )
+{
+    if ( value <= getCompletedValue( ) )
+    {
+        release( );
+        return;
+    }
+
+    retirements.emplace( value, std::move( release ) );
+}
+
+void QueueTimeline::retireAfterPending( std::function< void( ) > release )
+{
+    // Uploads submitted in between take the next values without the recorded passes, the value is only known once they are flushed
+    pendingRetirements.push_back( std::move( release ) );
+}
+
+void QueueTimeline::retirePendingAt( const uint64_t &value )
+{
+    // Moved out first, a release running right away may retire further resources
+    auto releases = std::move( pendingRetirements );
+    pendingRetirements.clear( );
+
+    for ( auto &release: releases )
+    {
+        retireAt( value, std::move( release ) );
+    }
+}
+
+void QueueTimeline::collect( )
+{
+    const uint64_t completed = getCompletedValue( );
+
+    while ( !retirements.empty( ) && retirements.begin( )->first <= completed )
+    {
+        // Removed before running, a release may retire further resources
+        auto release = std::move( retirements.begin( )->second );
+        retirements.erase( retirements.begin( ) );
+
+        release( );
+    }
+}
+
+QueueTimeline::~QueueTimeline( )
+{
+    context->queues[ queueType ].waitIdle( );
+    getCompletedValue( );
+
+    // Nothing is in flight anymore, including values that were never submitted
+    while ( !retirements.empty( ) || !pendingRetirements.empty( ) )
+    {
+        retirePendingAt( submittedValue );
+
+        while ( !retirements.empty( ) )
+        {
+            auto release = std::move( retirements.begin( )->second );
+            retirements.erase( retirements.begin( ) );
+
+            release( );
+        }
+    }
+
+    for ( const auto &fence: freeFences )
+    {
+        context->logicalDevice.destroyFence( fence );
+    }
+
+    if ( useTimelineSemaphore )
+    {
+        context->logicalDevice.destroySemaphore( semaphore );
+    }
+}
+
+END_NAMESPACES
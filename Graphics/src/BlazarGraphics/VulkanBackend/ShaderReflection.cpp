@@ -0,0 +1,174 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/ShaderReflection.h>
+#include <boost/functional/hash.hpp>
+
+#include <filesystem>
+#include <sstream>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+// Bumped when the layout of the files changes
+static const uint32_t REFLECTION_FORMAT_VERSION = 1;
+static const char * REFLECTION_FORMAT_NAME = "BlazarShaderReflection";
+
+size_t ShaderReflection::hashSpirv( const std::vector< uint32_t > &spirv )
+{
+    return boost::hash_range( spirv.begin( ), spirv.end( ) );
+}
+
+std::string ShaderReflection::getReflectionFile( const std::string &shaderPath )
+{
+    return std::filesystem::path( shaderPath ).replace_extension( SHADER_REFLECTION_EXTENSION ).string( );
+}
+
+/*
+ * One record per line, names are GLSL identifiers and never contain whitespace:
+ *  input <location> <format> <size>
+ *  binding <set> <binding> <type> <descriptor count> <size> <input attachment index> <name>
+ *  push_constant <size> <child count> <name>
+ *  member <offset> <size> <name>, children of the preceding push constant
+ */
+std::string ShaderReflection::serialize( ) const
+{
+    std::stringstream result;
+
+    result << REFLECTION_FORMAT_NAME << " " << REFLECTION_FORMAT_VERSION << "\n";
+    result << "stage " << static_cast< uint32_t >( stage ) << "\n";
+    result << "spirv " << spirvHash << "\n";
+
+    for ( const auto &input: vertexInputs )
+    {
+        result << "input " << input.location << " " << static_cast< uint32_t >( input.format ) << " " << input.size << "\n";
+    }
+
+    for ( const auto &binding: bindings )
+    {
+        result << "binding " << binding.set << " " << binding.binding << " " << static_cast< uint32_t >( binding.type ) << " "
+               << binding.descriptorCount << " " << binding.size << " " << binding.inputAttachmentIndex << " " << binding.name << "\n";
+    }
+
+    for ( const auto &pushConstant: pushConstants )
+    {
+        result << "push_constant " << pushConstant.size << " " << pushConstant.children.size( ) << " " << pushConstant.name << "\n";
+
+        for ( const auto &child: pushConstant.children )
+        {
+            result << "member " << child.offset << " " << child.size << " " << child.name << "\n";
+        }
+    }
+
+    return result.str( );
+}
+
+bool ShaderReflection::deserialize( const std::string &data, const std::vector< uint32_t > &spirv, ShaderReflection &result )
+{
+    std::istringstream lines( data );
+    std::string line;
+
+    std::string formatName;
+    uint32_t formatVersion = 0;
+
+    if ( !std::getline( lines, line ) || !( std::istringstream( line ) >> formatName >> formatVersion ) ||
+         formatName != REFLECTION_FORMAT_NAME || formatVersion != REFLECTION_FORMAT_VERSION )
+    {
+        return false;
+    }
+
+    result = ShaderReflection { };
+
+    while ( std::getline( lines, line ) )
+    {
+        std::istringstream record( line );
+        std::string recordType;
+
+        SKIP_ITERATION_IF( !( record >> recordType ) )
+
+        uint32_t value = 0;
+
+        if ( recordType == "stage" )
+        {
+            if ( !( record >> value ) )
+            {
+                return false;
+            }
+
+            result.stage = static_cast< vk::ShaderStageFlagBits >( value );
+        }
+        else if ( recordType == "spirv" )
+        {
+            if ( !( record >> result.spirvHash ) )
+            {
+                return false;
+            }
+        }
+        else if ( recordType == "input" )
+        {
+            auto &input = result.vertexInputs.emplace_back( );
+
+            if ( !( record >> input.location >> value >> input.size ) )
+            {
+                return false;
+            }
+
+            input.format = static_cast< vk::Format >( value );
+        }
+        else if ( recordType == "binding" )
+        {
+            auto &binding = result.bindings.emplace_back( );
+
+            if ( !( record >> binding.set >> binding.binding >> value >> binding.descriptorCount >> binding.size >> binding.inputAttachmentIndex >> binding.name ) )
+            {
+                return false;
+            }
+
+            binding.type = static_cast< vk::DescriptorType >( value );
+        }
+        else if ( recordType == "push_constant" )
+        {
+            auto &pushConstant = result.pushConstants.emplace_back( );
+            uint32_t childCount = 0;
+
+            if ( !( record >> pushConstant.size >> childCount >> pushConstant.name ) )
+            {
+                return false;
+            }
+
+            pushConstant.children.reserve( childCount );
+        }
+        else if ( recordType == "member" && !result.pushConstants.empty( ) )
+        {
+            auto &child = result.pushConstants.back( ).children.emplace_back( );
+
+            if ( !( record >> child.offset >> child.size >> child.name ) )
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // The SPIR-V was rebuilt without its reflection
+    return result.spirvHash == hashSpirv( spirv );
+}
+
+END_NAMESPACES
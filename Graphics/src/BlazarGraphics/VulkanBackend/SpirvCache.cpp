@@ -0,0 +1,256 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/SpirvCache.h>
+#ifdef RUNTIME_SHADER_COMPILATION
+#include <BlazarGraphics/VulkanBackend/SpirvHelper.h>
+#endif
+#include <BlazarCore/Utilities.h>
+#include <BlazarCore/Logger.h>
+#include <boost/functional/hash.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+static const uint32_t SPIRV_MAGIC_NUMBER = 0x07230203;
+// First word of a cache file, "BZSC"
+static const uint32_t CACHE_MAGIC_NUMBER = 0x43535A42;
+
+// Bumped when the layout of the files on disk changes
+static const uint32_t CACHE_FORMAT_VERSION = 2;
+
+std::mutex SpirvCache::cacheLock;
+std::unordered_map< std::string, std::vector< uint32_t > > SpirvCache::memoryCache;
+
+std::vector< uint32_t > SpirvCache::compile( const vk::ShaderStageFlagBits stage, const std::string &requestedPath )
+{
+    const std::string path = resolveSource( requestedPath );
+    const std::string source = Core::Utilities::readFile( path );
+
+    // Shaders compiled by the BlazarShaders target are loaded as they are
+    std::vector< uint32_t > spirv;
+    if ( toSpirv( source, spirv ) )
+    {
+        return spirv;
+    }
+
+#ifdef RUNTIME_SHADER_COMPILATION
+    const std::string identity = createIdentity( stage, path, source );
+
+    {
+        std::lock_guard< std::mutex > lock( cacheLock );
+
+        auto cached = memoryCache.find( identity );
+        if ( cached != memoryCache.end( ) )
+        {
+            return cached->second;
+        }
+    }
+
+    if ( !loadFromDisk( identity, spirv ) )
+    {
+        spirv = SpirvHelper::GLSLtoSPV( stage, source.c_str( ) );
+
+        // Failed compilations are retried, the error is logged every time the shader is requested
+        if ( spirv.empty( ) )
+        {
+            return spirv;
+        }
+
+        saveToDisk( identity, spirv );
+    }
+
+    std::lock_guard< std::mutex > lock( cacheLock );
+    memoryCache[ identity ] = spirv;
+
+    return spirv;
+#else
+    throw std::runtime_error( path + " is not compiled SPIR-V and the runtime shader compiler is disabled." );
+#endif
+}
+
+std::string SpirvCache::resolveSource( const std::string &path )
+{
+    const std::filesystem::path spirvPath( path );
+
+    if ( std::filesystem::exists( spirvPath ) || spirvPath.extension( ) != ".spv" )
+    {
+        return path;
+    }
+
+    // Shaders/SPIRV/<stage>/<name>.spv is built from Shaders/<stage>/<name>.glsl, which is copied next to it either way
+    const std::filesystem::path stageDirectory = spirvPath.parent_path( );
+    const std::filesystem::path spirvDirectory = stageDirectory.parent_path( );
+
+    if ( spirvDirectory.filename( ) != "SPIRV" )
+    {
+        return path;
+    }
+
+    std::filesystem::path glslPath = spirvDirectory.parent_path( ) / stageDirectory.filename( ) / spirvPath.filename( );
+    glslPath.replace_extension( ".glsl" );
+
+    return std::filesystem::exists( glslPath ) ? glslPath.string( ) : path;
+}
+
+bool SpirvCache::toSpirv( const std::string &data, std::vector< uint32_t > &spirv )
+{
+    if ( data.size( ) < sizeof( uint32_t ) || data.size( ) % sizeof( uint32_t ) != 0 )
+    {
+        return false;
+    }
+
+    uint32_t magicNumber;
+    memcpy( &magicNumber, data.data( ), sizeof( uint32_t ) );
+
+    if ( magicNumber != SPIRV_MAGIC_NUMBER )
+    {
+        return false;
+    }
+
+    spirv.resize( data.size( ) / sizeof( uint32_t ) );
+    memcpy( spirv.data( ), data.data( ), data.size( ) );
+
+    return true;
+}
+
+#ifdef RUNTIME_SHADER_COMPILATION
+
+std::string SpirvCache::createIdentity( const vk::ShaderStageFlagBits stage, const std::string &path, const std::string &source )
+{
+    std::stringstream header;
+    header << "format " << CACHE_FORMAT_VERSION << "\n";
+    header << "generator " << glslang::GetSpirvGeneratorVersion( ) << "\n";
+    header << "glslang " << GetGlslVersionString( ) << "\n";
+    header << "stage " << static_cast< uint32_t >( stage ) << "\n";
+
+    // Sources are prefixed by their size so no concatenation of different files reads the same
+    std::string identity = header.str( );
+    identity += std::to_string( source.size( ) ) + "\n" + source;
+
+    std::unordered_set< std::string > visited;
+    appendIncludes( identity, Core::Utilities::getFileDirectory( path ), source, visited );
+
+    return identity;
+}
+
+void SpirvCache::appendIncludes( std::string &identity, const std::string &directory, const std::string &source, std::unordered_set< std::string > &visited )
+{
+    std::istringstream lines( source );
+    std::string line;
+
+    while ( std::getline( lines, line ) )
+    {
+        const size_t directive = line.find( "#include" );
+        SKIP_ITERATION_IF( directive == std::string::npos || line.find_first_not_of( " \t" ) != directive )
+
+        const size_t nameBegin = line.find( '"', directive );
+        const size_t nameEnd = line.find( '"', nameBegin + 1 );
+        SKIP_ITERATION_IF( nameBegin == std::string::npos || nameEnd == std::string::npos )
+
+        const std::string includePath = directory + line.substr( nameBegin + 1, nameEnd - nameBegin - 1 );
+        SKIP_ITERATION_IF( !visited.insert( includePath ).second )
+
+        // Missing includes are left for the compiler to report
+        SKIP_ITERATION_IF( !std::filesystem::exists( includePath ) )
+
+        const std::string includeSource = Core::Utilities::readFile( includePath );
+        identity += includePath + "\n" + std::to_string( includeSource.size( ) ) + "\n" + includeSource;
+
+        appendIncludes( identity, Core::Utilities::getFileDirectory( includePath ), includeSource, visited );
+    }
+}
+
+bool SpirvCache::loadFromDisk( const std::string &identity, std::vector< uint32_t > &spirv )
+{
+    std::ifstream file( getCacheFile( identity ), std::ios::binary );
+
+    if ( !file.is_open( ) )
+    {
+        return false;
+    }
+
+    const std::string data( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >( ) );
+
+    // Header: magic number, identity size, identity, followed by the SPIR-V
+    const uint64_t headerSize = sizeof( uint32_t ) + sizeof( uint64_t );
+
+    if ( data.size( ) < headerSize )
+    {
+        return false;
+    }
+
+    uint32_t magicNumber;
+    uint64_t identitySize;
+    memcpy( &magicNumber, data.data( ), sizeof( uint32_t ) );
+    memcpy( &identitySize, data.data( ) + sizeof( uint32_t ), sizeof( uint64_t ) );
+
+    // Files of other formats, other compiler versions or a colliding hash are compiled again and overwritten
+    if ( magicNumber != CACHE_MAGIC_NUMBER || identitySize != identity.size( ) || data.size( ) < headerSize + identitySize ||
+         data.compare( headerSize, identitySize, identity ) != 0 )
+    {
+        return false;
+    }
+
+    return toSpirv( data.substr( headerSize + identitySize ), spirv );
+}
+
+void SpirvCache::saveToDisk( const std::string &identity, const std::vector< uint32_t > &spirv )
+{
+    std::error_code error;
+    std::filesystem::create_directories( SPIRV_CACHE_PATH, error );
+
+    // Written under a temporary name and moved in place so other processes never read a partial file
+    const std::string cacheFile = getCacheFile( identity );
+    const std::string temporaryFile = cacheFile + ".tmp";
+
+    {
+        std::ofstream file( temporaryFile, std::ios::binary | std::ios::trunc );
+
+        if ( !file.is_open( ) )
+        {
+            Core::Logger::get( ).log( Core::Verbosity::Warning, "SpirvCache", "Failed to write the SPIR-V cache to " + cacheFile + "." );
+            return;
+        }
+
+        const uint64_t identitySize = identity.size( );
+
+        file.write( reinterpret_cast< const char * >( &CACHE_MAGIC_NUMBER ), sizeof( uint32_t ) );
+        file.write( reinterpret_cast< const char * >( &identitySize ), sizeof( uint64_t ) );
+        file.write( identity.data( ), identity.size( ) );
+        file.write( reinterpret_cast< const char * >( spirv.data( ) ), spirv.size( ) * sizeof( uint32_t ) );
+    }
+
+    std::filesystem::rename( temporaryFile, cacheFile, error );
+}
+
+std::string SpirvCache::getCacheFile( const std::string &identity )
+{
+    std::stringstream name;
+    name << std::hex << boost::hash_value( identity ) << ".spvcache";
+
+    return SPIRV_CACHE_PATH + name.str( );
+}
+
+#endif
+
+END_NAMESPACES
@@ -0,0 +1,229 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/ShaderReflection.h>
+#include "spirv_cross.hpp"
+
+#include <algorithm>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+struct SpvDecoration
+{
+    spirv_cross::SPIRType type;
+    uint32_t set;
+    uint32_t location;
+    uint32_t binding;
+    uint32_t arraySize;
+    uint32_t size;
+    std::string name;
+    std::vector< StructChild > children;
+};
+
+static SpvDecoration getDecoration( const spirv_cross::Compiler &compiler, const spirv_cross::Resource &resource )
+{
+    SpvDecoration decoration { };
+
+    decoration.set = compiler.get_decoration( resource.id, spv::DecorationDescriptorSet );
+    decoration.type = compiler.get_type( resource.type_id );
+
+    if ( decoration.type.basetype == spirv_cross::SPIRType::Struct )
+    {
+        uint32_t structSize = compiler.get_declared_struct_size( decoration.type );
+
+        for ( uint32_t i = 0; i < decoration.type.member_types.size( ); i++ )
+        {
+            auto &child = decoration.children.emplace_back( );
+
+            // Members may start at an explicit offset, i.e. push constants placed after another stage's range
+            child.offset = compiler.type_struct_member_offset( decoration.type, i );
+            child.size = compiler.get_declared_struct_member_size( decoration.type, i );
+            child.name = compiler.get_member_name( resource.base_type_id, i );
+        }
+
+        decoration.size = structSize;
+    }
+
+    decoration.location = compiler.get_decoration( resource.id, spv::DecorationLocation );
+    decoration.binding = compiler.get_decoration( resource.id, spv::DecorationBinding );
+
+    uint32_t totalArraySize = 0;
+
+    for ( uint32_t dimensionSize : decoration.type.array )
+    {
+        totalArraySize += dimensionSize;
+    }
+
+    decoration.arraySize = totalArraySize == 0 ? 1 : decoration.size / totalArraySize;
+    decoration.name = resource.name;
+
+    return decoration;
+}
+
+static ReflectedVertexInput toVertexInput( const SpvDecoration &decoration )
+{
+    const spirv_cross::SPIRType &type = decoration.type;
+
+    vk::Format format = vk::Format::eUndefined;
+    uint32_t size = 0;
+
+    auto make32Int = [ ]( const uint32_t &numOfElements ) -> vk::Format
+    {
+        if (numOfElements == 1) return vk::Format::eR32Sint;
+        if (numOfElements == 2) return vk::Format::eR32G32Sint;
+        if (numOfElements == 3) return vk::Format::eR32G32B32Sint;
+        if (numOfElements == 4) return vk::Format::eR32G32B32A32Sint;
+        return vk::Format::eUndefined;
+    };
+
+    auto make64UInt = [ ]( const uint32_t &numOfElements ) -> vk::Format
+    {
+        if (numOfElements == 1) return vk::Format::eR64Uint;
+        if (numOfElements == 2) return vk::Format::eR64G64Uint;
+        if (numOfElements == 3) return vk::Format::eR64G64B64Uint;
+        if (numOfElements == 4) return vk::Format::eR64G64B64A64Uint;
+        return vk::Format::eUndefined;
+    };
+
+    auto make32UInt = [ ]( const uint32_t &numOfElements ) -> vk::Format
+    {
+        if (numOfElements == 1) return vk::Format::eR32Uint;
+        if (numOfElements == 2) return vk::Format::eR32G32Uint;
+        if (numOfElements == 3) return vk::Format::eR32G32B32Uint;
+        if (numOfElements == 4) return vk::Format::eR32G32B32A32Uint;
+        return vk::Format::eUndefined;
+    };
+
+    auto make32Float = [ ]( const uint32_t &numOfElements ) -> vk::Format
+    {
+        if (numOfElements == 1) return vk::Format::eR32Sfloat;
+        if (numOfElements == 2) return vk::Format::eR32G32Sfloat;
+        if (numOfElements == 3) return vk::Format::eR32G32B32Sfloat;
+        if (numOfElements == 4) return vk::Format::eR32G32B32A32Sfloat;
+        return vk::Format::eUndefined;
+    };
+
+    auto make64Float = [ ]( const uint32_t &numOfElements ) -> vk::Format
+    {
+        if (numOfElements == 1) return vk::Format::eR64Sfloat;
+        if (numOfElements == 2) return vk::Format::eR64G64Sfloat;
+        if (numOfElements == 3) return vk::Format::eR64G64B64Sfloat;
+        if (numOfElements == 4) return vk::Format::eR64G64B64A64Sfloat;
+        return vk::Format::eUndefined;
+    };
+
+    switch ( type.basetype )
+    {
+        default:
+            break;
+        case spirv_cross::SPIRType::Short:
+        case spirv_cross::SPIRType::UShort:
+        case spirv_cross::SPIRType::Int:
+            format = make32Int( type.vecsize );
+            size = sizeof( int32_t );
+            break;
+        case spirv_cross::SPIRType::Int64:
+            format = make32Int( type.vecsize );
+            size = sizeof( int64_t );
+            break;
+        case spirv_cross::SPIRType::UInt:
+            format = make32UInt( type.vecsize );
+            size = sizeof( uint32_t );
+            break;
+        case spirv_cross::SPIRType::UInt64:
+            format = make64UInt( type.vecsize );
+            size = sizeof( uint64_t );
+            break;
+        case spirv_cross::SPIRType::Float:
+            format = make32Float( type.vecsize );
+            size = sizeof( float );
+            break;
+        case spirv_cross::SPIRType::Double:
+            format = make64Float( type.vecsize );
+            size = sizeof( double );
+            break;
+    }
+
+    return ReflectedVertexInput { decoration.location, format, size * type.vecsize };
+}
+
+static void addBindings( ShaderReflection &reflection, const spirv_cross::Compiler &compiler,
+                         const spirv_cross::SmallVector< spirv_cross::Resource > &resources, const vk::DescriptorType &type )
+{
+    for ( const spirv_cross::Resource &resource: resources )
+    {
+        SpvDecoration decoration = getDecoration( compiler, resource );
+
+        auto &binding = reflection.bindings.emplace_back( );
+        binding.set = decoration.set;
+        binding.binding = decoration.binding;
+        binding.type = type;
+        binding.descriptorCount = decoration.arraySize;
+        binding.size = decoration.size;
+        binding.name = decoration.name;
+
+        if ( type == vk::DescriptorType::eInputAttachment )
+        {
+            binding.inputAttachmentIndex = int( compiler.get_decoration( resource.id, spv::DecorationInputAttachmentIndex ) );
+        }
+    }
+}
+
+ShaderReflection ShaderReflection::reflect( const vk::ShaderStageFlagBits &stage, const std::vector< uint32_t > &spirv )
+{
+    spirv_cross::Compiler compiler( spirv );
+    auto shaderResources = compiler.get_shader_resources( );
+
+    ShaderReflection reflection { };
+    reflection.stage = stage;
+    reflection.spirvHash = hashSpirv( spirv );
+
+    // TODO is this fine? if so maybe throw an error if no vertex shader i
+    if ( stage == vk::ShaderStageFlagBits::eVertex )
+    {
+        for ( const spirv_cross::Resource &resource: shaderResources.stage_inputs )
+        {
+            reflection.vertexInputs.push_back( toVertexInput( getDecoration( compiler, resource ) ) );
+        }
+
+        std::sort( reflection.vertexInputs.begin( ), reflection.vertexInputs.end( ), [ ]( const ReflectedVertexInput &i1, const ReflectedVertexInput &i2 )
+        {
+            return i1.location < i2.location;
+        } );
+    }
+
+    addBindings( reflection, compiler, shaderResources.sampled_images, vk::DescriptorType::eCombinedImageSampler );
+    addBindings( reflection, compiler, shaderResources.subpass_inputs, vk::DescriptorType::eInputAttachment );
+    addBindings( reflection, compiler, shaderResources.uniform_buffers, vk::DescriptorType::eUniformBufferDynamic );
+    addBindings( reflection, compiler, shaderResources.storage_buffers, vk::DescriptorType::eStorageBuffer );
+    addBindings( reflection, compiler, shaderResources.storage_images, vk::DescriptorType::eStorageImage );
+
+    for ( const spirv_cross::Resource &resource: shaderResources.push_constant_buffers )
+    {
+        SpvDecoration decoration = getDecoration( compiler, resource );
+
+        auto &pushConstant = reflection.pushConstants.emplace_back( );
+        pushConstant.size = decoration.size;
+        pushConstant.name = decoration.name;
+        pushConstant.children = std::move( decoration.children );
+    }
+
+    return reflection;
+}
+
+END_NAMESPACES
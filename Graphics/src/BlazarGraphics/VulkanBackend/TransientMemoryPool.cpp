@@ -0,0 +1,129 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/TransientMemoryPool.h>
+
+NAMESPACES( ENGINE_NAMESPACE, Graphics )
+
+TransientMemoryPool::TransientMemoryPool( VulkanContext * context ) : context( context )
+{ }
+
+void TransientMemoryPool::reserve( const uint32_t &frameIndex, const int32_t &aliasGroup, const vk::ImageCreateInfo &imageCreateInfo )
+{
+    std::shared_ptr< Block > &block = blocks[ { frameIndex, aliasGroup } ];
+
+    if ( block == nullptr )
+    {
+        block = std::make_shared< Block >( );
+    }
+
+    // Allocated blocks are not resized, images that do not fit get a new block when created
+    FUNCTION_BREAK( block->allocation )
+
+    vk::Image image = context->logicalDevice.createImage( imageCreateInfo );
+    const vk::MemoryRequirements requirements = context->logicalDevice.getImageMemoryRequirements( image );
+    context->logicalDevice.destroyImage( image );
+
+    if ( block->requirements.size == 0 )
+    {
+        block->requirements = requirements;
+        return;
+    }
+
+    // An image without a common memory type is left out, it cannot share the allocation
+    FUNCTION_BREAK( ( block->requirements.memoryTypeBits & requirements.memoryTypeBits ) == 0 )
+
+    block->requirements.size = std::max( block->requirements.size, requirements.size );
+    block->requirements.alignment = std::max( block->requirements.alignment, requirements.alignment );
+    block->requirements.memoryTypeBits &= requirements.memoryTypeBits;
+}
+
+vk::Image TransientMemoryPool::createImage( const uint32_t &frameIndex, const int32_t &aliasGroup, const vk::ImageCreateInfo &imageCreateInfo )
+{
+    vk::Image image = context->logicalDevice.createImage( imageCreateInfo );
+    const vk::MemoryRequirements requirements = context->logicalDevice.getImageMemoryRequirements( image );
+
+    std::shared_ptr< Block > &block = blocks[ { frameIndex, aliasGroup } ];
+
+    // Happens after a resize or for images left out by reserve, the replaced block lives until its last image is destroyed
+    if ( block == nullptr || !fits( *block, requirements ) )
+    {
+        block = std::make_shared< Block >( );
+        block->requirements = requirements;
+    }
+
+    if ( !block->allocation )
+    {
+        vma::AllocationCreateInfo allocationCreateInfo { };
+        allocationCreateInfo.usage = vma::MemoryUsage::eGpuOnly;
+
+        block->allocation = context->vma.allocateMemory( block->requirements, allocationCreateInfo );
+    }
+
+    context->vma.bindImageMemory( block->allocation, image );
+
+    ++block->boundImages;
+    boundBlocks[ image ] = block;
+
+    return image;
+}
+
+void TransientMemoryPool::destroyImage( const vk::Image &image )
+{
+    auto find = boundBlocks.find( image );
+    FUNCTION_BREAK( find == boundBlocks.end( ) )
+
+    context->logicalDevice.destroyImage( image );
+
+    if ( --find->second->boundImages == 0 )
+    { // The reserved requirements are kept, the next image of the group allocates the block again
+        context->vma.freeMemory( find->second->allocation );
+        find->second->allocation = nullptr;
+    }
+
+    boundBlocks.erase( find );
+}
+
+bool TransientMemoryPool::fits( const Block &block, const vk::MemoryRequirements &requirements ) const
+{
+    if ( !block.allocation )
+    {
+        return ( block.requirements.memoryTypeBits & requirements.memoryTypeBits ) == block.requirements.memoryTypeBits &&
+               block.requirements.size >= requirements.size && block.requirements.alignment % requirements.alignment == 0;
+    }
+
+    const vma::AllocationInfo allocationInfo = context->vma.getAllocationInfo( block.allocation );
+
+    return ( requirements.memoryTypeBits & ( 1u << allocationInfo.memoryType ) ) &&
+           allocationInfo.size >= requirements.size && allocationInfo.offset % requirements.alignment == 0;
+}
+
+TransientMemoryPool::~TransientMemoryPool( )
+{
+    for ( auto &[ image, block ]: boundBlocks )
+    {
+        context->logicalDevice.destroyImage( image );
+
+        if ( --block->boundImages == 0 )
+        {
+            context->vma.freeMemory( block->allocation );
+        }
+    }
+}
+
+END_NAMESPACES
@@ -36,8 +36,82 @@ std::shared_ptr< BeginCommandExecution > VulkanCommandExecutor::startCommandExec
     return std::shared_ptr< BeginCommandExecution >( pExecution );
 }
 
+bool VulkanCommandExecutor::isComplete( const ExecutionTicket &ticket )
+{
+    if ( ticket > context->graphicsTimeline->getCompletedValue( ) )
+    {
+        return false;
+    }
+
+    // Callers polling a ticket expect its completion callback to have released the staging buffers
+    context->graphicsTimeline->collect( );
+    return true;
+}
+
+void VulkanCommandExecutor::wait( const ExecutionTicket &ticket )
+{
+    context->graphicsTimeline->wait( ticket );
+}
+
+std::vector< vk::CommandBuffer > VulkanCommandExecutor::acquireBuffers( const uint16_t &count )
+{
+    std::vector< vk::CommandBuffer > buffers;
+
+    // Recycled buffers are reset implicitly when they are begun, the pool allows resetting individual buffers
+    while ( buffers.size( ) < count && !freeBuffers.empty( ) )
+    {
+        buffers.push_back( freeBuffers.back( ) );
+        freeBuffers.pop_back( );
+    }
+
+    if ( buffers.size( ) < count )
+    {
+        vk::CommandBufferAllocateInfo bufferAllocateInfo { };
+        bufferAllocateInfo.level = vk::CommandBufferLevel::ePrimary;
+        bufferAllocateInfo.commandPool = commandPool;
+        bufferAllocateInfo.commandBufferCount = count - buffers.size( );
+
+        for ( const auto &buffer: context->logicalDevice.allocateCommandBuffers( bufferAllocateInfo ) )
+        {
+            buffers.push_back( buffer );
+        }
+    }
+
+    return buffers;
+}
+
+void VulkanCommandExecutor::releaseBuffers( const std::vector< vk::CommandBuffer > &buffers )
+{
+    freeBuffers.insert( freeBuffers.end( ), buffers.begin( ), buffers.end( ) );
+}
+
+ExecutionTicket VulkanCommandExecutor::submit( std::vector< vk::CommandBuffer > buffers, std::function< void( ) > onComplete )
+{
+    vk::SubmitInfo submitInfo { };
+    submitInfo.commandBufferCount = buffers.size( );
+    submitInfo.pCommandBuffers = buffers.data( );
+
+    lastTicket = context->graphicsTimeline->submit( { submitInfo } );
+
+    context->graphicsTimeline->retireAt( lastTicket, [ this, buffers = std::move( buffers ), onComplete = std::move( onComplete ) ]( )
+    {
+        if ( onComplete )
+        {
+            onComplete( );
+        }
+
+        releaseBuffers( buffers );
+    } );
+
+    return lastTicket;
+}
+
 VulkanCommandExecutor::~VulkanCommandExecutor( )
 {
+    // Runs the completion callbacks still referencing this executor
+    context->graphicsTimeline->wait( lastTicket );
+
+    // Destroying the pool frees every buffer allocated from it
     context->logicalDevice.destroyCommandPool( commandPool );
 }
 
@@ -47,14 +121,7 @@ BeginCommandExecution::BeginCommandExecution( VulkanCommandExecutor *executor )
 std::shared_ptr< CommandList >
 BeginCommandExecution::generateBuffers( vk::CommandBufferUsageFlags usage, uint16_t bufferCount )
 {
-    buffers.resize( bufferCount );
-
-    vk::CommandBufferAllocateInfo bufferAllocateInfo { };
-    bufferAllocateInfo.level = vk::CommandBufferLevel::ePrimary;
-    bufferAllocateInfo.commandPool = executor->commandPool;
-    bufferAllocateInfo.commandBufferCount = bufferCount;
-
-    buffers = executor->context->logicalDevice.allocateCommandBuffers( bufferAllocateInfo );
+    buffers = executor->acquireBuffers( bufferCount );
 
     auto *pCommandList = new CommandList { executor, buffers, usage };
     return std::move( std::shared_ptr< CommandList >( pCommandList ) );
@@ -77,16 +144,27 @@ CommandList *CommandList::beginCommand( )
     return this;
 }
 
-CommandList *CommandList::copyBuffer( const vk::DeviceSize &size, vk::Buffer &src, vk::Buffer &dst )
+CommandList *CommandList::copyBuffer( const vk::DeviceSize &size, vk::Buffer &src, vk::Buffer &dst, const vk::DeviceSize &dstOffset )
 {
     ENSURE_FILTER
 
     for ( vk::CommandBuffer buffer: buffers )
     {
+        // dst may be updated in place while earlier submissions still read it, the copy waits for them to finish
+        buffer.pipelineBarrier( vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, { }, 0, nullptr, 0, nullptr, 0, nullptr );
+
         vk::BufferCopy bufferCopy { };
+        bufferCopy.dstOffset = dstOffset;
         bufferCopy.size = size;
 
         buffer.copyBuffer( src, dst, 1, &bufferCopy );
+
+        // Submissions are no longer waited on, later reads of dst are ordered by this barrier instead
+        vk::MemoryBarrier memoryBarrier { };
+        memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        memoryBarrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+
+        buffer.pipelineBarrier( vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, { }, 1, &memoryBarrier, 0, nullptr, 0, nullptr );
     }
 
     return this;
@@ -354,22 +432,16 @@ CommandList::bindDescriptorSet( const vk::PipelineLayout &pipelineLayout, const
     return this;
 }
 
-vk::Result CommandList::execute( )
+ExecutionTicket CommandList::execute( std::function< void( ) > onComplete )
 {
     for ( vk::CommandBuffer buffer: buffers )
     {
         buffer.end( );
     }
 
-    vk::SubmitInfo submitInfo { };
-    submitInfo.commandBufferCount = buffers.size( );
-    submitInfo.pCommandBuffers = buffers.data( );
-
-    vk::Queue queue = executor->context->queues[ QueueType::Graphics ];
-    vk::Result result = queue.submit( 1, &submitInfo, nullptr );
-    queue.waitIdle( );
-
-    return result;
+    // The executor owns the buffers from now on, they are recycled once the submission completes
+    submitted = true;
+    return executor->submit( buffers, std::move( onComplete ) );
 }
 
 const std::vector< vk::CommandBuffer > &CommandList::getBuffers( )
@@ -411,7 +483,8 @@ CommandList::~CommandList( )
 
 void CommandList::freeBuffers( )
 {
-    executor->context->logicalDevice.freeCommandBuffers( executor->commandPool,
-                                                         buffers.size( ),
-                                                         buffers.data( ) );
+    FUNCTION_BREAK( submitted )
+
+    executor->releaseBuffers( buffers );
+    buffers.clear( );
 }
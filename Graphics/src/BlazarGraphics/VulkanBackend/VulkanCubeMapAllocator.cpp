@@ -56,6 +56,7 @@ void VulkanCubeMapAllocator::load( const CubeMapLoadArguments &arguments, Vulkan
     imageCreateInfo.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
     imageCreateInfo.sharingMode = vk::SharingMode::eExclusive;
     imageCreateInfo.samples = vk::SampleCountFlagBits::e1;
+    VulkanUtilities::shareAcrossQueues( context, imageCreateInfo );
     imageCreateInfo.flags = vk::ImageCreateFlagBits::eCubeCompatible;
 
     vma::AllocationCreateInfo allocationCreateInfo { };
@@ -124,10 +125,10 @@ void VulkanCubeMapAllocator::load( const CubeMapLoadArguments &arguments, Vulkan
         toShaderOptimal.image = target->image;
         toShaderOptimal.oldLayout = vk::ImageLayout::eTransferDstOptimal;
         toShaderOptimal.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-        toShaderOptimal.sourceAccess = { };
-        toShaderOptimal.destinationAccess = vk::AccessFlagBits::eTransferWrite;
-        toShaderOptimal.sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
-        toShaderOptimal.destinationStage = vk::PipelineStageFlagBits::eTransfer;
+        toShaderOptimal.sourceAccess = vk::AccessFlagBits::eTransferWrite;
+        toShaderOptimal.destinationAccess = vk::AccessFlagBits::eShaderRead;
+        toShaderOptimal.sourceStage = vk::PipelineStageFlagBits::eTransfer;
+        toShaderOptimal.destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
 
         commandExecutor->startCommandExecution( )
                 ->generateBuffers( vk::CommandBufferUsageFlagBits::eOneTimeSubmit, 1 )
@@ -135,9 +136,10 @@ void VulkanCubeMapAllocator::load( const CubeMapLoadArguments &arguments, Vulkan
                 ->pipelineBarrier( toTransferOptimal )
                 ->copyBufferToImage( copyBufferToImageArgs )
                 ->pipelineBarrier( toShaderOptimal )
-                ->execute( );
-
-        context->vma.destroyBuffer( stagingBuffer.first, stagingBuffer.second );
+                ->execute( [ context, stagingBuffer ]( )
+                           {
+                               context->vma.destroyBuffer( stagingBuffer.first, stagingBuffer.second );
+                           } );
         arrayLayer++;
     }
 }
@@ -17,7 +17,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <BlazarGraphics/VulkanBackend/VulkanDevice.h>
+#ifdef RUNTIME_SHADER_COMPILATION
 #include <BlazarGraphics/VulkanBackend/SpirvHelper.h>
+#endif
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
@@ -120,7 +122,9 @@ void VulkanDevice::createDevice( RenderWindow *window )
     initDebugMessages( debugUtilsCreateInfo );
 
     createSurface( );
+#ifdef RUNTIME_SHADER_COMPILATION
     SpirvHelper::init( );
+#endif
 }
 
 void VulkanDevice::initSupportedExtensions( )
@@ -226,6 +230,8 @@ void VulkanDevice::createDeviceInfo( const vk::PhysicalDevice &physicalDevice, D
     deviceInfo.name = std::string( deviceProperties.deviceName.data( ) );
     deviceInfo.properties.isDedicated = true; // todo
     deviceInfo.capabilities.dedicatedTransferQueue = true; // todo
+    deviceInfo.capabilities.bindlessTextures = supportsBindlessTextures( physicalDevice );
+    deviceInfo.capabilities.asyncCompute = supportsAsyncCompute( physicalDevice );
 }
 
 void VulkanDevice::selectDevice( const vk::PhysicalDevice &device )
@@ -238,6 +244,23 @@ void VulkanDevice::selectDevice( const vk::PhysicalDevice &device )
     createImageFormat( );
     createRenderSurface( );
 
+    if ( supportsBindlessTextures( device ) )
+    {
+        bindlessTextureTable = std::make_unique< BindlessTextureTable >( context.get( ) );
+        context->bindlessTextures = bindlessTextureTable.get( );
+    }
+
+    graphicsTimeline = std::make_unique< QueueTimeline >( context.get( ), QueueType::Graphics, supportsTimelineSemaphores( device ) );
+    context->graphicsTimeline = graphicsTimeline.get( );
+
+    // Cross queue dependencies are expressed as waits on timeline values
+    if ( supportsAsyncCompute( device ) )
+    {
+        computeTimeline = std::make_unique< QueueTimeline >( context.get( ), QueueType::Compute, true );
+        context->computeTimeline = computeTimeline.get( );
+        context->crossQueueFamilyIndices = { context->queueFamilies[ QueueType::Graphics ].index, context->queueFamilies[ QueueType::Compute ].index };
+    }
+
     vk::CommandPoolCreateInfo graphicsCommandPoolCreateInfo { };
     graphicsCommandPoolCreateInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
     graphicsCommandPoolCreateInfo.queueFamilyIndex = context->queueFamilies[ QueueType::Graphics ].index;
@@ -249,6 +272,15 @@ void VulkanDevice::selectDevice( const vk::PhysicalDevice &device )
     context->graphicsQueueCommandPool = context->logicalDevice.createCommandPool( graphicsCommandPoolCreateInfo );
     context->transferQueueCommandPool = context->logicalDevice.createCommandPool( transferCommandPoolCreateInfo );
 
+    vk::CommandPoolCreateInfo computeCommandPoolCreateInfo { };
+    computeCommandPoolCreateInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+    computeCommandPoolCreateInfo.queueFamilyIndex = context->queueFamilies[ QueueType::Compute ].index;
+
+    context->computeQueueCommandPool = context->logicalDevice.createCommandPool( computeCommandPoolCreateInfo );
+
+    pipelineCache = std::make_unique< PipelineCache >( context.get( ), PIPELINE_CACHE_PATH );
+    context->pipelineCache = pipelineCache.get( );
+
     pipelineProvider = std::make_unique< VulkanPipelineProvider >( context.get( ) );
     renderPassProvider = std::make_unique< VulkanRenderPassProvider >( context.get( ) );
     resourceProvider = std::make_unique< VulkanResourceProvider >( context.get( ) );
@@ -268,6 +300,12 @@ void VulkanDevice::setupQueueFamilies( )
     {
         bool hasGraphics = ( property.queueFlags & vk::QueueFlagBits::eGraphics ) == vk::QueueFlagBits::eGraphics;
         bool hasTransfer = ( property.queueFlags & vk::QueueFlagBits::eTransfer ) == vk::QueueFlagBits::eTransfer;
+        bool hasCompute = ( property.queueFlags & vk::QueueFlagBits::eCompute ) == vk::QueueFlagBits::eCompute;
+
+        if ( hasCompute && !hasGraphics && !exists( QueueType::Compute ) )
+        { // Only a family without graphics support runs compute work alongside the graphics queue
+            context->queueFamilies[ QueueType::Compute ] = QueueFamily { index, VkQueueFlags(property.queueFlags) };
+        }
 
         if ( hasGraphics && !exists( QueueType::Graphics ) )
         {
@@ -292,6 +330,11 @@ void VulkanDevice::setupQueueFamilies( )
     {
         context->queueFamilies[ QueueType::Transfer ] = context->queueFamilies[ QueueType::Graphics ];
     }
+
+    if ( !exists( QueueType::Compute ) )
+    {
+        context->queueFamilies[ QueueType::Compute ] = context->queueFamilies[ QueueType::Graphics ];
+    }
 }
 
 void VulkanDevice::createLogicalDevice( )
@@ -305,6 +348,37 @@ void VulkanDevice::createLogicalDevice( )
     features.sampleRateShading = true;
     features.tessellationShader = true;
 
+    std::vector< const char * > extensions = REQUIRED_EXTENSIONS;
+
+    vk::PhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures { };
+    const bool enableBindlessTextures = supportsBindlessTextures( context->physicalDevice );
+
+    if ( enableBindlessTextures )
+    {
+        extensions.push_back( VK_KHR_MAINTENANCE3_EXTENSION_NAME );
+        extensions.push_back( VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME );
+
+        descriptorIndexingFeatures.runtimeDescriptorArray = true;
+        descriptorIndexingFeatures.descriptorBindingPartiallyBound = true;
+        descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = true;
+        descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = true;
+    }
+
+    vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures { };
+    const bool enableTimelineSemaphores = supportsTimelineSemaphores( context->physicalDevice );
+
+    if ( enableTimelineSemaphores )
+    {
+        extensions.push_back( VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME );
+
+        timelineSemaphoreFeatures.timelineSemaphore = true;
+        timelineSemaphoreFeatures.pNext = enableBindlessTextures ? &descriptorIndexingFeatures : nullptr;
+    }
+
+    // Instanced draws find their range of the instance pool through gl_BaseInstance
+    vk::PhysicalDeviceShaderDrawParametersFeatures drawParametersFeatures { };
+    drawParametersFeatures.shaderDrawParameters = true;
+
 #ifdef DEBUG
     std::vector< const char * > layers;
     initSupportedLayers( layers );
@@ -319,17 +393,29 @@ void VulkanDevice::createLogicalDevice( )
 #elif
             0, { },
 #endif
-            static_cast<uint32_t>(REQUIRED_EXTENSIONS.size( )),
-            REQUIRED_EXTENSIONS.data( ),
+            static_cast<uint32_t>(extensions.size( )),
+            extensions.data( ),
             &features
     };
 
+    if ( enableTimelineSemaphores )
+    {
+        drawParametersFeatures.pNext = &timelineSemaphoreFeatures;
+    }
+    else
+    {
+        drawParametersFeatures.pNext = enableBindlessTextures ? &descriptorIndexingFeatures : nullptr;
+    }
+
+    createInfo.pNext = &drawParametersFeatures;
+
     context->logicalDevice = context->physicalDevice.createDevice( createInfo );
     VULKAN_HPP_DEFAULT_DISPATCHER.init( context->logicalDevice );
 
     context->queues[ QueueType::Graphics ] = vk::Queue { };
     context->queues[ QueueType::Presentation ] = vk::Queue { };
     context->queues[ QueueType::Transfer ] = vk::Queue { };
+    context->queues[ QueueType::Compute ] = vk::Queue { };
 
     context->logicalDevice.getQueue( context->queueFamilies[ QueueType::Graphics ].index, 0,
                                      &context->queues[ QueueType::Graphics ] );
@@ -339,6 +425,69 @@ void VulkanDevice::createLogicalDevice( )
 
     context->logicalDevice.getQueue( context->queueFamilies[ QueueType::Transfer ].index, 0,
                                      &context->queues[ QueueType::Transfer ] );
+
+    context->logicalDevice.getQueue( context->queueFamilies[ QueueType::Compute ].index, 0,
+                                     &context->queues[ QueueType::Compute ] );
+}
+
+bool VulkanDevice::supportsBindlessTextures( const vk::PhysicalDevice &physicalDevice )
+{
+    bool hasExtension = false;
+
+    for ( const auto &extension: physicalDevice.enumerateDeviceExtensionProperties( nullptr ) )
+    {
+        hasExtension |= std::string( extension.extensionName.data( ) ) == VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+    }
+
+    if ( !hasExtension )
+    {
+        return false;
+    }
+
+    auto features = physicalDevice.getFeatures2< vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorIndexingFeaturesEXT >( );
+    auto properties = physicalDevice.getProperties2< vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingPropertiesEXT >( );
+
+    const auto &indexingFeatures = features.get< vk::PhysicalDeviceDescriptorIndexingFeaturesEXT >( );
+    const auto &indexingProperties = properties.get< vk::PhysicalDeviceDescriptorIndexingPropertiesEXT >( );
+    const auto &limits = properties.get< vk::PhysicalDeviceProperties2 >( ).properties.limits;
+
+    // Texture indices are pushed after the 128 bytes of per object matrices the vertex stages use
+    return indexingFeatures.runtimeDescriptorArray &&
+           indexingFeatures.descriptorBindingPartiallyBound &&
+           indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+           indexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+           indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages >= BINDLESS_TEXTURE_CAPACITY &&
+           limits.maxPushConstantsSize > 128;
+}
+
+bool VulkanDevice::supportsTimelineSemaphores( const vk::PhysicalDevice &physicalDevice )
+{
+    bool hasExtension = false;
+
+    for ( const auto &extension: physicalDevice.enumerateDeviceExtensionProperties( nullptr ) )
+    {
+        hasExtension |= std::string( extension.extensionName.data( ) ) == VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME;
+    }
+
+    if ( !hasExtension )
+    {
+        return false;
+    }
+
+    auto features = physicalDevice.getFeatures2< vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR >( );
+    return features.get< vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR >( ).timelineSemaphore;
+}
+
+bool VulkanDevice::supportsAsyncCompute( const vk::PhysicalDevice &physicalDevice )
+{
+    bool hasComputeOnlyFamily = false;
+
+    for ( const vk::QueueFamilyProperties &property: physicalDevice.getQueueFamilyProperties( ) )
+    {
+        hasComputeOnlyFamily |= ( property.queueFlags & vk::QueueFlagBits::eCompute ) && !( property.queueFlags & vk::QueueFlagBits::eGraphics );
+    }
+
+    return hasComputeOnlyFamily && supportsTimelineSemaphores( physicalDevice );
 }
 
 void VulkanDevice::initializeVMA( )
@@ -434,6 +583,21 @@ VulkanDevice::~VulkanDevice( )
     pipelineProvider.reset( );
     renderPassProvider.reset( );
 
+    // Saved once every pipeline of the run was compiled into it
+    pipelineCache.reset( );
+    context->pipelineCache = nullptr;
+
+    // Runs the remaining retirements, these may still release memory through vma
+    computeTimeline.reset( );
+    context->computeTimeline = nullptr;
+    context->crossQueueFamilyIndices.clear( );
+    graphicsTimeline.reset( );
+    context->graphicsTimeline = nullptr;
+
+    // Destroyed after the timelines, they may still return slots to it
+    bindlessTextureTable.reset( );
+    context->bindlessTextures = nullptr;
+
     renderSurface.reset( );
 
     destroyDebugUtils( );
@@ -446,7 +610,9 @@ VulkanDevice::~VulkanDevice( )
     context->logicalDevice.destroy( );
     context->instance.destroy( );
 
+#ifdef RUNTIME_SHADER_COMPILATION
     SpirvHelper::destroy( );
+#endif
 }
 
 void VulkanDevice::destroyDebugUtils( ) const
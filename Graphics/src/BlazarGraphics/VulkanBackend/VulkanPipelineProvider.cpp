@@ -17,18 +17,123 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <BlazarCore/Utilities.h>
+#include <BlazarCore/TaskPool.h>
 #include <BlazarGraphics/VulkanBackend/VulkanPipelineProvider.h>
-#include <BlazarGraphics/VulkanBackend/SpirvHelper.h>
+#include <BlazarGraphics/VulkanBackend/PipelineCache.h>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
 IPipeline *VulkanPipelineProvider::createPipeline( const PipelineRequest &request )
 {
-    ASSERT_M( request.parentPass != nullptr, "You must provide a parent render pass" );
+    return createPipelines( { request } )[ 0 ];
+}
+
+std::vector< IPipeline * > VulkanPipelineProvider::createPipelines( const std::vector< PipelineRequest > &requests )
+{
+    for ( const PipelineRequest &request: requests )
+    {
+        ASSERT_M( request.parentPass != nullptr, "You must provide a parent render pass" );
+    }
+
+    // Compiling and reflecting the shaders of a request only goes through the SPIR-V cache, requests are handled on any thread
+    std::vector< std::vector< GLSLShaderInfo > > shaderInfos( requests.size( ) );
+    std::vector< std::shared_ptr< GLSLShaderSet > > shaderSets( requests.size( ) );
+
+    Core::TaskPool::run( requests.size( ), [ & ]( const uint32_t &requestIdx )
+    {
+        shaderInfos[ requestIdx ] = loadShaders( requests[ requestIdx ] );
+        shaderSets[ requestIdx ] = std::make_shared< GLSLShaderSet >( shaderInfos[ requestIdx ] );
+    } );
+
+    std::vector< IPipeline * > result;
+    std::vector< std::unique_ptr< PipelineCreateInfos > > pendingCreateInfos;
+    std::vector< VulkanPipeline * > pendingInstances;
+    std::vector< std::pair< size_t, PipelineDescription > > pendingDescriptions; // Per pending instance
+    std::vector< std::pair< VulkanPipeline *, uint32_t > > pendingDuplicates; // Requests of the batch matching a pending one
+
+    for ( uint32_t requestIdx = 0; requestIdx < requests.size( ); ++requestIdx )
+    {
+        auto pipeline = std::make_unique< VulkanPipeline >( );
+        pipeline->context = context;
+
+        VulkanPipeline * instance = pipeline.get( );
+        instance->bindPoint = isComputeRequest( requests[ requestIdx ] ) ? BindPoint::Compute : BindPoint::Graphics;
+        result.push_back( instance );
+        pipelineInstances.push_back( std::move( pipeline ) );
+
+        // Every instance keeps its own descriptor state, the sets it allocates are compatible with the registered layout
+        // since both are made from the same shaders
+        instance->descriptorManager = std::make_shared< DescriptorManager >( context, shaderSets[ requestIdx ] );
 
-    auto pipeline = std::make_unique< VulkanPipeline >( );
-    pipeline->context = context;
+        PipelineDescription description = describePipeline( requests[ requestIdx ], shaderInfos[ requestIdx ] );
+        const size_t key = hashDescription( description );
 
+        if ( const RegisteredPipeline * registered = findRegisteredPipeline( key, description ); registered != nullptr )
+        {
+            instance->pipeline = registered->pipeline;
+            instance->layout = registered->layout;
+            continue;
+        }
+
+        auto pending = std::find_if( pendingDescriptions.begin( ), pendingDescriptions.end( ), [ & ]( const std::pair< size_t, PipelineDescription > &pendingDescription )
+        {
+            return pendingDescription.first == key && pendingDescription.second == description;
+        } );
+
+        if ( pending != pendingDescriptions.end( ) )
+        {
+            pendingDuplicates.emplace_back( instance, uint32_t( pending - pendingDescriptions.begin( ) ) );
+            continue;
+        }
+
+        // Create infos point into themselves, they are never moved once configured
+        auto &createInfo = pendingCreateInfos.emplace_back( std::make_unique< PipelineCreateInfos >( ) );
+        createInfo->request = requests[ requestIdx ];
+        createInfo->parentPass = std::dynamic_pointer_cast< VulkanRenderPass >( requests[ requestIdx ].parentPass );
+        createInfo->shaders = shaderInfos[ requestIdx ];
+        createInfo->shaderSet = shaderSets[ requestIdx ];
+
+        configurePipeline( *createInfo, instance );
+
+        pendingInstances.push_back( instance );
+        pendingDescriptions.emplace_back( key, std::move( description ) );
+    }
+
+    // Driver compilation is the expensive part, pipeline creation is thread safe with a shared pipeline cache
+    Core::TaskPool::run( pendingCreateInfos.size( ), [ & ]( const uint32_t &pendingIdx )
+    {
+        const PipelineCreateInfos &createInfo = *pendingCreateInfos[ pendingIdx ];
+        VulkanPipeline * instance = pendingInstances[ pendingIdx ];
+
+        if ( instance->bindPoint == BindPoint::Compute )
+        {
+            instance->pipeline = context->logicalDevice.createComputePipeline( context->pipelineCache->get( ), createInfo.computePipelineCreateInfo ).value;
+        }
+        else
+        {
+            instance->pipeline = context->logicalDevice.createGraphicsPipeline( context->pipelineCache->get( ), createInfo.pipelineCreateInfo ).value;
+        }
+    } );
+
+    for ( const auto &duplicate: pendingDuplicates )
+    {
+        duplicate.first->pipeline = pendingInstances[ duplicate.second ]->pipeline;
+        duplicate.first->layout = pendingInstances[ duplicate.second ]->layout;
+    }
+
+    for ( uint32_t pendingIdx = 0; pendingIdx < pendingInstances.size( ); ++pendingIdx )
+    {
+        auto &[ key, description ] = pendingDescriptions[ pendingIdx ];
+        pipelineRegistry.emplace( key, RegisteredPipeline { std::move( description ), pendingInstances[ pendingIdx ]->pipeline, pendingInstances[ pendingIdx ]->layout } );
+    }
+
+    return result;
+}
+
+std::vector< GLSLShaderInfo > VulkanPipelineProvider::loadShaders( const PipelineRequest &request )
+{
     std::vector< GLSLShaderInfo > glslShaders { };
 
     auto vertexShaderSearch = request.shaderPaths.find( ShaderType::Vertex );
@@ -36,6 +141,13 @@ IPipeline *VulkanPipelineProvider::createPipeline( const PipelineRequest &reques
     auto tessControlShaderSearch = request.shaderPaths.find( ShaderType::TessellationControl );
     auto tessEvalShaderSearch = request.shaderPaths.find( ShaderType::TessellationEval );
     auto geometryShaderSearch = request.shaderPaths.find( ShaderType::Geometry );
+    auto computeShaderSearch = request.shaderPaths.find( ShaderType::Compute );
+
+    if ( computeShaderSearch != request.shaderPaths.end( ) )
+    {
+        ASSERT_M( request.shaderPaths.size( ) == 1, "Compute pipelines cannot have other shader stages!" );
+        glslShaders.emplace_back( GLSLShaderInfo { vk::ShaderStageFlagBits::eCompute, computeShaderSearch->second } );
+    }
 
     if ( vertexShaderSearch != request.shaderPaths.end( ) )
     {
@@ -62,25 +174,21 @@ IPipeline *VulkanPipelineProvider::createPipeline( const PipelineRequest &reques
         glslShaders.emplace_back( GLSLShaderInfo { vk::ShaderStageFlagBits::eGeometry, geometryShaderSearch->second } );
     }
 
-    // TODO cache depending on the pipeline, or maybe cache somewhere else
-    createPipeline( request, pipeline.get( ), glslShaders );
-
-    pipelineInstances.push_back( std::move( pipeline ) );
-    return pipelineInstances[ pipelineInstances.size( ) - 1 ].get( );
+    return glslShaders;
 }
 
-void VulkanPipelineProvider::createPipeline( const PipelineRequest &request, VulkanPipeline *instance, const std::vector< GLSLShaderInfo > &shaderInfos )
+bool VulkanPipelineProvider::isComputeRequest( const PipelineRequest &request )
 {
-    PipelineCreateInfos createInfo { };
-    createInfo.request = request;
-    createInfo.parentPass = std::dynamic_pointer_cast< VulkanRenderPass >( request.parentPass );
-
-    auto glslShaderSet = std::make_shared< GLSLShaderSet >( shaderInfos );
-
-    instance->descriptorManager = std::make_shared< DescriptorManager >( context, glslShaderSet );
+    return request.shaderPaths.find( ShaderType::Compute ) != request.shaderPaths.end( );
+}
 
-    createInfo.shaders = shaderInfos;
-    createInfo.shaderSet = glslShaderSet;
+void VulkanPipelineProvider::configurePipeline( PipelineCreateInfos &createInfo, VulkanPipeline *instance )
+{
+    if ( instance->bindPoint == BindPoint::Compute )
+    {
+        configureComputePipeline( createInfo, instance );
+        return;
+    }
 
     createInfo.pipelineCreateInfo.pDepthStencilState = nullptr;
 
@@ -101,8 +209,100 @@ void VulkanPipelineProvider::createPipeline( const PipelineRequest &request, Vul
     createDepthAttachmentImages( createInfo );
 
     createRenderPass( createInfo );
+}
+
+void VulkanPipelineProvider::configureComputePipeline( PipelineCreateInfos &createInfo, VulkanPipeline *instance )
+{
+    const GLSLShaderInfo &shader = createInfo.shaders[ 0 ];
+
+    createInfo.computePipelineCreateInfo.stage.stage = shader.type;
+    createInfo.computePipelineCreateInfo.stage.module = getShaderModule( shader.data );
+    createInfo.computePipelineCreateInfo.stage.pName = "main";
+
+    createPipelineLayout( createInfo, instance );
+    createInfo.computePipelineCreateInfo.layout = instance->layout;
+}
+
+PipelineDescription VulkanPipelineProvider::describePipeline( const PipelineRequest &request, const std::vector< GLSLShaderInfo > &shaderInfos )
+{
+    PipelineDescription description { };
+
+    for ( const GLSLShaderInfo &shader: shaderInfos )
+    {
+        description.stages.push_back( shader.type );
+        description.spirv.push_back( shader.data );
+    }
+
+    // Compute pipelines have no fixed function state and can be used with any pass
+    if ( isComputeRequest( request ) )
+    {
+        return description;
+    }
+
+    std::vector< uint32_t > &state = description.fixedFunctionState;
+
+    state.push_back( static_cast< uint32_t >( request.cullMode ) );
+    state.push_back( request.enableDepthTest );
+    state.push_back( static_cast< uint32_t >( request.depthCompareOp ) );
+    state.push_back( static_cast< uint32_t >( request.blendMode ) );
+    state.push_back( request.subpass );
+
+    // Members of disabled stencil states are left uninitialized and unused
+    auto appendStencilState = [ & ]( const StencilTestState &stencilState )
+    {
+        state.push_back( stencilState.enabled );
+        FUNCTION_BREAK( !stencilState.enabled )
+
+        state.push_back( static_cast< uint32_t >( stencilState.compareOp ) );
+        state.push_back( stencilState.compareMask );
+        state.push_back( stencilState.writeMask );
+        state.push_back( stencilState.ref );
+        state.push_back( static_cast< uint32_t >( stencilState.failOp ) );
+        state.push_back( static_cast< uint32_t >( stencilState.passOp ) );
+        state.push_back( static_cast< uint32_t >( stencilState.depthFailOp ) );
+    };
 
-    instance->pipeline = context->logicalDevice.createGraphicsPipeline( nullptr, createInfo.pipelineCreateInfo ).value;
+    appendStencilState( request.stencilTestStateFront );
+    appendStencilState( request.stencilTestStateBack );
+
+    // Viewport and scissor are dynamic, the render area of the pass does not matter
+    state.push_back( request.parentPass->getProperty( "UseMSAA" ) == "true" );
+    state.push_back( request.parentPass->getProperty( "DepthBiasEnabled" ) == "true" );
+
+    description.passCompatibility = std::dynamic_pointer_cast< VulkanRenderPass >( request.parentPass )->getCompatibilityKey( );
+
+    return description;
+}
+
+size_t VulkanPipelineProvider::hashDescription( const PipelineDescription &description )
+{
+    size_t key = 0;
+
+    for ( uint32_t i = 0; i < description.stages.size( ); ++i )
+    {
+        boost::hash_combine( key, static_cast< uint32_t >( description.stages[ i ] ) );
+        boost::hash_range( key, description.spirv[ i ].begin( ), description.spirv[ i ].end( ) );
+    }
+
+    boost::hash_range( key, description.fixedFunctionState.begin( ), description.fixedFunctionState.end( ) );
+    boost::hash_range( key, description.passCompatibility.begin( ), description.passCompatibility.end( ) );
+
+    return key;
+}
+
+const VulkanPipelineProvider::RegisteredPipeline *VulkanPipelineProvider::findRegisteredPipeline( const size_t &key, const PipelineDescription &description ) const
+{
+    auto [ begin, end ] = pipelineRegistry.equal_range( key );
+
+    for ( auto it = begin; it != end; ++it )
+    {
+        if ( it->second.description == description )
+        {
+            return &it->second;
+        }
+    }
+
+    return nullptr;
 }
 
 void VulkanPipelineProvider::configureVertexInput( PipelineCreateInfos &createInfo )
@@ -113,14 +313,13 @@ void VulkanPipelineProvider::configureVertexInput( PipelineCreateInfos &createIn
     {
         vk::PipelineShaderStageCreateInfo shaderStageCreateInfo { };
 
-        vk::ShaderModule shaderModule = this->createShaderModule( shader.data );
+        vk::ShaderModule shaderModule = this->getShaderModule( shader.data );
         shaderStageCreateInfo.stage = shader.type;
         shaderStageCreateInfo.module = shaderModule;
         shaderStageCreateInfo.pName = "main";
         shaderStageCreateInfo.pNext = nullptr;
 
         createInfo.pipelineStageCreateInfos.emplace_back( shaderStageCreateInfo );
-        shaderModules.emplace_back( shaderModule );
 
         hasTessellationShaders = hasTessellationShaders || shader.type == vk::ShaderStageFlagBits::eTessellationEvaluation;
         hasTessellationShaders = hasTessellationShaders || shader.type == vk::ShaderStageFlagBits::eTessellationControl;
@@ -233,11 +432,11 @@ void VulkanPipelineProvider::configureRasterization( PipelineCreateInfos &create
 
 void VulkanPipelineProvider::configureColorBlend( PipelineCreateInfos &createInfo )
 {
-    int attachmentCount = std::stoi( createInfo.request.parentPass->getProperty( "AttachmentCount" ) );
+    const uint32_t attachmentCount = createInfo.parentPass->getColorAttachmentCount( createInfo.request.subpass );
 
     createInfo.colorBlendAttachments.resize( attachmentCount );
 
-    for ( int i = 0; i < attachmentCount; ++i )
+    for ( uint32_t i = 0; i < attachmentCount; ++i )
     {
         createInfo.colorBlendAttachments[ i ].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
                                                                vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
@@ -297,7 +496,7 @@ void VulkanPipelineProvider::createPipelineLayout( PipelineCreateInfos &createIn
 void VulkanPipelineProvider::createRenderPass( PipelineCreateInfos &createInfo )
 {
     createInfo.pipelineCreateInfo.renderPass = std::dynamic_pointer_cast< VulkanRenderPass >( createInfo.request.parentPass )->getPassInstance( );
-    createInfo.pipelineCreateInfo.subpass = 0;
+    createInfo.pipelineCreateInfo.subpass = createInfo.request.subpass;
     createInfo.pipelineCreateInfo.basePipelineHandle = nullptr;
     createInfo.pipelineCreateInfo.basePipelineIndex = -1;
 }
@@ -398,25 +597,46 @@ void VulkanPipelineProvider::createDepthAttachmentImages( PipelineCreateInfos &c
     createInfo.pipelineCreateInfo.pDepthStencilState = &createInfo.depthStencilStateCreateInfo;
 }
 
-vk::ShaderModule VulkanPipelineProvider::createShaderModule( std::vector< uint32_t > data )
+vk::ShaderModule VulkanPipelineProvider::getShaderModule( const std::vector< uint32_t > &data )
 {
+    const size_t key = boost::hash_range( data.begin( ), data.end( ) );
+
+    auto [ begin, end ] = shaderModules.equal_range( key );
+
+    for ( auto it = begin; it != end; ++it )
+    {
+        if ( it->second.spirv == data )
+        {
+            return it->second.module;
+        }
+    }
+
     vk::ShaderModuleCreateInfo shaderModuleCreateInfo { };
     shaderModuleCreateInfo.codeSize = data.size( ) * sizeof( uint32_t );
     shaderModuleCreateInfo.pCode = data.data( );
 
-    return context->logicalDevice.createShaderModule( shaderModuleCreateInfo );
+    vk::ShaderModule shaderModule = context->logicalDevice.createShaderModule( shaderModuleCreateInfo );
+    shaderModules.emplace( key, RegisteredShaderModule { data, shaderModule } );
+
+    return shaderModule;
 }
 
 VulkanPipelineProvider::~VulkanPipelineProvider( )
 {
     for ( auto &module: shaderModules )
     {
-        context->logicalDevice.destroyShaderModule( module );
+        context->logicalDevice.destroyShaderModule( module.second.module );
     }
 
     for ( auto &instance: pipelineInstances )
     {
         instance.reset( );
     }
+
+    for ( auto &registered: pipelineRegistry )
+    {
+        context->logicalDevice.destroyPipeline( registered.second.pipeline );
+        context->logicalDevice.destroyPipelineLayout( registered.second.layout );
+    }
 }
 END_NAMESPACES
\ No newline at end of file
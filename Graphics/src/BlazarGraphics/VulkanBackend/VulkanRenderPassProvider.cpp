@@ -27,35 +27,57 @@ std::shared_ptr< IRenderPass > VulkanRenderPassProvider::createRenderPass( const
 
 std::shared_ptr< IRenderTarget > VulkanRenderPassProvider::createRenderTarget( const RenderTargetRequest &request )
 {
-    auto renderTarget = std::make_shared< VulkanRenderTarget >( context );
+    auto renderTarget = std::make_shared< VulkanRenderTarget >( context, transientMemory.get( ) );
 
     renderTarget->recreateBuffer = [ = ]( )
     {
         std::vector< vk::ImageView > attachments { };
 
-        for ( const auto &outputImage: request.outputImages )
+        for ( uint32_t outputIndex = 0; outputIndex < request.outputImages.size( ); ++outputIndex )
         {
+            const OutputImage &outputImage = request.outputImages[ outputIndex ];
+
             if ( outputImage.flags.presentedImage )
             {
                 attachments.push_back( context->swapChainImageViews[ request.frameIndex ] );
                 continue;
             }
 
+            if ( outputImage.flags.continuesOutput )
+            { // Owned by the render target of an earlier pass, which subscribed first and is recreated before this one
+                auto owner = request.continuedOutputs.find( outputImage.outputResourceName );
+                ASSERT_M( owner != request.continuedOutputs.end( ), "Continued outputs require the render target owning them!" );
+
+                auto ownerTarget = std::dynamic_pointer_cast< VulkanRenderTarget >( owner->second );
+                attachments.push_back( ownerTarget->attachmentViews[ outputImage.outputResourceName ] );
+
+                auto ownerImage = ownerTarget->outputImageMap.find( outputImage.outputResourceName );
+
+                if ( ownerImage != ownerTarget->outputImageMap.end( ) )
+                {
+                    renderTarget->outputImageMap[ outputImage.outputResourceName ] = ownerImage->second;
+                }
+
+                continue;
+            }
+
             auto msaaSampleCount = getOutputImageSamples( context, outputImage, true );
             auto vkFormat = getOutputImageVkFormat( context, outputImage );
             auto usageFlags = getOutputImageVkUsage( context, outputImage );
             auto aspectFlags = getOutputImageVkAspect( context, outputImage );
 
-            auto attachment = createAttachment( vkFormat, usageFlags, aspectFlags, msaaSampleCount, request );
+            auto attachment = createAttachment( vkFormat, usageFlags, aspectFlags, msaaSampleCount, request, getAliasGroup( request, outputIndex ), outputImage.access.sharedAcrossQueues );
+            renderTarget->attachmentViews[ outputImage.outputResourceName ] = attachment.imageView;
 
-            if ( outputImage.attachmentType == ResourceAttachmentType::Color || outputImage.attachmentType == ResourceAttachmentType::Depth )
+            if ( outputImage.attachmentType == ResourceAttachmentType::Color || outputImage.attachmentType == ResourceAttachmentType::Depth ||
+                 outputImage.attachmentType == ResourceAttachmentType::DepthAndStencil )
             {
                 if ( outputImage.flags.msaaSampled && outputImage.attachmentType == ResourceAttachmentType::Color )
                 {
                     msaaSampleCount = VulkanUtilities::maxDeviceMSAASampleCount( context->physicalDevice );
                     usageFlags = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransientAttachment;
 
-                    auto msaaAttachment = createAttachment( vkFormat, usageFlags, aspectFlags, msaaSampleCount, request );
+                    auto msaaAttachment = createAttachment( vkFormat, usageFlags, aspectFlags, msaaSampleCount, request, -1 );
 
                     attachments.push_back( msaaAttachment.imageView );
                     renderTarget->buffers.push_back( msaaAttachment );
@@ -63,7 +85,7 @@ std::shared_ptr< IRenderTarget > VulkanRenderPassProvider::createRenderTarget( c
 
                 ResourceType type = ResourceType::Sampler2D;
 
-                if ( outputImage.attachmentType == ResourceAttachmentType::Depth )
+                if ( outputImage.attachmentType != ResourceAttachmentType::Color )
                 {
                     type = ResourceType::DepthImage;
                 }
@@ -80,6 +102,14 @@ std::shared_ptr< IRenderTarget > VulkanRenderPassProvider::createRenderTarget( c
                 auto *bufferRef = ( VulkanTextureWrapper * ) imageResource->apiSpecificBuffer;
                 bufferRef->mipLevels = attachment.mipLevels;
                 bufferRef->imageView = attachment.imageView;
+
+                // Descriptors can only view a single aspect, shaders read the depth of a depth and stencil attachment
+                if ( outputImage.attachmentType == ResourceAttachmentType::DepthAndStencil )
+                {
+                    VulkanUtilities::createImageView( context, bufferRef->imageView, attachment.image, vkFormat, vk::ImageAspectFlagBits::eDepth );
+                    renderTarget->shaderReadViews.push_back( bufferRef->imageView );
+                }
+
                 bufferRef->image = attachment.image;
                 bufferRef->sampler = attachment.sampler;
                 bufferRef->previousUsage = attachment.previousUsage;
@@ -118,6 +148,34 @@ std::shared_ptr< IRenderTarget > VulkanRenderPassProvider::createRenderTarget( c
     return renderTarget;
 }
 
+void VulkanRenderPassProvider::reserveTransientMemory( const RenderTargetRequest &request )
+{
+    for ( uint32_t outputIndex = 0; outputIndex < request.outputImages.size( ); ++outputIndex )
+    {
+        const OutputImage &outputImage = request.outputImages[ outputIndex ];
+        const int32_t aliasGroup = getAliasGroup( request, outputIndex );
+
+        const vk::ImageUsageFlags usage = getOutputImageVkUsage( context, outputImage );
+
+        SKIP_ITERATION_IF( aliasGroup < 0 || outputImage.flags.presentedImage || isLazilyAllocated( usage ) )
+
+        auto imageCreateInfo = getAttachmentImageInfo( getOutputImageVkFormat( context, outputImage ), usage, getOutputImageSamples( context, outputImage, true ), request );
+
+        transientMemory->reserve( request.frameIndex, aliasGroup, imageCreateInfo );
+    }
+}
+
+int32_t VulkanRenderPassProvider::getAliasGroup( const RenderTargetRequest &request, const uint32_t &outputIndex )
+{
+    return outputIndex < request.aliasGroups.size( ) ? request.aliasGroups[ outputIndex ] : -1;
+}
+
+bool VulkanRenderPassProvider::isLazilyAllocated( const vk::ImageUsageFlags &usage ) const
+{
+    // Without a lazily allocated memory type, transient attachments are backed like any other attachment
+    return lazilyAllocatedMemory && ( usage & vk::ImageUsageFlagBits::eTransientAttachment );
+}
+
 vk::ImageAspectFlags VulkanRenderPassProvider::getOutputImageVkAspect( VulkanContext *context, const OutputImage &outputImage )
 {
     vk::ImageAspectFlags aspectFlags = vk::ImageAspectFlagBits::eColor;
@@ -162,6 +220,12 @@ vk::ImageLayout VulkanRenderPassProvider::getOutputImageVkLayout( VulkanContext
 
 vk::ImageUsageFlags VulkanRenderPassProvider::getOutputImageVkUsage( VulkanContext *context, const OutputImage &outputImage )
 {
+    // Still part of the framebuffer of the compute pass, which is never begun
+    if ( outputImage.access.storageImage )
+    {
+        return vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled;
+    }
+
     vk::ImageUsageFlags usageFlags = vk::ImageUsageFlagBits::eColorAttachment;
 
     if ( outputImage.attachmentType == ResourceAttachmentType::Depth || outputImage.attachmentType == ResourceAttachmentType::DepthAndStencil )
@@ -169,11 +233,21 @@ vk::ImageUsageFlags VulkanRenderPassProvider::getOutputImageVkUsage( VulkanConte
         usageFlags = vk::ImageUsageFlagBits::eDepthStencilAttachment;
     }
 
-    if ( outputImage.attachmentType == ResourceAttachmentType::Color || outputImage.attachmentType == ResourceAttachmentType::Depth && !outputImage.flags.presentedImage )
+    if ( !outputImage.access.readAfterPass && !outputImage.flags.presentedImage )
+    { // Only lives within the pass, tile based GPUs can keep it in on chip memory
+        usageFlags |= vk::ImageUsageFlagBits::eTransientAttachment;
+    }
+    else if ( outputImage.attachmentType == ResourceAttachmentType::Color ||
+              ( outputImage.attachmentType == ResourceAttachmentType::Depth || outputImage.attachmentType == ResourceAttachmentType::DepthAndStencil ) && !outputImage.flags.presentedImage )
     {
         usageFlags |= vk::ImageUsageFlagBits::eSampled;
     }
 
+    if ( outputImage.access.inputAttachment )
+    {
+        usageFlags |= vk::ImageUsageFlagBits::eInputAttachment;
+    }
+
     return usageFlags;
 }
 
@@ -196,7 +270,7 @@ vk::SampleCountFlagBits VulkanRenderPassProvider::getOutputImageSamples( VulkanC
 
 vk::Format VulkanRenderPassProvider::getOutputImageVkFormat( VulkanContext *context, const OutputImage &outputImage )
 {
-    vk::Format vkFormat;
+    vk::Format vkFormat = vk::Format::eUndefined;
 
     if ( outputImage.imageFormat == ResourceImageFormat::R16G16B16A16Sfloat )
     {
@@ -206,10 +280,30 @@ vk::Format VulkanRenderPassProvider::getOutputImageVkFormat( VulkanContext *cont
     {
         vkFormat = vk::Format::eR32G32B32A32Sfloat;
     }
+    else if ( outputImage.imageFormat == ResourceImageFormat::R16G16Sfloat )
+    {
+        vkFormat = vk::Format::eR16G16Sfloat;
+    }
     else if ( outputImage.imageFormat == ResourceImageFormat::R8G8B8A8Unorm )
     {
         vkFormat = vk::Format::eR8G8B8A8Unorm;
     }
+    else if ( outputImage.imageFormat == ResourceImageFormat::R8G8B8Unorm )
+    {
+        vkFormat = vk::Format::eR8G8B8Unorm;
+    }
+    else if ( outputImage.imageFormat == ResourceImageFormat::R8G8Unorm )
+    {
+        vkFormat = vk::Format::eR8G8Unorm;
+    }
+    else if ( outputImage.imageFormat == ResourceImageFormat::R8Unorm )
+    {
+        vkFormat = vk::Format::eR8Unorm;
+    }
+    else if ( outputImage.imageFormat == ResourceImageFormat::R8G8B8A8Srgb )
+    {
+        vkFormat = vk::Format::eR8G8B8A8Srgb;
+    }
     else if ( outputImage.imageFormat == ResourceImageFormat::B8G8R8A8Srgb )
     {
         vkFormat = vk::Format::eB8G8R8A8Srgb;
@@ -227,14 +321,14 @@ vk::Format VulkanRenderPassProvider::getOutputImageVkFormat( VulkanContext *cont
         vkFormat = vk::Format::eD32Sfloat;
     }
 
+    ASSERT_M( vkFormat != vk::Format::eUndefined, "Output image " + outputImage.outputResourceName + " has a format without a Vulkan mapping!" );
+
     return vkFormat;
 }
 
-VulkanTextureWrapper VulkanRenderPassProvider::createAttachment( const vk::Format &format, const vk::ImageUsageFlags &usage, const vk::ImageAspectFlags &aspect,
-                                                                 const vk::SampleCountFlagBits &sampleCount, const RenderTargetRequest request )
+vk::ImageCreateInfo VulkanRenderPassProvider::getAttachmentImageInfo( const vk::Format &format, const vk::ImageUsageFlags &usage, const vk::SampleCountFlagBits &sampleCount,
+                                                                      const RenderTargetRequest &request ) const
 {
-    VulkanTextureWrapper textureWrapper { };
-
     vk::ImageCreateInfo imageCreateInfo { };
 
     imageCreateInfo.imageType = vk::ImageType::e2D;
@@ -250,12 +344,37 @@ VulkanTextureWrapper VulkanRenderPassProvider::createAttachment( const vk::Forma
     imageCreateInfo.arrayLayers = 1;
     imageCreateInfo.initialLayout = vk::ImageLayout::eUndefined;;
 
-    vma::AllocationCreateInfo allocationCreateInfo { };
-    allocationCreateInfo.usage = vma::MemoryUsage::eGpuOnly;
+    return imageCreateInfo;
+}
 
-    auto imageAllocationPair = context->vma.createImage( imageCreateInfo, allocationCreateInfo );
-    textureWrapper.image = imageAllocationPair.first;
-    textureWrapper.allocation = imageAllocationPair.second;
+VulkanTextureWrapper VulkanRenderPassProvider::createAttachment( const vk::Format &format, const vk::ImageUsageFlags &usage, const vk::ImageAspectFlags &aspect,
+                                                                 const vk::SampleCountFlagBits &sampleCount, const RenderTargetRequest request, const int32_t &aliasGroup,
+                                                                 const bool &sharedAcrossQueues )
+{
+    VulkanTextureWrapper textureWrapper { };
+
+    auto imageCreateInfo = getAttachmentImageInfo( format, usage, sampleCount, request );
+
+    // Outputs read on another queue are never aliased, the render graph keeps them alive for the whole frame
+    if ( sharedAcrossQueues )
+    {
+        VulkanUtilities::shareAcrossQueues( context, imageCreateInfo );
+    }
+
+    if ( aliasGroup >= 0 && !isLazilyAllocated( usage ) )
+    { // Aliased images have no allocation of their own, the render pass clears or overwrites their content
+        textureWrapper.image = transientMemory->createImage( request.frameIndex, aliasGroup, imageCreateInfo );
+        textureWrapper.allocation = nullptr;
+    }
+    else
+    {
+        vma::AllocationCreateInfo allocationCreateInfo { };
+        allocationCreateInfo.usage = isLazilyAllocated( usage ) ? vma::MemoryUsage::eGpuLazilyAllocated : vma::MemoryUsage::eGpuOnly;
+
+        auto imageAllocationPair = context->vma.createImage( imageCreateInfo, allocationCreateInfo );
+        textureWrapper.image = imageAllocationPair.first;
+        textureWrapper.allocation = imageAllocationPair.second;
+    }
 
     VulkanUtilities::createImageView( context, textureWrapper.imageView, textureWrapper.image, format, aspect );
 
@@ -288,9 +407,15 @@ void VulkanRenderPass::create( const RenderPassRequest &request )
     uint32_t attachmentIndex = 0;
 
     std::vector< vk::AttachmentDescription > attachments { };
-    std::vector< vk::AttachmentReference > colorAttachments;
-    std::vector< vk::AttachmentReference > resolveAttachments;
-    std::vector< vk::AttachmentReference > depthAttachments;
+
+    struct SubpassAttachments
+    {
+        std::vector< vk::AttachmentReference > colorAttachments;
+        std::vector< vk::AttachmentReference > resolveAttachments;
+        std::vector< vk::AttachmentReference > depthAttachments;
+        std::vector< vk::AttachmentReference > inputAttachments;
+        std::vector< uint32_t > preserveAttachments;
+    };
 
     auto initAttachmentDefaults = [ ]( vk::AttachmentDescription &attachmentDescription )
     {
@@ -301,9 +426,45 @@ void VulkanRenderPass::create( const RenderPassRequest &request )
         attachmentDescription.initialLayout = vk::ImageLayout::eUndefined;
     };
 
+    auto setAttachmentOps = [ ]( vk::AttachmentDescription &attachmentDescription, const OutputImage &outputImage )
+    {
+        // Depth is tested against, it always starts cleared
+        if ( outputImage.access.overwritten && outputImage.attachmentType == ResourceAttachmentType::Color )
+        {
+            attachmentDescription.loadOp = vk::AttachmentLoadOp::eDontCare;
+        }
+
+        if ( !outputImage.access.readAfterPass )
+        {
+            attachmentDescription.storeOp = vk::AttachmentStoreOp::eDontCare;
+        }
+
+        // Stencil is only kept for a later pass testing against it
+        if ( outputImage.access.attachedAfterPass )
+        {
+            attachmentDescription.stencilStoreOp = vk::AttachmentStoreOp::eStore;
+        }
+
+        if ( outputImage.flags.continuesOutput )
+        {
+            attachmentDescription.loadOp = vk::AttachmentLoadOp::eLoad;
+            attachmentDescription.stencilLoadOp = vk::AttachmentLoadOp::eLoad;
+            attachmentDescription.initialLayout = VulkanRenderPassProvider::getOutputImageVkLayout( nullptr, outputImage );
+        }
+    };
+
     auto setAttachmentFinalLayout = [ ]( vk::AttachmentDescription &attachmentDescription, const OutputImage &outputImage )
     {
-        if ( outputImage.attachmentType == ResourceAttachmentType::Depth )
+        if ( outputImage.access.attachedAfterPass )
+        { // The next pass continuing the output expects it in the attachment layout
+            attachmentDescription.finalLayout = VulkanRenderPassProvider::getOutputImageVkLayout( nullptr, outputImage );
+        }
+        else if ( !outputImage.access.readAfterPass && !outputImage.flags.presentedImage )
+        { // Not sampled, only an image read by a later subpass has a usage allowing a read only layout, where that subpass leaves it
+            attachmentDescription.finalLayout = outputImage.access.inputAttachment ? vk::ImageLayout::eShaderReadOnlyOptimal
+                                                                                    : VulkanRenderPassProvider::getOutputImageVkLayout( nullptr, outputImage );
+        }
+        else if ( outputImage.attachmentType == ResourceAttachmentType::Depth || outputImage.attachmentType == ResourceAttachmentType::DepthAndStencil )
         {
             if ( outputImage.flags.presentedImage )
             {
@@ -314,10 +475,6 @@ void VulkanRenderPass::create( const RenderPassRequest &request )
                 attachmentDescription.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
             }
         }
-        else if ( outputImage.attachmentType == ResourceAttachmentType::DepthAndStencil )
-        {
-            attachmentDescription.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
-        }
         else if ( outputImage.flags.presentedImage && !outputImage.flags.msaaSampled )
         {
             attachmentDescription.finalLayout = vk::ImageLayout::ePresentSrcKHR;
@@ -346,70 +503,169 @@ void VulkanRenderPass::create( const RenderPassRequest &request )
         }
     };
 
-    for ( auto &outputImage: request.outputImages )
+    // Outputs of every subpass get consecutive attachments, in the order the render target creates them
+    std::vector< const std::vector< OutputImage > * > subpassOutputs { &request.outputImages };
+
+    for ( const auto &subpassRequest: request.subpasses )
     {
-        auto &colorAttachmentDescription = attachments.emplace_back( vk::AttachmentDescription { } );
+        subpassOutputs.push_back( &subpassRequest.outputImages );
+    }
+
+    std::vector< SubpassAttachments > subpassAttachments( subpassOutputs.size( ) );
+    std::unordered_map< std::string, std::pair< uint32_t, uint32_t > > outputAttachments; // output name -> subpass, attachment
+    std::vector< uint32_t > depthAttachmentIndices;
 
-        colorAttachmentDescription.format = VulkanRenderPassProvider::getOutputImageVkFormat( context, outputImage );
-        colorAttachmentDescription.samples = VulkanRenderPassProvider::getOutputImageSamples( context, outputImage );
-        initAttachmentDefaults( colorAttachmentDescription );
+    for ( uint32_t subpass = 0; subpass < subpassOutputs.size( ); ++subpass )
+    {
+        SubpassAttachments &references = subpassAttachments[ subpass ];
 
-        if ( outputImage.flags.msaaSampled )
+        for ( auto &outputImage: *subpassOutputs[ subpass ] )
         {
-            propertyVal_useMsaa = "true";
+            auto &colorAttachmentDescription = attachments.emplace_back( vk::AttachmentDescription { } );
+
+            colorAttachmentDescription.format = VulkanRenderPassProvider::getOutputImageVkFormat( context, outputImage );
+            colorAttachmentDescription.samples = VulkanRenderPassProvider::getOutputImageSamples( context, outputImage );
+            initAttachmentDefaults( colorAttachmentDescription );
+            setAttachmentOps( colorAttachmentDescription, outputImage );
+
+            if ( outputImage.flags.msaaSampled )
+            {
+                propertyVal_useMsaa = "true";
+            }
+
+            setAttachmentFinalLayout( colorAttachmentDescription, outputImage );
+
+            vk::AttachmentReference attachmentReference { };
+
+            attachmentReference.attachment = attachmentIndex++;
+            attachmentReference.layout = VulkanRenderPassProvider::getOutputImageVkLayout( context, outputImage );
+
+            outputAttachments[ outputImage.outputResourceName ] = { subpass, attachmentReference.attachment };
+            attachClearColor( outputImage );
+
+            if ( outputImage.attachmentType == ResourceAttachmentType::Color )
+            {
+                references.colorAttachments.push_back( std::move( attachmentReference ) );
+
+                if ( outputImage.flags.msaaSampled )
+                {
+                    // Every sample is resolved into the resolve attachment, the multisampled content is not needed afterwards
+                    colorAttachmentDescription.storeOp = vk::AttachmentStoreOp::eDontCare;
+
+                    auto &colorAttachmentResolve = attachments.emplace_back( vk::AttachmentDescription { } );
+
+                    colorAttachmentResolve.format = VulkanRenderPassProvider::getOutputImageVkFormat( context, outputImage );
+                    colorAttachmentResolve.samples = vk::SampleCountFlagBits::e1;
+                    initAttachmentDefaults( colorAttachmentResolve );
+                    setAttachmentOps( colorAttachmentResolve, outputImage );
+                    colorAttachmentResolve.loadOp = vk::AttachmentLoadOp::eDontCare;
+
+                    if ( request.isFinalDrawPass )
+                    {
+                        colorAttachmentResolve.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+                    }
+                    else if ( !outputImage.access.readAfterPass )
+                    {
+                        colorAttachmentResolve.finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+                    }
+                    else
+                    {
+                        colorAttachmentResolve.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+                    }
+
+                    auto &colorAttachmentResolveReference = references.resolveAttachments.emplace_back( vk::AttachmentReference { } );
+
+                    colorAttachmentResolveReference.attachment = attachmentIndex++;
+                    colorAttachmentResolveReference.layout = vk::ImageLayout::eColorAttachmentOptimal;
+                    attachClearColor( outputImage );
+                }
+            }
+
+            else if ( outputImage.attachmentType == ResourceAttachmentType::Depth ||
+                      outputImage.attachmentType == ResourceAttachmentType::DepthAndStencil ||
+                      outputImage.attachmentType == ResourceAttachmentType::Stencil )
+            {
+                depthAttachmentIndices.push_back( attachmentReference.attachment );
+                references.depthAttachments.push_back( std::move( attachmentReference ) );
+            }
         }
 
-        setAttachmentFinalLayout( colorAttachmentDescription, outputImage );
+        colorAttachmentCounts.push_back( references.colorAttachments.size( ) );
+    }
 
-        vk::AttachmentReference attachmentReference { };
+    std::stringstream attCountBuilder;
+    attCountBuilder << colorAttachmentCounts[ 0 ];
+    propertyVal_attachmentCount = attCountBuilder.str( );
 
-        attachmentReference.attachment = attachmentIndex++;
-        attachmentReference.layout = VulkanRenderPassProvider::getOutputImageVkLayout( context, outputImage );
+    std::vector< vk::SubpassDependency > dependencies;
 
-        attachClearColor( outputImage );
+    std::vector< vk::InputAttachmentAspectReference > inputAspects;
 
-        if ( outputImage.attachmentType == ResourceAttachmentType::Color )
+    for ( uint32_t subpass = 1; subpass < subpassAttachments.size( ); ++subpass )
+    {
+        std::vector< bool > readsSubpass( subpass, false );
+
+        for ( const auto &inputName: request.subpasses[ subpass - 1 ].inputAttachments )
         {
-            colorAttachments.push_back( std::move( attachmentReference ) );
+            vk::AttachmentReference &inputReference = subpassAttachments[ subpass ].inputAttachments.emplace_back( );
+            inputReference.attachment = VK_ATTACHMENT_UNUSED;
+            inputReference.layout = vk::ImageLayout::eShaderReadOnlyOptimal;
 
-            if ( outputImage.flags.msaaSampled )
+            SKIP_ITERATION_IF( inputName.empty( ) ) // Gap in the input_attachment_index of the shader
+
+            auto find = outputAttachments.find( inputName );
+            ASSERT_M( find != outputAttachments.end( ) && find->second.first < subpass, "Input attachments must be outputs of an earlier subpass!" );
+
+            const auto &[ producerSubpass, attachment ] = find->second;
+            inputReference.attachment = attachment;
+            readsSubpass[ producerSubpass ] = true;
+
+            // Shaders read the depth of a depth and stencil attachment, matching the view bound to the descriptor
+            if ( std::find( depthAttachmentIndices.begin( ), depthAttachmentIndices.end( ), attachment ) != depthAttachmentIndices.end( ) )
+            {
+                const uint32_t inputIndex = subpassAttachments[ subpass ].inputAttachments.size( ) - 1;
+                inputAspects.emplace_back( subpass, inputIndex, vk::ImageAspectFlagBits::eDepth );
+            }
+
+            // Subpasses in between do not touch the attachment, its content has to survive them
+            for ( uint32_t between = producerSubpass + 1; between < subpass; ++between )
             {
-                auto &colorAttachmentResolve = attachments.emplace_back( vk::AttachmentDescription { } );
+                auto &preserved = subpassAttachments[ between ].preserveAttachments;
+                auto &read = subpassAttachments[ between ].inputAttachments;
 
-                colorAttachmentResolve.format = VulkanRenderPassProvider::getOutputImageVkFormat( context, outputImage );
-                colorAttachmentResolve.samples = vk::SampleCountFlagBits::e1;
-                initAttachmentDefaults( colorAttachmentResolve );
+                const bool readInBetween = std::any_of( read.begin( ), read.end( ), [ & ]( const vk::AttachmentReference &reference ) { return reference.attachment == attachment; } );
 
-                if ( request.isFinalDrawPass )
-                {
-                    colorAttachmentResolve.finalLayout = vk::ImageLayout::ePresentSrcKHR;
-                }
-                else
+                if ( !readInBetween && std::find( preserved.begin( ), preserved.end( ), attachment ) == preserved.end( ) )
                 {
-                    colorAttachmentResolve.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+                    preserved.push_back( attachment );
                 }
-
-                auto &colorAttachmentResolveReference = resolveAttachments.emplace_back( vk::AttachmentReference { } );
-
-                colorAttachmentResolveReference.attachment = attachmentIndex++;
-                colorAttachmentResolveReference.layout = vk::ImageLayout::eColorAttachmentOptimal;
-                attachClearColor( outputImage );
             }
         }
 
-        else if ( outputImage.attachmentType == ResourceAttachmentType::Depth ||
-                  outputImage.attachmentType == ResourceAttachmentType::DepthAndStencil ||
-                  outputImage.attachmentType == ResourceAttachmentType::Stencil )
+        // Reads happen at the same pixel, by region dependencies let tile based GPUs keep the attachments on chip
+        for ( uint32_t producerSubpass = 0; producerSubpass < subpass; ++producerSubpass )
         {
-            depthAttachments.push_back( std::move( attachmentReference ) );
+            SKIP_ITERATION_IF( !readsSubpass[ producerSubpass ] )
+
+            auto &dependency = dependencies.emplace_back( vk::SubpassDependency { } );
+            dependency.srcSubpass = producerSubpass;
+            dependency.dstSubpass = subpass;
+
+            dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests;
+            dependency.dstStageMask = vk::PipelineStageFlagBits::eFragmentShader;
+
+            dependency.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            dependency.dstAccessMask = vk::AccessFlagBits::eInputAttachmentRead;
+            dependency.dependencyFlags = vk::DependencyFlagBits::eByRegion;
         }
     }
 
-    std::stringstream attCountBuilder;
-    attCountBuilder << colorAttachments.size( );
-    propertyVal_attachmentCount = attCountBuilder.str( );
+    ASSERT_M( request.subpasses.empty( ) || ( request.dependencySet == DependencySet::DefaultColor && !request.isFinalDrawPass ), "Only DefaultColor passes can have more than one subpass!" );
 
-    std::vector< vk::SubpassDependency > dependencies;
+    const bool attachedAfterPass = std::any_of( subpassOutputs.begin( ), subpassOutputs.end( ), [ ]( const std::vector< OutputImage > *outputs )
+    {
+        return std::any_of( outputs->begin( ), outputs->end( ), [ ]( const OutputImage &outputImage ) { return outputImage.access.attachedAfterPass; } );
+    } );
 
     if ( request.isFinalDrawPass )
     {
@@ -425,25 +681,39 @@ void VulkanRenderPass::create( const RenderPassRequest &request )
     }
     else if ( request.dependencySet == DependencySet::DefaultColor )
     {
-        auto &dependency1 = dependencies.emplace_back( vk::SubpassDependency { } );
-        dependency1.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency1.dstSubpass = 0;
-
-        dependency1.srcStageMask = vk::PipelineStageFlagBits::eBottomOfPipe;
-        dependency1.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-
-        dependency1.srcAccessMask = vk::AccessFlagBits::eMemoryRead;
-        dependency1.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eColorAttachmentRead;
-        ////////////////////////////////////////////////////////////////////////////
-        auto &dependency2 = dependencies.emplace_back( vk::SubpassDependency { } );
-        dependency2.srcSubpass = 0;
-        dependency2.dstSubpass = VK_SUBPASS_EXTERNAL;
-
-        dependency2.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-        dependency2.dstStageMask = vk::PipelineStageFlagBits::eBottomOfPipe;
-
-        dependency2.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eColorAttachmentRead;
-        dependency2.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+        // Every subpass writes attachments of its own, each is ordered against the work before and after the render pass
+        for ( uint32_t subpass = 0; subpass < subpassAttachments.size( ); ++subpass )
+        {
+            auto &dependency1 = dependencies.emplace_back( vk::SubpassDependency { } );
+            dependency1.srcSubpass = VK_SUBPASS_EXTERNAL;
+            dependency1.dstSubpass = subpass;
+
+            dependency1.srcStageMask = vk::PipelineStageFlagBits::eBottomOfPipe;
+            dependency1.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
+
+            dependency1.srcAccessMask = vk::AccessFlagBits::eMemoryRead;
+            dependency1.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eColorAttachmentRead |
+                                        vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentRead;
+            ////////////////////////////////////////////////////////////////////////////
+            // Passes are no longer waited on by the CPU, the passes sampling the outputs are ordered by this dependency
+            auto &dependency2 = dependencies.emplace_back( vk::SubpassDependency { } );
+            dependency2.srcSubpass = subpass;
+            dependency2.dstSubpass = VK_SUBPASS_EXTERNAL;
+
+            // Compute passes without an async compute queue sample the outputs on the same queue
+            dependency2.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests;
+            dependency2.dstStageMask = vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+
+            dependency2.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            dependency2.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+            // Passes continuing an output load it as an attachment, the writes are made visible to their attachment reads
+            if ( attachedAfterPass )
+            {
+                dependency2.dstStageMask |= vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
+                dependency2.dstAccessMask |= vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentRead;
+            }
+        }
     }
     else if ( request.dependencySet == DependencySet::ShadowMap )
     {
@@ -463,37 +733,102 @@ void VulkanRenderPass::create( const RenderPassRequest &request )
         dependency2.dstSubpass = VK_SUBPASS_EXTERNAL;
 
         dependency2.srcStageMask = vk::PipelineStageFlagBits::eLateFragmentTests;
-        dependency2.dstStageMask = vk::PipelineStageFlagBits::eFragmentShader;
+        dependency2.dstStageMask = vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
 
         dependency2.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
         dependency2.dstAccessMask = vk::AccessFlagBits::eShaderRead;
         dependency2.dependencyFlags = vk::DependencyFlagBits::eByRegion;
     }
 
-    vk::SubpassDescription subPass { };
-    subPass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
-    subPass.colorAttachmentCount = colorAttachments.size( );
-    subPass.pColorAttachments = colorAttachments.data( );
-    subPass.pDepthStencilAttachment = depthAttachments.empty( ) ? nullptr : depthAttachments.data( );
-    subPass.pResolveAttachments = resolveAttachments.empty( ) ? nullptr : resolveAttachments.data( );
+    std::vector< vk::SubpassDescription > subPasses;
+
+    for ( const auto &references: subpassAttachments )
+    {
+        vk::SubpassDescription &subPass = subPasses.emplace_back( );
+        subPass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+        subPass.colorAttachmentCount = references.colorAttachments.size( );
+        subPass.pColorAttachments = references.colorAttachments.data( );
+        subPass.pDepthStencilAttachment = references.depthAttachments.empty( ) ? nullptr : references.depthAttachments.data( );
+        subPass.pResolveAttachments = references.resolveAttachments.empty( ) ? nullptr : references.resolveAttachments.data( );
+        subPass.inputAttachmentCount = references.inputAttachments.size( );
+        subPass.pInputAttachments = references.inputAttachments.data( );
+        subPass.preserveAttachmentCount = references.preserveAttachments.size( );
+        subPass.pPreserveAttachments = references.preserveAttachments.data( );
+    }
 
     vk::RenderPassCreateInfo renderPassCreateInfo { };
     renderPassCreateInfo.attachmentCount = attachments.size( );
     renderPassCreateInfo.pAttachments = attachments.data( );
-    renderPassCreateInfo.subpassCount = 1;
-    renderPassCreateInfo.pSubpasses = &subPass;
+    renderPassCreateInfo.subpassCount = subPasses.size( );
+    renderPassCreateInfo.pSubpasses = subPasses.data( );
     renderPassCreateInfo.dependencyCount = dependencies.size( );
     renderPassCreateInfo.pDependencies = dependencies.data( );
 
+    vk::RenderPassInputAttachmentAspectCreateInfo inputAspectCreateInfo { };
+    inputAspectCreateInfo.aspectReferenceCount = inputAspects.size( );
+    inputAspectCreateInfo.pAspectReferences = inputAspects.data( );
+
+    if ( !inputAspects.empty( ) )
+    {
+        renderPassCreateInfo.pNext = &inputAspectCreateInfo;
+    }
+
     renderPass = context->logicalDevice.createRenderPass( renderPassCreateInfo );
 
+    // Load/store ops and layouts do not affect compatibility, pipelines outlive the render passes they are created with
+    compatibilityKey.clear( );
+    compatibilityKey.push_back( attachments.size( ) );
+
+    for ( const auto &attachment: attachments )
+    {
+        compatibilityKey.push_back( static_cast< uint32_t >( attachment.format ) );
+        compatibilityKey.push_back( static_cast< uint32_t >( attachment.samples ) );
+    }
+
+    auto appendReferences = [ & ]( const std::vector< vk::AttachmentReference > &references )
+    {
+        compatibilityKey.push_back( references.size( ) );
+
+        for ( const auto &reference: references )
+        {
+            compatibilityKey.push_back( reference.attachment );
+        }
+    };
+
+    for ( const auto &references: subpassAttachments )
+    {
+        appendReferences( references.colorAttachments );
+        appendReferences( references.resolveAttachments );
+        appendReferences( references.depthAttachments );
+        appendReferences( references.inputAttachments );
+    }
+
+    computePass = request.queue == PassQueue::AsyncCompute;
+
+    if ( computePass && context->computeTimeline != nullptr )
+    {
+        queueType = QueueType::Compute;
+        timeline = context->computeTimeline;
+    }
+    else
+    {
+        queueType = QueueType::Graphics;
+        timeline = context->graphicsTimeline;
+    }
+
     vk::CommandBufferAllocateInfo bufferAllocateInfo { };
     bufferAllocateInfo.level = vk::CommandBufferLevel::ePrimary;
-    bufferAllocateInfo.commandPool = context->graphicsQueueCommandPool;
+    bufferAllocateInfo.commandPool = queueType == QueueType::Compute ? context->computeQueueCommandPool : context->graphicsQueueCommandPool;
     bufferAllocateInfo.commandBufferCount = context->swapChainImages.size( );
 
     buffers = context->logicalDevice.allocateCommandBuffers( bufferAllocateInfo );
 
+    // Secondary buffers inherit the render pass, which compute passes never begin
+    if ( !computePass )
+    {
+        parallelRecorder = std::make_unique< ParallelCommandRecorder >( context, buffers.size( ) );
+    }
+
     setDepthBias = request.setDepthBias;
     depthBiasConstant = request.depthBiasConstant;
     depthBiasSlope = request.depthBiasSlope;
@@ -532,6 +867,16 @@ std::string VulkanRenderPass::getProperty( const std::string &propertyName )
         return setDepthBias ? "true" : "false";
     }
 
+    if ( propertyName == "CommandsEmitted" )
+    {
+        return std::to_string( recordingStats.emitted );
+    }
+
+    if ( propertyName == "CommandsElided" )
+    {
+        return std::to_string( recordingStats.elided );
+    }
+
     return "";
 }
 
@@ -542,7 +887,7 @@ void VulkanRenderPass::frameStart( const uint32_t &frameIndex, const std::vector
     for ( auto &pipeline: pipelines )
     {
         auto vkPipeline = ( VulkanPipeline * )( pipeline );
-        vkPipeline->descriptorManager->resetObjectCounter( );
+        vkPipeline->descriptorManager->resetUpdatedTextures( );
     }
 }
 
@@ -552,20 +897,9 @@ void VulkanRenderPass::begin( std::shared_ptr< IRenderTarget > renderTarget, std
     ASSERT_M( renderTarget != nullptr, "RenderPassRequest must pass a valid renderTarget pointer." );
     currentRenderTarget = std::dynamic_pointer_cast< VulkanRenderTarget >( renderTarget );
 
-    vk::RenderPassBeginInfo renderPassBeginInfo { };
-
-    renderPassBeginInfo.renderPass = renderPass;
-    renderPassBeginInfo.framebuffer = currentRenderTarget->ref;
-    renderPassBeginInfo.renderArea.offset = vk::Offset2D { renderArea.x, renderArea.y };
-    renderPassBeginInfo.renderArea.extent = vk::Extent2D { renderArea.width, renderArea.height };
-    renderPassBeginInfo.clearValueCount = clearColors.size( );
-    renderPassBeginInfo.pClearValues = clearColors.data( );
-
-    vk::CommandBufferBeginInfo beginInfo { };
-    beginInfo.flags = { };
-
-    buffers[ frameIndex ].begin( beginInfo );
-    buffers[ frameIndex ].beginRenderPass( &renderPassBeginInfo, vk::SubpassContents::eInline );
+    // The render pass itself is begun on submit, once it is known whether the draws are recorded inline
+    recordedDraws.clear( );
+    subpassBegins.clear( );
 }
 
 void VulkanRenderPass::bindPipeline( IPipeline * pipeline )
@@ -588,23 +922,23 @@ vk::PipelineBindPoint VulkanRenderPass::getBoundPipelineBindPoint( ) const
 
 void VulkanRenderPass::bindPerFrame( std::shared_ptr< ShaderResource > resource )
 {
-    if ( resource->type == ResourceType::Uniform )
+    if ( resource->type == ResourceType::Uniform || resource->type == ResourceType::StorageBuffer )
     {
         boundPipeline->descriptorManager->updateUniform(
                 frameIndex,
                 resource->identifier.name,
-                static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer )->buffer,
-                0, // Global resource object index doesn't matter
+                *static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer ),
                 resource->identifier.deviation
         );
+
+        boundPipeline->descriptorManager->setDynamicOffset( resource->identifier.name, resource->bufferOffset );
     }
     else if ( resource->type == ResourceType::Sampler2D || resource->type == ResourceType::DepthImage || resource->type == ResourceType::CubeMap )
     {
         boundPipeline->descriptorManager->updateTexture(
                 frameIndex,
                 resource->identifier.getKey( ),
-                *static_cast< VulkanTextureWrapper * >( resource->apiSpecificBuffer ),
-                0 // Global resource object index doesn't matter
+                *static_cast< VulkanTextureWrapper * >( resource->apiSpecificBuffer )
         );
     }
 }
@@ -614,37 +948,12 @@ void VulkanRenderPass::bindPerObject( std::shared_ptr< ShaderResource > resource
     if ( resource->type == ResourceType::VertexData )
     {
         vertexDataAttachment = ( VertexData * )( resource->dataAttachment.get( ) );
-
-        const auto bufferWrapper = static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer );
-
-        const vk::DeviceSize offset = 0;
-
-        bindVertexBuffer = [ = ]( )
-        {
-            buffers[ frameIndex ].bindVertexBuffers(
-                    0,
-                    1,
-                    &bufferWrapper->buffer.first,
-                    &offset
-            );
-        };
+        vertexBuffer = static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer )->buffer.first;
     }
     else if ( resource->type == ResourceType::IndexData )
     {
         indexDataAttachment = ( IndexData * )( resource->dataAttachment.get( ) );
-
-        const auto bufferWrapper = static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer );
-
-        const vk::DeviceSize offset = 0;
-
-        bindIndexBuffer = [ = ]( )
-        {
-            buffers[ frameIndex ].bindIndexBuffer(
-                    bufferWrapper->buffer.first,
-                    offset,
-                    vk::IndexType::eUint32
-            );
-        };
+        indexBuffer = static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer )->buffer.first;
     }
     else if ( resource->type == ResourceType::PushConstant )
     {
@@ -654,23 +963,23 @@ void VulkanRenderPass::bindPerObject( std::shared_ptr< ShaderResource > resource
                 resource->dataAttachment->content
         );
     }
-    else if ( resource->type == ResourceType::Uniform )
+    else if ( resource->type == ResourceType::Uniform || resource->type == ResourceType::StorageBuffer )
     {
         boundPipeline->descriptorManager->updateUniform(
                 frameIndex,
                 resource->identifier.name,
-                static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer )->buffer,
-                boundPipeline->descriptorManager->getObjectCount( ),
+                *static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer ),
                 resource->identifier.deviation
         );
+
+        boundPipeline->descriptorManager->setDynamicOffset( resource->identifier.name, resource->bufferOffset );
     }
     else if ( resource->type == ResourceType::Sampler2D || resource->type == ResourceType::DepthImage || resource->type == ResourceType::CubeMap )
     {
         boundPipeline->descriptorManager->updateTexture(
                 frameIndex,
                 resource->identifier.getKey( ),
-                *static_cast< VulkanTextureWrapper * >( resource->apiSpecificBuffer ),
-                boundPipeline->descriptorManager->getObjectCount( )
+                *static_cast< VulkanTextureWrapper * >( resource->apiSpecificBuffer )
         );
     }
 }
@@ -683,77 +992,222 @@ void VulkanRenderPass::bindPerObject( std::shared_ptr< ShaderResource > resource
  * -
  */
 
-void VulkanRenderPass::draw( const uint32_t &instanceCount )
+RecordedDraw &VulkanRenderPass::captureBoundState( )
 {
-    FUNCTION_BREAK( vertexDataAttachment == nullptr )
+    // Descriptor sets and push constants are resolved here, the engine side binding state is not thread safe
+    RecordedDraw &recordedDraw = recordedDraws.emplace_back( );
+    recordedDraw.bindPoint = getBoundPipelineBindPoint( );
+    recordedDraw.pipeline = boundPipeline->pipeline;
+    recordedDraw.layout = boundPipeline->layout;
+    recordedDraw.descriptorSets = boundPipeline->descriptorManager->getOrderedSets( frameIndex );
+
+    for ( uint32_t set = 0; set < recordedDraw.descriptorSets.size( ); ++set )
+    {
+        recordedDraw.dynamicOffsets.push_back( boundPipeline->descriptorManager->getDynamicOffsets( set ) );
+    }
 
-    auto descriptorSets = boundPipeline->descriptorManager->getOrderedSets( frameIndex, boundPipeline->descriptorManager->getObjectCount( ) );
+    for ( const auto &pushConstantBinding: boundPipeline->descriptorManager->getPushConstantBindings( frameIndex ) )
+    {
+        recordedDraw.pushConstants.push_back( {
+                pushConstantBinding.stage,
+                pushConstantBinding.offset,
+                std::vector< char >( pushConstantBinding.data + pushConstantBinding.offset, pushConstantBinding.data + pushConstantBinding.totalSize )
+        } );
+    }
 
-    buffers[ frameIndex ].setViewport( 0, 1, &viewport );
-    buffers[ frameIndex ].setScissor( 0, 1, &viewScissor );
-    buffers[ frameIndex ].bindPipeline( getBoundPipelineBindPoint( ), boundPipeline->pipeline );
+    return recordedDraw;
+}
 
-    bindVertexBuffer( );
+void VulkanRenderPass::draw( const uint32_t &instanceCount, const uint32_t &firstInstance )
+{
+    FUNCTION_BREAK( vertexDataAttachment == nullptr )
+    ASSERT_M( !computePass, "Async compute passes can only dispatch compute pipelines!" );
+
+    RecordedDraw &recordedDraw = captureBoundState( );
+    recordedDraw.vertexBuffer = vertexBuffer;
+    recordedDraw.instanceCount = instanceCount;
+    recordedDraw.firstInstance = firstInstance;
 
     if ( indexDataAttachment != nullptr )
     {
-        bindIndexBuffer( );
+        recordedDraw.indexBuffer = indexBuffer;
+        recordedDraw.count = indexDataAttachment->indexCount;
+        recordedDraw.firstElement = indexDataAttachment->firstIndex;
+        recordedDraw.vertexOffset = vertexDataAttachment->firstVertex;
     }
+    else
+    {
+        recordedDraw.indexBuffer = nullptr;
+        recordedDraw.count = vertexDataAttachment->vertexCount;
+        recordedDraw.firstElement = vertexDataAttachment->firstVertex;
+        recordedDraw.vertexOffset = 0;
+    }
+
+    vertexDataAttachment = nullptr;
+    indexDataAttachment = nullptr;
+}
+
+void VulkanRenderPass::dispatch( const uint32_t &groupCountX, const uint32_t &groupCountY, const uint32_t &groupCountZ )
+{
+    ASSERT_M( computePass && boundPipeline->bindPoint == BindPoint::Compute, "Only async compute passes can dispatch, and only compute pipelines!" );
 
-    if ( setDepthBias )
+    RecordedDraw &recordedDispatch = captureBoundState( );
+    recordedDispatch.groupCount = { groupCountX, groupCountY, groupCountZ };
+}
+
+void VulkanRenderPass::nextSubpass( )
+{
+    ASSERT_M( subpassBegins.size( ) + 1 < colorAttachmentCounts.size( ), "The render pass has no further subpass!" );
+    subpassBegins.push_back( recordedDraws.size( ) );
+}
+
+void VulkanRenderPass::recordDraws( )
+{
+    if ( computePass )
     {
-        buffers[ frameIndex ].setDepthBias( depthBiasConstant, 0.0f, depthBiasSlope );
+        recordComputeWork( );
+        return;
     }
 
-    buffers[ frameIndex ].bindDescriptorSets(
-            getBoundPipelineBindPoint( ),
-            boundPipeline->layout,
-            0,
-            descriptorSets.size( ),
-            descriptorSets.data( ),
-            0,
-            nullptr
-    );
+    vk::RenderPassBeginInfo renderPassBeginInfo { };
 
-    for ( const auto &pushConstantBinding: boundPipeline->descriptorManager->getPushConstantBindings( frameIndex ) )
+    renderPassBeginInfo.renderPass = renderPass;
+    renderPassBeginInfo.framebuffer = currentRenderTarget->ref;
+    renderPassBeginInfo.renderArea.offset = vk::Offset2D { renderArea.x, renderArea.y };
+    renderPassBeginInfo.renderArea.extent = vk::Extent2D { renderArea.width, renderArea.height };
+    renderPassBeginInfo.clearValueCount = clearColors.size( );
+    renderPassBeginInfo.pClearValues = clearColors.data( );
+
+    vk::CommandBufferBeginInfo beginInfo { };
+    beginInfo.flags = { };
+
+    buffers[ frameIndex ].begin( beginInfo );
+
+    PassRecordingState state { };
+    state.viewport = viewport;
+    state.scissor = viewScissor;
+    state.setDepthBias = setDepthBias;
+    state.depthBiasConstant = depthBiasConstant;
+    state.depthBiasSlope = depthBiasSlope;
+
+    recordingStats = { };
+
+    // Secondary buffers are recorded once per frame, only the first subpass with enough draws is recorded in parallel
+    bool parallelRecorderUsed = false;
+
+    for ( uint32_t subpass = 0; subpass < colorAttachmentCounts.size( ); ++subpass )
     {
-        buffers[ frameIndex ].pushConstants(
-                boundPipeline->layout,
-                pushConstantBinding.stage,
-                0,
-                pushConstantBinding.totalSize,
-                pushConstantBinding.data );
+        const uint32_t firstDraw = subpass == 0 ? 0 : subpassBegins[ subpass - 1 ];
+        const uint32_t endDraw = subpass < subpassBegins.size( ) ? subpassBegins[ subpass ] : recordedDraws.size( );
+
+        const bool recordInParallel = !parallelRecorderUsed && endDraw - firstDraw >= PARALLEL_RECORDING_MIN_DRAWS;
+        const vk::SubpassContents contents = recordInParallel ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline;
+
+        if ( subpass == 0 )
+        {
+            buffers[ frameIndex ].beginRenderPass( &renderPassBeginInfo, contents );
+        }
+        else
+        {
+            buffers[ frameIndex ].nextSubpass( contents );
+        }
+
+        if ( recordInParallel )
+        {
+            vk::CommandBufferInheritanceInfo inheritanceInfo { };
+            inheritanceInfo.renderPass = renderPass;
+            inheritanceInfo.subpass = subpass;
+            inheritanceInfo.framebuffer = currentRenderTarget->ref;
+
+            parallelRecorder->record( frameIndex, buffers[ frameIndex ], inheritanceInfo, state, recordedDraws.data( ) + firstDraw, endDraw - firstDraw, recordingStats );
+            parallelRecorderUsed = true;
+        }
+        else
+        {
+            // Also resets the tracked state, which is undefined after secondary buffers were executed
+            stateTracker.begin( buffers[ frameIndex ] );
+
+            for ( uint32_t draw = firstDraw; draw < endDraw; ++draw )
+            {
+                ParallelCommandRecorder::recordDraw( stateTracker, state, recordedDraws[ draw ] );
+            }
+
+            recordingStats.emitted += stateTracker.getStats( ).emitted;
+            recordingStats.elided += stateTracker.getStats( ).elided;
+        }
     }
 
-    if ( indexDataAttachment != nullptr )
+    buffers[ frameIndex ].endRenderPass( );
+    buffers[ frameIndex ].end( );
+}
+
+void VulkanRenderPass::recordComputeWork( )
+{
+    vk::CommandBufferBeginInfo beginInfo { };
+    beginInfo.flags = { };
+
+    buffers[ frameIndex ].begin( beginInfo );
+
+    // Outputs are storage images rewritten every frame, their previous content is discarded. They are shared concurrently
+    // with the graphics queue, no ownership transfer is needed for the passes sampling them afterwards
+    std::vector< vk::ImageMemoryBarrier > writeBarriers;
+    std::vector< vk::ImageMemoryBarrier > readBarriers;
+
+    for ( const auto &outputImage: currentRenderTarget->outputImages )
     {
-        buffers[ frameIndex ].drawIndexed(
-                indexDataAttachment->indexCount,
-                instanceCount,
-                0,
-                0,
-                0
-        );
+        vk::ImageMemoryBarrier &writeBarrier = writeBarriers.emplace_back( );
+        writeBarrier.oldLayout = vk::ImageLayout::eUndefined;
+        writeBarrier.newLayout = vk::ImageLayout::eGeneral;
+        writeBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        writeBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        writeBarrier.image = static_cast< VulkanTextureWrapper * >( outputImage->apiSpecificBuffer )->image;
+        writeBarrier.subresourceRange = vk::ImageSubresourceRange { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+        writeBarrier.srcAccessMask = { };
+        writeBarrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+
+        vk::ImageMemoryBarrier &readBarrier = readBarriers.emplace_back( writeBarrier );
+        readBarrier.oldLayout = vk::ImageLayout::eGeneral;
+        readBarrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+        readBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+        readBarrier.dstAccessMask = queueType == QueueType::Compute ? vk::AccessFlags { } : vk::AccessFlagBits::eShaderRead;
     }
-    else
+
+    buffers[ frameIndex ].pipelineBarrier( vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, { },
+                                           0, nullptr, 0, nullptr, writeBarriers.size( ), writeBarriers.data( ) );
+
+    recordingStats = { };
+    stateTracker.begin( buffers[ frameIndex ] );
+
+    for ( const auto &recordedDispatch: recordedDraws )
     {
-        buffers[ frameIndex ].draw(
-                vertexDataAttachment->vertexCount,
-                instanceCount,
-                0,
-                0
-        );
+        ParallelCommandRecorder::recordDispatch( stateTracker, recordedDispatch );
     }
 
-    boundPipeline->descriptorManager->incrementObjectCounter( );
-    vertexDataAttachment = nullptr;
-    indexDataAttachment = nullptr;
+    recordingStats.emitted += stateTracker.getStats( ).emitted;
+    recordingStats.elided += stateTracker.getStats( ).elided;
+
+    // On the compute queue the timeline semaphore the consumers wait on makes the writes visible, only the layout changes here
+    const vk::PipelineStageFlags readStages = queueType == QueueType::Compute ? vk::PipelineStageFlags( vk::PipelineStageFlagBits::eBottomOfPipe )
+                                                                              : vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+
+    buffers[ frameIndex ].pipelineBarrier( vk::PipelineStageFlagBits::eComputeShader, readStages, { },
+                                           0, nullptr, 0, nullptr, readBarriers.size( ), readBarriers.data( ) );
+
+    buffers[ frameIndex ].end( );
 }
 
 bool VulkanRenderPass::submit( std::vector< std::shared_ptr< IResourceLock > > waitOnLock, IResourceLock * notifyFence )
 {
-    buffers[ frameIndex ].endRenderPass( );
-    buffers[ frameIndex ].end( );
+    recordDraws( );
+
+    // Queue submission order and the subpass dependencies order the batched passes on the GPU
+    if ( queueType == QueueType::Graphics && notifyFence == nullptr && waitOnLock.empty( ) && currentRenderTarget->type != RenderTargetType::SwapChain )
+    {
+        context->pendingGraphicsSubmits.push_back( buffers[ frameIndex ] );
+        return true;
+    }
+
+    ASSERT_M( !computePass || currentRenderTarget->type != RenderTargetType::SwapChain, "Async compute passes cannot present!" );
 
     if ( currentRenderTarget->type == RenderTargetType::SwapChain )
     {
@@ -761,6 +1215,9 @@ bool VulkanRenderPass::submit( std::vector< std::shared_ptr< IResourceLock > > w
 
         if ( result.result == vk::Result::eErrorOutOfDateKHR )
         {
+            // The frame is dropped, the batched passes are recorded again for the redraw
+            context->pendingGraphicsSubmits.clear( );
+
             auto swapChainInvalidated = std::make_unique< Input::SwapChainInvalidatedParameters >( );
             Input::Events::trigger( Input::EventType::SwapChainInvalidated, swapChainInvalidated.get( ) );
             return false;
@@ -773,13 +1230,33 @@ bool VulkanRenderPass::submit( std::vector< std::shared_ptr< IResourceLock > > w
         swapChainIndex = result.value;
     }
 
-    vk::SubmitInfo submitInfo { };
+    std::vector< vk::SubmitInfo > submitInfos;
+
+    // Batched passes go first, in a separate batch so they do not wait on the swap chain image
+    if ( queueType == QueueType::Graphics && !context->pendingGraphicsSubmits.empty( ) )
+    {
+        vk::SubmitInfo &pendingSubmitInfo = submitInfos.emplace_back( );
+        pendingSubmitInfo.commandBufferCount = context->pendingGraphicsSubmits.size( );
+        pendingSubmitInfo.pCommandBuffers = context->pendingGraphicsSubmits.data( );
+    }
+
+    vk::SubmitInfo &submitInfo = submitInfos.emplace_back( );
 
     std::vector< vk::Semaphore > semaphores;
 
     for ( auto &waitOn: waitOnLock )
     {
-        semaphores.push_back( std::dynamic_pointer_cast< VulkanResourceLock >( waitOn )->getVkSemaphore( ) );
+        auto lock = std::dynamic_pointer_cast< VulkanResourceLock >( waitOn );
+
+        if ( lock->getLockType( ) == ResourceLockType::Fence )
+        { // Work on the same queue is already ordered by submission order
+            SKIP_ITERATION_IF( lock->getTimeline( ) == nullptr || lock->getTimeline( ) == timeline )
+            timeline->waitFor( lock->getTimeline( ), lock->getTimelineValue( ), vk::PipelineStageFlagBits::eAllCommands );
+        }
+        else
+        {
+            semaphores.push_back( lock->getVkSemaphore( ) );
+        }
     }
 
     if ( currentRenderTarget->type == RenderTargetType::SwapChain )
@@ -787,11 +1264,11 @@ bool VulkanRenderPass::submit( std::vector< std::shared_ptr< IResourceLock > > w
         semaphores.push_back( swapChainImageAvailable[ frameIndex ]->getVkSemaphore( ) );
     }
 
-    vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+    std::vector< vk::PipelineStageFlags > waitStages( semaphores.size( ), vk::PipelineStageFlagBits::eColorAttachmentOutput );
 
     submitInfo.waitSemaphoreCount = semaphores.size( );
     submitInfo.pWaitSemaphores = semaphores.data( );
-    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.pWaitDstStageMask = waitStages.data( );
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &buffers[ frameIndex ];
 
@@ -806,13 +1283,29 @@ bool VulkanRenderPass::submit( std::vector< std::shared_ptr< IResourceLock > > w
         submitInfo.pSignalSemaphores = nullptr;
     }
 
-    notifyFence->reset( );
-    auto submitResult = context->queues[ QueueType::Graphics ].submit( 1, &submitInfo, (( VulkanResourceLock * )( notifyFence ))->getVkFence( ) );
+    const uint64_t timelineValue = timeline->submit( submitInfos );
 
-    VkCheckResult( submitResult );
+    if ( queueType == QueueType::Graphics )
+    {
+        context->pendingGraphicsSubmits.clear( );
+
+        // Every graphics pass recorded so far is part of this submission, resources released meanwhile are retired with it
+        timeline->retirePendingAt( timelineValue );
+    }
+
+    if ( notifyFence != nullptr )
+    {
+        ( ( VulkanResourceLock * ) ( notifyFence ) )->setTimelineValue( timeline, timelineValue );
+    }
     if ( currentRenderTarget->type == RenderTargetType::SwapChain )
     {
         presentPassToSwapChain( );
+
+        // End of the frame, releases on the compute queue are otherwise only run by its next submission
+        if ( context->computeTimeline != nullptr )
+        {
+            context->computeTimeline->collect( );
+        }
     }
 
     return true;
@@ -880,6 +1373,7 @@ void VulkanRenderPass::cleanup( )
         lock->cleanup( );
     }
 
+    parallelRecorder.reset( );
     context->logicalDevice.destroyRenderPass( renderPass );
 }
 
@@ -894,11 +1388,29 @@ void VulkanRenderTarget::cleanup( )
     {
         context->logicalDevice.destroyImageView( buffer.imageView );
         context->logicalDevice.destroySampler( buffer.sampler );
-        context->vma.destroyImage( buffer.image, buffer.allocation );
+
+        if ( buffer.allocation )
+        {
+            context->vma.destroyImage( buffer.image, buffer.allocation );
+        }
+        else
+        {
+            transientMemory->destroyImage( buffer.image );
+        }
+
+        notifyResourceDestroyed( context, buffer.uid );
     }
 
     buffers.clear( );
 
+    for ( auto &view: shaderReadViews )
+    {
+        context->logicalDevice.destroyImageView( view );
+    }
+
+    shaderReadViews.clear( );
+    attachmentViews.clear( );
+
     context->logicalDevice.destroyFramebuffer( ref );
 }
 
@@ -17,9 +17,22 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <BlazarGraphics/VulkanBackend/VulkanResourceProvider.h>
+#include <BlazarGraphics/VulkanBackend/BindlessTextureTable.h>
 
 NAMESPACES( ENGINE_NAMESPACE, Graphics )
 
+// Submitted frames may still reference the resource, it is released once the graphics queue is past them
+static void retireResource( VulkanContext * context, std::function< void( ) > release )
+{
+    if ( context->graphicsTimeline == nullptr )
+    {
+        release( );
+        return;
+    }
+
+    context->graphicsTimeline->retireAfterPending( std::move( release ) );
+}
+
 std::shared_ptr< ShaderResource > VulkanResourceProvider::createResource( const ShaderResourceRequest &request )
 {
     auto resource = std::make_shared< ShaderResource >( );
@@ -34,6 +47,7 @@ std::shared_ptr< ShaderResource > VulkanResourceProvider::createResource( const
         case ResourceType::VertexData:
         case ResourceType::IndexData:
         case ResourceType::Uniform:
+        case ResourceType::StorageBuffer:
             createBufferAllocator( resource );
             break;
         case ResourceType::Sampler2D:
@@ -75,6 +89,10 @@ void VulkanResourceProvider::createBufferAllocator( const std::shared_ptr< Shade
         {
             bufferCreateInfo.usage = vk::BufferUsageFlagBits::eUniformBuffer;
         }
+        else if ( resource->type == ResourceType::StorageBuffer )
+        {
+            bufferCreateInfo.usage = vk::BufferUsageFlagBits::eStorageBuffer;
+        }
         else if ( resource->type == ResourceType::VertexData )
         {
             bufferCreateInfo.usage = vk::BufferUsageFlagBits::eVertexBuffer;
@@ -87,6 +105,12 @@ void VulkanResourceProvider::createBufferAllocator( const std::shared_ptr< Shade
         bufferCreateInfo.size = size;
         bufferCreateInfo.sharingMode = vk::SharingMode::eExclusive;
 
+        // Async compute passes read uniforms and storage buffers too
+        if ( resource->type == ResourceType::Uniform || resource->type == ResourceType::StorageBuffer )
+        {
+            VulkanUtilities::shareAcrossQueues( context, bufferCreateInfo );
+        }
+
         vma::AllocationCreateInfo allocationInfo;
 
         if ( resource->loadStrategy == ResourceLoadStrategy::LoadPerFrame )
@@ -118,16 +142,55 @@ void VulkanResourceProvider::createBufferAllocator( const std::shared_ptr< Shade
                     ->generateBuffers( vk::CommandBufferUsageFlagBits::eOneTimeSubmit, 1 )
                     ->beginCommand( )
                     ->copyBuffer( size, stagingBuffer.first, buffer.first )
-                    ->execute( );
-
-            context->vma.destroyBuffer( stagingBuffer.first, stagingBuffer.second );
+                    ->execute( [ context = this->context, stagingBuffer ]( )
+                               {
+                                   context->vma.destroyBuffer( stagingBuffer.first, stagingBuffer.second );
+                               } );
         }
         else
         {
             wrapper->mappedMemory = this->context->vma.mapMemory( buffer.second );
 
-            memcpy( wrapper->mappedMemory, content, size );
+            if ( content != nullptr )
+            {
+                memcpy( wrapper->mappedMemory, content, size );
+            }
+        }
+    };
+
+    resource->write = [ = ]( const uint64_t &offset, const void *data, const uint64_t &size )
+    {
+        auto *pWrapper = static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer );
+
+        if ( pWrapper->keepMemoryMapped )
+        {
+            memcpy( static_cast< char * >( pWrapper->mappedMemory ) + offset, data, size );
+
+            return;
+        }
+
+        if ( resource->loadStrategy == ResourceLoadStrategy::LoadOnce || resource->loadStrategy == ResourceLoadStrategy::LoadOnUpdate )
+        {
+            // Only the written range is staged, the rest of the buffer keeps its content
+            std::pair< vk::Buffer, vma::Allocation > stagingBuffer;
+            VulkanUtilities::initStagingBuffer( context, stagingBuffer, data, size );
+
+            commandExecutor->startCommandExecution( )
+                    ->generateBuffers( vk::CommandBufferUsageFlagBits::eOneTimeSubmit, 1 )
+                    ->beginCommand( )
+                    ->copyBuffer( size, stagingBuffer.first, pWrapper->buffer.first, offset )
+                    ->execute( [ context = this->context, stagingBuffer ]( )
+                               {
+                                   context->vma.destroyBuffer( stagingBuffer.first, stagingBuffer.second );
+                               } );
+            return;
         }
+
+        const auto deviceMemory = this->context->vma.mapMemory( pWrapper->buffer.second );
+
+        memcpy( static_cast< char * >( deviceMemory ) + offset, data, size );
+
+        this->context->vma.unmapMemory( pWrapper->buffer.second );
     };
 
     resource->update = [ = ]( )
@@ -143,6 +206,23 @@ void VulkanResourceProvider::createBufferAllocator( const std::shared_ptr< Shade
 
         auto &buffer = pWrapper->buffer;
 
+        if ( resource->loadStrategy == ResourceLoadStrategy::LoadOnce || resource->loadStrategy == ResourceLoadStrategy::LoadOnUpdate )
+        {
+            // Device local memory cannot be mapped, go through a staging buffer like allocate does
+            std::pair< vk::Buffer, vma::Allocation > stagingBuffer;
+            VulkanUtilities::initStagingBuffer( context, stagingBuffer, resource->dataAttachment->content, resource->dataAttachment->size );
+
+            commandExecutor->startCommandExecution( )
+                    ->generateBuffers( vk::CommandBufferUsageFlagBits::eOneTimeSubmit, 1 )
+                    ->beginCommand( )
+                    ->copyBuffer( resource->dataAttachment->size, stagingBuffer.first, buffer.first )
+                    ->execute( [ context = this->context, stagingBuffer ]( )
+                               {
+                                   context->vma.destroyBuffer( stagingBuffer.first, stagingBuffer.second );
+                               } );
+            return;
+        }
+
         const auto deviceMemory = this->context->vma.mapMemory( buffer.second );
 
         memcpy( deviceMemory, resource->dataAttachment->content, resource->dataAttachment->size );
@@ -153,17 +233,21 @@ void VulkanResourceProvider::createBufferAllocator( const std::shared_ptr< Shade
     resource->deallocate = [ = ]( )
     {
         auto *pWrapper = static_cast< VulkanBufferWrapper * >( resource->apiSpecificBuffer );
-        
-        if ( pWrapper->keepMemoryMapped )
+
+        retireResource( context, [ context = this->context, pWrapper ]( )
         {
-            this->context->vma.unmapMemory( pWrapper->buffer.second );
-        }
+            if ( pWrapper->keepMemoryMapped )
+            {
+                context->vma.unmapMemory( pWrapper->buffer.second );
+            }
 
-        auto &buffer = pWrapper->buffer;
+            auto &buffer = pWrapper->buffer;
 
-        context->vma.destroyBuffer( buffer.first, buffer.second );
+            context->vma.destroyBuffer( buffer.first, buffer.second );
+            notifyResourceDestroyed( context, pWrapper->uid );
 
-        delete pWrapper;
+            delete pWrapper;
+        } );
     };
 }
 
@@ -208,13 +292,21 @@ void VulkanResourceProvider::createSampler2DAllocator( const std::shared_ptr< Sh
     {
         auto *pWrapper = reinterpret_cast< VulkanTextureWrapper * >( resource->apiSpecificBuffer );
 
-        auto &buffer = pWrapper->image;
+        // Released with the frame being recorded, the table defers reusing the slot until that frame completed
+        if ( context->bindlessTextures != nullptr )
+        {
+            context->bindlessTextures->release( pWrapper->uid );
+        }
 
-        context->vma.destroyImage( pWrapper->image, pWrapper->allocation );
-        context->logicalDevice.destroyImageView( pWrapper->imageView );
-        context->logicalDevice.destroySampler( pWrapper->sampler );
+        retireResource( context, [ context = this->context, pWrapper ]( )
+        {
+            context->vma.destroyImage( pWrapper->image, pWrapper->allocation );
+            context->logicalDevice.destroyImageView( pWrapper->imageView );
+            context->logicalDevice.destroySampler( pWrapper->sampler );
+            notifyResourceDestroyed( context, pWrapper->uid );
 
-        delete pWrapper;
+            delete pWrapper;
+        } );
     };
 }
 
@@ -245,16 +337,23 @@ void VulkanResourceProvider::createCubeMapAllocator( const std::shared_ptr< Shad
     {
         auto *pWrapper = reinterpret_cast< VulkanTextureWrapper * >( resource->apiSpecificBuffer );
 
-        auto &buffer = pWrapper->image;
-
-        context->vma.destroyImage( pWrapper->image, pWrapper->allocation );
-        context->logicalDevice.destroyImageView( pWrapper->imageView );
-        context->logicalDevice.destroySampler( pWrapper->sampler );
+        retireResource( context, [ context = this->context, pWrapper ]( )
+        {
+            context->vma.destroyImage( pWrapper->image, pWrapper->allocation );
+            context->logicalDevice.destroyImageView( pWrapper->imageView );
+            context->logicalDevice.destroySampler( pWrapper->sampler );
+            notifyResourceDestroyed( context, pWrapper->uid );
 
-        delete pWrapper;
+            delete pWrapper;
+        } );
     };
 }
 
+void VulkanResourceProvider::retire( std::function< void( ) > release )
+{
+    retireResource( context, std::move( release ) );
+}
+
 std::unique_ptr< IResourceLock > VulkanResourceProvider::createLock( const ResourceLockType &lockType )
 {
     return std::make_unique< VulkanResourceLock >( context, lockType );
@@ -262,14 +361,8 @@ std::unique_ptr< IResourceLock > VulkanResourceProvider::createLock( const Resou
 
 VulkanResourceLock::VulkanResourceLock( VulkanContext *context, const ResourceLockType &lockType ) : IResourceLock( lockType ), context( context )
 {
-    if ( lockType == ResourceLockType::Fence )
-    {
-        vk::FenceCreateInfo fenceCreateInfo { };
-        fenceCreateInfo.flags = vk::FenceCreateFlagBits::eSignaled;
-
-        fence = this->context->logicalDevice.createFence( fenceCreateInfo );
-    }
-    else
+    // A fence is reached until a submission notifies it
+    if ( lockType == ResourceLockType::Semaphore )
     {
         vk::SemaphoreCreateInfo semaphoreCreateInfo { };
         semaphore = this->context->logicalDevice.createSemaphore( semaphoreCreateInfo );
@@ -278,50 +371,22 @@ VulkanResourceLock::VulkanResourceLock( VulkanContext *context, const ResourceLo
 
 void BlazarEngine::Graphics::VulkanResourceLock::wait( )
 {
-    if ( lockType == ResourceLockType::Fence )
-    {
-        auto result = context->logicalDevice.waitForFences( 1, &fence, true, UINT64_MAX );
-        VkCheckResult( result );
-    }
-    else
-    {
-        vk::SemaphoreWaitInfo waitInfo { };
-        waitInfo.semaphoreCount = 1;
-        waitInfo.pSemaphores = &semaphore;
-        waitInfo.flags = vk::SemaphoreWaitFlagBits::eAny;
+    // Semaphore locks are binary semaphores, they are only waited on and signaled by queue submissions
+    ASSERT_M( lockType == ResourceLockType::Fence, "A semaphore lock cannot be waited on from the host!" );
 
-        auto result = context->logicalDevice.waitSemaphores( waitInfo, UINT64_MAX );
-        VkCheckResult( result );
-    }
+    FUNCTION_BREAK( timeline == nullptr )
+    timeline->wait( timelineValue );
 }
 
 void VulkanResourceLock::reset( )
 {
-    if ( lockType == ResourceLockType::Fence )
-    {
-        vk::Result result = context->logicalDevice.resetFences( 1, &fence );
-
-        if ( result != vk::Result::eSuccess )
-        {
-
-        }
-    }
-    else
-    {
-        // No matching functionality
-    }
+    // Nothing to reset, the next submission notifying the fence assigns a new timeline value
 }
 
 void BlazarEngine::Graphics::VulkanResourceLock::notify( )
 {
-    if ( lockType == ResourceLockType::Fence )
-    {
-        // No notify on client
-    }
-    else
-    {
-        context->logicalDevice.signalSemaphore( semaphore );
-    }
+    // Fences are reached by the submission they are assigned to, binary semaphores cannot be signaled from the host
+    ASSERT_M( lockType == ResourceLockType::Fence, "A semaphore lock cannot be signaled from the host!" );
 }
 
 VulkanResourceLock::~VulkanResourceLock( )
@@ -329,11 +394,6 @@ VulkanResourceLock::~VulkanResourceLock( )
     VulkanResourceLock::cleanup( );
 }
 
-const vk::Fence &VulkanResourceLock::getVkFence( )
-{
-    return fence;
-}
-
 const vk::Semaphore &VulkanResourceLock::getVkSemaphore( )
 {
     return semaphore;
@@ -344,11 +404,7 @@ void VulkanResourceLock::cleanup( )
     FUNCTION_BREAK( resourceCleaned )
     resourceCleaned = true;
 
-    if ( lockType == ResourceLockType::Fence )
-    {
-        context->logicalDevice.destroyFence( fence );
-    }
-    else
+    if ( lockType == ResourceLockType::Semaphore )
     {
         context->logicalDevice.destroySemaphore( semaphore );
     }
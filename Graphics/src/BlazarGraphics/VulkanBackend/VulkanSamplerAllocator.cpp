@@ -56,6 +56,9 @@ void VulkanSamplerAllocator::load( const TextureLoadArguments& arguments, Vulkan
         case ResourceImageFormat::R16G16B16A16Sfloat:
             format = vk::Format::eR16G16B16A16Sfloat;
             break;
+        case ResourceImageFormat::R16G16Sfloat:
+            format = vk::Format::eR16G16Sfloat;
+            break;
         case ResourceImageFormat::R8G8B8A8Unorm:
             format = vk::Format::eR8G8B8A8Unorm;
             break;
@@ -89,6 +92,7 @@ void VulkanSamplerAllocator::load( const TextureLoadArguments& arguments, Vulkan
     imageCreateInfo.usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
     imageCreateInfo.sharingMode = vk::SharingMode::eExclusive;
     imageCreateInfo.samples = vk::SampleCountFlagBits::e1;
+    VulkanUtilities::shareAcrossQueues( context, imageCreateInfo );
 
     vma::AllocationCreateInfo allocationCreateInfo { };
     allocationCreateInfo.usage = vma::MemoryUsage::eGpuOnly;
@@ -139,9 +143,10 @@ void VulkanSamplerAllocator::load( const TextureLoadArguments& arguments, Vulkan
             ->beginCommand( )
             ->pipelineBarrier( args )
             ->copyBufferToImage( copyBufferToImageArgs )
-            ->execute( );
-
-    context->vma.destroyBuffer( stagingBuffer.first, stagingBuffer.second );
+            ->execute( [ context, stagingBuffer ]( )
+                       {
+                           context->vma.destroyBuffer( stagingBuffer.first, stagingBuffer.second );
+                       } );
 
     vk::FormatProperties properties = context->physicalDevice.getFormatProperties( format );
 
@@ -82,6 +82,21 @@ vk::SampleCountFlagBits VulkanUtilities::maxDeviceMSAASampleCount( const vk::Phy
     return vk::SampleCountFlagBits::e1;
 }
 
+bool VulkanUtilities::supportsLazilyAllocatedMemory( const vk::PhysicalDevice &physicalDevice )
+{
+    vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties( );
+
+    for ( uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i )
+    {
+        if ( memoryProperties.memoryTypes[ i ].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 vk::Format VulkanUtilities::findSupportedDepthFormat( vk::PhysicalDevice physicalDevice )
 {
     vk::Format desiredFormats[] = { vk::Format::eD24UnormS8Uint, vk::Format::eD32SfloatS8Uint, vk::Format::eD32Sfloat };
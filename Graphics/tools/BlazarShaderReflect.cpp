@@ -0,0 +1,90 @@
+/*
+Blazar Engine - 3D Game Engine
+Copyright (c) 2020-2021 Muhammed Murat Cengiz
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <BlazarGraphics/VulkanBackend/ShaderReflection.h>
+#include <BlazarCore/Utilities.h>
+
+#include <fstream>
+
+using namespace ENGINE_NAMESPACE::Graphics;
+
+static const uint32_t SPIRV_MAGIC_NUMBER = 0x07230203;
+
+static vk::ShaderStageFlagBits getStage( const std::string &stageName )
+{
+    if ( stageName == "vert" ) return vk::ShaderStageFlagBits::eVertex;
+    if ( stageName == "frag" ) return vk::ShaderStageFlagBits::eFragment;
+    if ( stageName == "tesc" ) return vk::ShaderStageFlagBits::eTessellationControl;
+    if ( stageName == "tese" ) return vk::ShaderStageFlagBits::eTessellationEvaluation;
+    if ( stageName == "geom" ) return vk::ShaderStageFlagBits::eGeometry;
+    if ( stageName == "comp" ) return vk::ShaderStageFlagBits::eCompute;
+
+    throw std::runtime_error( "Unknown shader stage " + stageName + "." );
+}
+
+/*
+ * Writes the reflection of a SPIR-V shader next to it, run by the shader compilation of the build.
+ * Usage: BlazarShaderReflect <stage> <input.spv> <output.refl>
+ */
+int main( int argc, char **argv )
+{
+    if ( argc != 4 )
+    {
+        std::cerr << "Usage: BlazarShaderReflect <vert|frag|tesc|tese|geom> <input.spv> <output" SHADER_REFLECTION_EXTENSION ">" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        const std::string data = ENGINE_NAMESPACE::Core::Utilities::readFile( argv[ 2 ] );
+
+        uint32_t magicNumber = 0;
+
+        if ( data.size( ) >= sizeof( uint32_t ) )
+        {
+            memcpy( &magicNumber, data.data( ), sizeof( uint32_t ) );
+        }
+
+        if ( magicNumber != SPIRV_MAGIC_NUMBER || data.size( ) % sizeof( uint32_t ) != 0 )
+        {
+            std::cerr << argv[ 2 ] << " is not a SPIR-V module." << std::endl;
+            return 1;
+        }
+
+        std::vector< uint32_t > spirv( data.size( ) / sizeof( uint32_t ) );
+        memcpy( spirv.data( ), data.data( ), data.size( ) );
+
+        const ShaderReflection reflection = ShaderReflection::reflect( getStage( argv[ 1 ] ), spirv );
+
+        std::ofstream output( argv[ 3 ], std::ios::binary | std::ios::trunc );
+        output << reflection.serialize( );
+
+        if ( !output.good( ) )
+        {
+            std::cerr << "Failed to write " << argv[ 3 ] << "." << std::endl;
+            return 1;
+        }
+    }
+    catch ( const std::exception &exception )
+    {
+        std::cerr << argv[ 2 ] << ": " << exception.what( ) << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -65,6 +65,7 @@ void SampleGame_Small::init( )
     //world->getGraphSystem()->addPass( CommonPasses::createSMAAEdgePass( ) );
     //world->getGraphSystem()->addPass( CommonPasses::createSMAABlendWeightPass( ) );
     //world->getGraphSystem()->addPass( CommonPasses::createSMAANeighborPass( ) );
+    //world->getGraphSystem()->addPass( CommonPasses::createFXAAPass( ) ); // Instead of the SMAA passes
     world->getGraphSystem()->addPass( presentPass.get( ) );
 
     initialScene = std::make_unique< Scene::Scene >( );
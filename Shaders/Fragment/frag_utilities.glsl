@@ -7,4 +7,23 @@ vec4 gammaCorrectColor( in vec4 color )
 
     colorMapped = vec4(pow(color.rgb, vec3(1 / gammaCorrection)), color.a);
     return colorMapped;
-}
\ No newline at end of file
+}
+
+// Octahedral normal encoding, a unit vector is stored in two components
+vec2 octahedralWrap( in vec2 v )
+{
+    return ( 1.0 - abs( v.yx ) ) * vec2( v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0 );
+}
+
+vec2 encodeNormal( in vec3 n )
+{
+    n /= abs( n.x ) + abs( n.y ) + abs( n.z );
+    return n.z >= 0.0 ? n.xy : octahedralWrap( n.xy );
+}
+
+vec3 decodeNormal( in vec2 encoded )
+{
+    vec3 n = vec3( encoded, 1.0 - abs( encoded.x ) - abs( encoded.y ) );
+    n.xy = n.z >= 0.0 ? n.xy : octahedralWrap( n.xy );
+    return normalize( n );
+}
@@ -0,0 +1,135 @@
+#version 450 core
+
+// Single pass FXAA, the edge is searched along its direction and the pixel is blended with its neighbour across it.
+// Render targets are sampled with nearest filtering, every fetch is at a pixel center and blends are done explicitly.
+
+#define FXAA_EDGE_THRESHOLD 0.125
+#define FXAA_EDGE_THRESHOLD_MIN 0.0312
+#define FXAA_SUBPIXEL_QUALITY 0.75
+#define FXAA_SEARCH_STEPS 8
+
+layout (set = 0, binding = 0) uniform Resolution
+{
+    uint width;
+    uint height;
+} resolution;
+
+layout(set = 1, binding = 0) uniform sampler2D litScene;
+
+layout (location = 0) in vec2 texcoord;
+
+layout (location = 0) out vec4 outColor;
+
+const float searchSteps[ FXAA_SEARCH_STEPS ] = float[]( 1.0, 1.0, 1.0, 2.0, 2.0, 4.0, 4.0, 8.0 );
+
+float luma( in vec4 color )
+{
+    return dot( color.rgb, vec3( 0.299, 0.587, 0.114 ) );
+}
+
+float lumaAt( in vec2 uv )
+{
+    return luma( textureLod( litScene, uv, 0.0 ) );
+}
+
+void main(void)
+{
+    vec2 texel = 1.0 / vec2( resolution.width, resolution.height );
+
+    vec4 center = textureLod( litScene, texcoord, 0.0 );
+
+    float lumaM = luma( center );
+    float lumaN = luma( textureLodOffset( litScene, texcoord, 0.0, ivec2( 0, -1 ) ) );
+    float lumaS = luma( textureLodOffset( litScene, texcoord, 0.0, ivec2( 0, 1 ) ) );
+    float lumaW = luma( textureLodOffset( litScene, texcoord, 0.0, ivec2( -1, 0 ) ) );
+    float lumaE = luma( textureLodOffset( litScene, texcoord, 0.0, ivec2( 1, 0 ) ) );
+
+    float lumaMin = min( lumaM, min( min( lumaN, lumaS ), min( lumaW, lumaE ) ) );
+    float lumaMax = max( lumaM, max( max( lumaN, lumaS ), max( lumaW, lumaE ) ) );
+    float lumaRange = lumaMax - lumaMin;
+
+    // Most of the image has no edges, those pixels leave after five fetches
+    if ( lumaRange < max( FXAA_EDGE_THRESHOLD_MIN, lumaMax * FXAA_EDGE_THRESHOLD ) )
+    {
+        outColor = center;
+        return;
+    }
+
+    float lumaNW = luma( textureLodOffset( litScene, texcoord, 0.0, ivec2( -1, -1 ) ) );
+    float lumaNE = luma( textureLodOffset( litScene, texcoord, 0.0, ivec2( 1, -1 ) ) );
+    float lumaSW = luma( textureLodOffset( litScene, texcoord, 0.0, ivec2( -1, 1 ) ) );
+    float lumaSE = luma( textureLodOffset( litScene, texcoord, 0.0, ivec2( 1, 1 ) ) );
+
+    float lumaNS = lumaN + lumaS;
+    float lumaWE = lumaW + lumaE;
+    float lumaWCorners = lumaNW + lumaSW;
+    float lumaECorners = lumaNE + lumaSE;
+    float lumaNCorners = lumaNW + lumaNE;
+    float lumaSCorners = lumaSW + lumaSE;
+
+    float edgeHorizontal = abs( -2.0 * lumaW + lumaWCorners ) + 2.0 * abs( -2.0 * lumaM + lumaNS ) + abs( -2.0 * lumaE + lumaECorners );
+    float edgeVertical = abs( -2.0 * lumaN + lumaNCorners ) + 2.0 * abs( -2.0 * lumaM + lumaWE ) + abs( -2.0 * lumaS + lumaSCorners );
+    bool isHorizontal = edgeHorizontal >= edgeVertical;
+
+    // The other side of the edge is the neighbour with the steepest gradient
+    float luma1 = isHorizontal ? lumaN : lumaW;
+    float luma2 = isHorizontal ? lumaS : lumaE;
+    float gradient1 = luma1 - lumaM;
+    float gradient2 = luma2 - lumaM;
+
+    bool is1Steepest = abs( gradient1 ) >= abs( gradient2 );
+    float gradientScaled = 0.25 * max( abs( gradient1 ), abs( gradient2 ) );
+    float lumaLocalAverage = 0.5 * ( ( is1Steepest ? luma1 : luma2 ) + lumaM );
+
+    vec2 acrossEdge = ( isHorizontal ? vec2( 0.0, texel.y ) : vec2( texel.x, 0.0 ) ) * ( is1Steepest ? -1.0 : 1.0 );
+    vec2 alongEdge = isHorizontal ? vec2( texel.x, 0.0 ) : vec2( 0.0, texel.y );
+
+    // Both sides of the edge are averaged, the search ends where the average leaves the local one
+    vec2 uv1 = texcoord - alongEdge;
+    vec2 uv2 = texcoord + alongEdge;
+
+    float lumaEnd1 = 0.5 * ( lumaAt( uv1 ) + lumaAt( uv1 + acrossEdge ) ) - lumaLocalAverage;
+    float lumaEnd2 = 0.5 * ( lumaAt( uv2 ) + lumaAt( uv2 + acrossEdge ) ) - lumaLocalAverage;
+
+    bool reached1 = abs( lumaEnd1 ) >= gradientScaled;
+    bool reached2 = abs( lumaEnd2 ) >= gradientScaled;
+
+    for ( int i = 0; i < FXAA_SEARCH_STEPS && !( reached1 && reached2 ); ++i )
+    {
+        if ( !reached1 )
+        {
+            uv1 -= alongEdge * searchSteps[ i ];
+            lumaEnd1 = 0.5 * ( lumaAt( uv1 ) + lumaAt( uv1 + acrossEdge ) ) - lumaLocalAverage;
+            reached1 = abs( lumaEnd1 ) >= gradientScaled;
+        }
+
+        if ( !reached2 )
+        {
+            uv2 += alongEdge * searchSteps[ i ];
+            lumaEnd2 = 0.5 * ( lumaAt( uv2 ) + lumaAt( uv2 + acrossEdge ) ) - lumaLocalAverage;
+            reached2 = abs( lumaEnd2 ) >= gradientScaled;
+        }
+    }
+
+    float distance1 = isHorizontal ? texcoord.x - uv1.x : texcoord.y - uv1.y;
+    float distance2 = isHorizontal ? uv2.x - texcoord.x : uv2.y - texcoord.y;
+
+    bool isDirection1 = distance1 < distance2;
+    float pixelOffset = 0.5 - min( distance1, distance2 ) / ( distance1 + distance2 );
+
+    // Only the end whose luma variation agrees with the center blends, otherwise the pixel is outside the edge
+    bool isLumaCenterSmaller = lumaM < lumaLocalAverage;
+    bool correctVariation = ( ( isDirection1 ? lumaEnd1 : lumaEnd2 ) < 0.0 ) != isLumaCenterSmaller;
+    float finalOffset = correctVariation ? pixelOffset : 0.0;
+
+    // Sub pixel aliasing, thin features get blended even without a long edge
+    float lumaAverage = ( 1.0 / 12.0 ) * ( 2.0 * ( lumaNS + lumaWE ) + lumaWCorners + lumaECorners );
+    float subPixelOffset1 = clamp( abs( lumaAverage - lumaM ) / lumaRange, 0.0, 1.0 );
+    float subPixelOffset2 = ( -2.0 * subPixelOffset1 + 3.0 ) * subPixelOffset1 * subPixelOffset1;
+    finalOffset = max( finalOffset, subPixelOffset2 * subPixelOffset2 * FXAA_SUBPIXEL_QUALITY );
+
+    vec4 across = textureLod( litScene, texcoord + acrossEdge, 0.0 );
+
+    // The alpha marks pixels without geometry for the present pass, it is kept as is
+    outColor = vec4( mix( center.rgb, across.rgb, finalOffset ), center.a );
+}
@@ -10,7 +10,7 @@ layout(set = 2, binding = 0) uniform Material {
     uint hasHeightMap;
 } mat;
 
-layout(set = 3, binding = 0) uniform sampler2D Texture1;
+layout(set = 2, binding = 1) uniform sampler2D Texture1;
 
 layout (location = 0) in vec4 inPosition;
 layout (location = 1) in vec4 inNormal;
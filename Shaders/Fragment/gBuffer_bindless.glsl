@@ -0,0 +1,36 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 2, binding = 0) uniform Material {
+    vec4 diffuseColor;
+    vec4 specularColor;
+    vec4 textureScale;
+
+    float shininess;
+    uint hasHeightMap;
+} mat;
+
+// Shared by every draw of the pass, textures are selected through TextureIndices
+layout(set = 1, binding = 0) uniform sampler2D BindlessTextures[];
+
+// Placed after the vertex stage's per object matrices
+layout(push_constant) uniform TextureIndices {
+    layout(offset = 128) uint Texture1;
+} textureIndices;
+
+layout (location = 0) in vec4 inPosition;
+layout (location = 1) in vec4 inNormal;
+layout (location = 2) in vec2 inTextureCoor;
+
+layout (location = 0) out vec4 gBuffer_Position;
+layout (location = 1) out vec4 gBuffer_Normal;
+layout (location = 2) out vec4 gBuffer_Albedo;
+layout (location = 3) out vec4 gBuffer_Material;
+
+void main() {
+    gBuffer_Position = inPosition;
+    gBuffer_Normal = inNormal;
+    gBuffer_Albedo = texture( BindlessTextures[ textureIndices.Texture1 ], inTextureCoor * mat.textureScale.xz );
+    gBuffer_Material = vec4( mat.shininess );
+}
@@ -0,0 +1,30 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#include "frag_utilities.glsl"
+
+layout(set = 2, binding = 0) uniform Material {
+    vec4 diffuseColor;
+    vec4 specularColor;
+    vec4 textureScale;
+
+    float shininess;
+    uint hasHeightMap;
+} mat;
+
+layout(set = 2, binding = 1) uniform sampler2D Texture1;
+
+layout (location = 0) in vec4 inPosition;
+layout (location = 1) in vec4 inNormal;
+layout (location = 2) in vec2 inTextureCoor;
+
+// Positions are reconstructed from the depth buffer, normals are octahedral encoded
+layout (location = 0) out vec2 gBuffer_Normal;
+layout (location = 1) out vec4 gBuffer_Albedo;
+layout (location = 2) out vec4 gBuffer_Material;
+
+void main() {
+    gBuffer_Normal = encodeNormal( normalize( inNormal.xyz ) );
+    gBuffer_Albedo = texture( Texture1, inTextureCoor * mat.textureScale.xz );
+    gBuffer_Material = vec4( mat.shininess, 0.0, 0.0, 0.0 );
+}
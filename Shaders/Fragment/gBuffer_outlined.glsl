@@ -10,9 +10,9 @@ layout(set = 2, binding = 0) uniform Material {
     uint hasHeightMap;
 } mat;
 
-layout(set = 3, binding = 0) uniform sampler2D Texture1;
+layout(set = 2, binding = 1) uniform sampler2D Texture1;
 
-layout(set = 5, binding = 0) uniform OutlineColor {
+layout(set = 3, binding = 2) uniform OutlineColor {
     vec4 rgba;
 } outlineColor;
 
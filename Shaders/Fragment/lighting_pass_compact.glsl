@@ -0,0 +1,4 @@
+#version 450
+
+#define COMPACT_GBUFFER
+#include "lighting_pass_common.glsl"
@@ -1,7 +1,7 @@
 #version 450
 
-layout(set = 0, binding = 0) uniform sampler2D litScene;
-layout(set = 1, binding = 0) uniform sampler2D skyBoxTex;
+layout(set = 1, binding = 0) uniform sampler2D litScene;
+layout(set = 1, binding = 1) uniform sampler2D skyBoxTex;
 
 layout (location = 0) in vec4 inPosition;
 
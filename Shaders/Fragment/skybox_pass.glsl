@@ -2,7 +2,7 @@
 
 #include "frag_utilities.glsl"
 
-layout( set = 1, binding = 0 ) uniform samplerCube SkyBox;
+layout( set = 0, binding = 1 ) uniform samplerCube SkyBox;
 
 layout (location = 0) in vec4 transitPosition;
 
@@ -33,8 +33,8 @@ layout (set = 0, binding = 0) uniform Resolution
 } resolution;
 
 layout(set = 1, binding = 0) uniform sampler2D edgesTex;
-layout(set = 2, binding = 0) uniform sampler2D areaTex;
-layout(set = 3, binding = 0) uniform sampler2D searchTex;
+layout(set = 1, binding = 1) uniform sampler2D areaTex;
+layout(set = 1, binding = 2) uniform sampler2D searchTex;
 
 layout (location = 0) in vec2 texcoord;
 layout (location = 1) in vec2 pixcoord;
@@ -38,7 +38,7 @@ layout (location = 1) in vec4 offset0;
 layout (location = 2) in vec4 offset1;
 layout (location = 3) in vec4 offset2;
 
-layout (location = 0) out vec4 edgesTex;
+layout (location = 0) out vec2 edgesTex;
 
 void main(void)
 {
@@ -49,5 +49,5 @@ void main(void)
     offsets[1] = offset1;
     offsets[2] = offset2;
 
-    edgesTex = vec4(SMAALumaEdgeDetectionPS(texcoord, offsets, litScene), 0.0, 0.0);
+    edgesTex = SMAALumaEdgeDetectionPS(texcoord, offsets, litScene);
 }
@@ -33,7 +33,7 @@ layout (set = 0, binding = 0) uniform Resolution
 } resolution;
 
 layout(set = 1, binding = 0) uniform sampler2D litScene;
-layout(set = 2, binding = 0) uniform sampler2D blendTex;
+layout(set = 1, binding = 1) uniform sampler2D blendTex;
 
 layout (location = 0) in vec2 texcoord;
 layout (location = 1) in vec4 offset;
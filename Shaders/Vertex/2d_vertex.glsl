@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout(set = 0, binding = 0) uniform ViewProjection {
     mat4 view;
@@ -9,10 +10,9 @@ layout(push_constant) uniform PushConstants {
     mat4 ModelMatrix;
 } pushConstants;
 
-layout(set = 1, binding = 0) uniform InstanceData
+layout(std430, set = 3, binding = 0) readonly buffer InstanceData
 {
-    mat4 model[ 100 ];
-    uint instanceCount;
+    mat4 model[];
 } instanceData;
 
 layout(location = 0) in vec4 inPosition;
@@ -24,7 +24,8 @@ layout (location = 1) out vec2 outTextureCoor;
 void main() {
     mat4 model = pushConstants.ModelMatrix;
 
-    if ( instanceData.instanceCount > 0 && gl_InstanceIndex > 0 )
+    // The draw starts at its range in the instance pool, its first instance is the entity itself
+    if ( gl_InstanceIndex > gl_BaseInstanceARB )
     {
         model = instanceData.model[ gl_InstanceIndex - 1 ];
     }
@@ -0,0 +1,13 @@
+#version 450 core
+
+#include "utilities.glsl"
+
+layout (location = 0) out vec2 texcoord;
+
+void main(void)
+{
+    vec2 pos_n_texCoord[ 2 ] = getOverSizedTriangle( gl_VertexIndex );
+    texcoord = pos_n_texCoord[ 1 ];
+
+    gl_Position = vec4(pos_n_texCoord[ 0 ], 0.0, 1.0);
+}
@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout(set = 0, binding = 0) uniform ViewProjection {
     mat4 view;
@@ -10,10 +11,9 @@ layout(push_constant) uniform PushConstants {
     mat4 NormalModelMatrix;
 } pushConstants;
 
-layout(set = 1, binding = 0) uniform InstanceData
+layout(std430, set = 3, binding = 0) readonly buffer InstanceData
 {
-    mat4 model[ 100 ];
-    uint instanceCount;
+    mat4 model[];
 } instanceData;
 
 layout(location = 0) in vec4 inPosition;
@@ -26,10 +26,13 @@ layout (location = 2) out vec2 outTextureCoor;
 
 void main() {
     mat4 model = pushConstants.ModelMatrix;
+    mat3 normalMatrix = mat3(pushConstants.NormalModelMatrix);
 
-    if ( instanceData.instanceCount > 0 && gl_InstanceIndex > 0 )
+    // The draw starts at its range in the instance pool, its first instance is the entity itself
+    if ( gl_InstanceIndex > gl_BaseInstanceARB )
     {
         model = instanceData.model[ gl_InstanceIndex - 1 ];
+        normalMatrix = transpose(inverse(mat3(model)));
     }
 
     outPosition = model * inPosition;
@@ -37,5 +40,5 @@ void main() {
     gl_Position = viewProjection.proj * viewProjection.view * outPosition;
 
     outTextureCoor = inTextureCoor;
-    outNormal = vec4(normalize(mat3(pushConstants.NormalModelMatrix) * vec3(inNormal)), 0.0f);
+    outNormal = vec4(normalize(normalMatrix * vec3(inNormal)), 0.0f);
 }
@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout(set = 0, binding = 0) uniform ViewProjection {
     mat4 view;
@@ -10,13 +11,12 @@ layout(push_constant) uniform PushConstants {
     mat4 NormalModelMatrix;
 } pushConstants;
 
-layout(set = 1, binding = 0) uniform InstanceData
+layout(std430, set = 3, binding = 0) readonly buffer InstanceData
 {
-    mat4 model[ 100 ];
-    uint instanceCount;
+    mat4 model[];
 } instanceData;
 
-layout(set = 4, binding = 0) uniform OutlineScale {
+layout(set = 3, binding = 1) uniform OutlineScale {
     vec4 dim;
 } outlineScale;
 
@@ -35,7 +35,8 @@ void main() {
     model[1][1] *= outlineScale.dim.y;
     model[2][2] *= outlineScale.dim.z;
 
-    if ( instanceData.instanceCount > 0 && gl_InstanceIndex > 0 )
+    // The draw starts at its range in the instance pool, its first instance is the entity itself
+    if ( gl_InstanceIndex > gl_BaseInstanceARB )
     {
         model = instanceData.model[ gl_InstanceIndex - 1 ];
     }
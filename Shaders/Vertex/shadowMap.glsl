@@ -1,4 +1,5 @@
 #version 450
+#extension GL_ARB_shader_draw_parameters : require
 
 #define MAX_ALLOWED_SHADOW_CASTERS 3
 
@@ -11,10 +12,9 @@ layout(set = 0, binding = 0) uniform LightViewProjectionMatrix {
     int arraySize;
 } lvpm;
 
-layout(set = 1, binding = 0) uniform InstanceData
+layout(std430, set = 3, binding = 0) readonly buffer InstanceData
 {
-    mat4 model[ 100 ];
-    uint instanceCount;
+    mat4 model[];
 } instanceData;
 
 layout(location = 0) in vec4 inPosition;
@@ -24,7 +24,8 @@ layout(location = 2) in vec2 inTextureCoor;
 void main() {
     mat4 model = pushConstants.ModelMatrix;
 
-    if ( instanceData.instanceCount > 0 && gl_InstanceIndex > 0 )
+    // The draw starts at its range in the instance pool, its first instance is the entity itself
+    if ( gl_InstanceIndex > gl_BaseInstanceARB )
     {
         model = instanceData.model[ gl_InstanceIndex - 1 ];
     }
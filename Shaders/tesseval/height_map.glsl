@@ -12,7 +12,7 @@ layout(set = 2, binding = 0) uniform Material {
     uint hasHeightMap;
 } mat;
 
-layout(set = 4, binding = 0) uniform sampler2D HeightMap;
+layout(set = 2, binding = 2) uniform sampler2D HeightMap;
 
 layout(location = 0) in vec4 inPosition[];
 layout(location = 1) in vec4 inNormal[];
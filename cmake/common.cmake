@@ -24,6 +24,69 @@ FUNCTION(copy_to_binary Dir FileSelect)
     ENDFOREACH()
 ENDFUNCTION()
 
+# Compiles every shader with a #version directive under Dir to Dir/SPIRV/<stage directory>/<name>.spv in the binary directory,
+# its reflection is written next to it as <name>.refl by the BlazarShaderReflect target
+FUNCTION(compile_shaders Target Dir)
+    FIND_PROGRAM(GLSLC_EXECUTABLE glslc HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin")
+
+    IF (NOT GLSLC_EXECUTABLE)
+        MESSAGE(FATAL_ERROR "glslc is required to compile the shaders, set BLAZAR_COMPILE_SHADERS to OFF to compile them at runtime.")
+    ENDIF()
+
+    FILE(GLOB_RECURSE ShaderFiles "${PROJECT_SOURCE_DIR}/${Dir}/*.glsl")
+    SET(ShaderOutputs)
+
+    FOREACH(File IN LISTS ShaderFiles)
+        # Files without a #version directive are only included by other shaders, even when they hold the entry point
+        FILE(STRINGS ${File} VersionDirective REGEX "^[ \t]*#[ \t]*version")
+        IF (NOT VersionDirective)
+            CONTINUE()
+        ENDIF()
+
+        GET_FILENAME_COMPONENT(StageDir ${File} DIRECTORY)
+        GET_FILENAME_COMPONENT(StageDir ${StageDir} NAME)
+        GET_FILENAME_COMPONENT(ShaderName ${File} NAME_WE)
+
+        IF (StageDir STREQUAL "Vertex")
+            SET(Stage vert)
+        ELSEIF (StageDir STREQUAL "Fragment")
+            SET(Stage frag)
+        ELSEIF (StageDir STREQUAL "tesscontrol")
+            SET(Stage tesc)
+        ELSEIF (StageDir STREQUAL "tesseval")
+            SET(Stage tese)
+        ELSEIF (StageDir STREQUAL "Compute")
+            SET(Stage comp)
+        ELSE()
+            MESSAGE(FATAL_ERROR "No shader stage is known for the ${Dir}/${StageDir} directory.")
+        ENDIF()
+
+        SET(OutputDir "${PROJECT_BINARY_DIR}/${Dir}/SPIRV/${StageDir}")
+        SET(Output "${OutputDir}/${ShaderName}.spv")
+        SET(Reflection "${OutputDir}/${ShaderName}.refl")
+
+        ADD_CUSTOM_COMMAND(
+                OUTPUT ${Output}
+                COMMAND ${CMAKE_COMMAND} -E make_directory ${OutputDir}
+                COMMAND ${GLSLC_EXECUTABLE} -fshader-stage=${Stage} --target-env=vulkan1.1 -MD -MF ${Output}.d -o ${Output} ${File}
+                MAIN_DEPENDENCY ${File}
+                DEPFILE ${Output}.d
+                COMMENT "Compiling ${Dir}/${StageDir}/${ShaderName}.glsl"
+        )
+
+        ADD_CUSTOM_COMMAND(
+                OUTPUT ${Reflection}
+                COMMAND BlazarShaderReflect ${Stage} ${Output} ${Reflection}
+                DEPENDS ${Output} BlazarShaderReflect
+                COMMENT "Reflecting ${Dir}/${StageDir}/${ShaderName}.spv"
+        )
+
+        LIST(APPEND ShaderOutputs ${Output} ${Reflection})
+    ENDFOREACH()
+
+    ADD_CUSTOM_TARGET(${Target} ALL DEPENDS ${ShaderOutputs})
+ENDFUNCTION()
+
 FUNCTION(INSTALL_TARGET target)
     IF (BLAZAR_INSTALL_LIBS)
         INSTALL(TARGETS ${target}